@@ -22,17 +22,113 @@
 #include <SDL3/SDL.h>
 #include <box2d/box2d.h>
 #include <stdbool.h>
+#include <stdio.h>
 
+#include "boot/pacer.h"
+#include "boot/substep.h"
+#include "en/gamepad.h"
+#include "en/ground.h"
+#include "en/stress.h"
 #include "en/player.h"
+#include "en/snapshot.h"
+#include "en/sprite.h"
 #include "en/testobj.h"
+#include "debug/latency.h"
 #include "heap/allocator.h"
 #include "input/controller.h"
+#include "input/analog.h"
+#include "input/manager.h"
+#include "input/remap.h"
+#include "input/replay.h"
+#include "level/level.h"
+#include "net/netplay.h"
+#include "screen/atlas.h"
+#include "screen/layer.h"
+#include "screen/render_list.h"
+#include "util/jobs.h"
 
 typedef struct AppOptions {
   bool vsync;
   bool frame_cap;
+  // Only draw when something changed
+  bool idle_render;
+  double target_fps;
+  // Virtual pads to create, one per player. The keyboard drives the first,
+  // gamepad players the rest. Set with `--pads`, or to the netplay players
+  size_t controller_count;
+  // Core the controller output thread is pinned to, -1 for none
+  int controller_cpu;
+  // Run the output thread at realtime priority. Never started when headless
+  bool controller_realtime;
+  // Replays run the fixed update as fast as it goes, as a benchmark
+  bool replay_unpaced;
+  // No window, no uinput devices and no output thread, the ticks are driven
+  // by hand
+  bool headless;
+  // Built into the world next to the level, `scene_scale` times its size
+  enum StressScene scene;
+  float scene_scale;
+  // Binary level to load in place of the built in ground, NULL for none
+  const char *level_path;
+  // Where ticks are profiled to as CSV, NULL for nowhere
+  const char *profile_path;
+  // Bounds for the adaptive substep count. Equal bounds fix it
+  int min_substeps;
+  int max_substeps;
+  // Worlds that get rolled back have to step the same after a restore.
+  // Snapshots don't hold contact impulses or sleep timers, so warm starting
+  // and sleeping are turned off
+  bool rollback;
 } AppOptions;
 
+AppOptions AppOptions_default();
+
+// Parts of a tick, timed by `AppState_tick`
+enum AppPhase {
+  APP_PHASE_INPUT,
+  APP_PHASE_PHYSICS,
+  APP_PHASE_SYNC,
+  APP_PHASE_UPDATE,
+  APP_PHASE_PADS,
+  APP_PHASE_COUNT,
+};
+
+#define APP_PHASE_NAMES {"input", "physics", "sync", "update", "pads"}
+
+// Box2D's own breakdown of `APP_PHASE_PHYSICS`, from `b2Profile`
+enum AppWorldPhase {
+  APP_WORLD_PAIRS,
+  APP_WORLD_COLLIDE,
+  APP_WORLD_SOLVE,
+  APP_WORLD_CONTINUOUS,
+  APP_WORLD_SENSORS,
+  APP_WORLD_COUNT,
+};
+
+#define APP_WORLD_PHASE_NAMES                                                  \
+  {"pairs", "collide", "solve", "continuous", "sensors"}
+
+typedef struct AppTickProfile {
+  Uint64 ticks;
+  Uint64 phase_ns[APP_PHASE_COUNT];
+  double world_ms[APP_WORLD_COUNT];
+  // The last tick on its own
+  Uint64 tick_ns[APP_PHASE_COUNT];
+  float tick_world_ms[APP_WORLD_COUNT];
+  int tick_substeps;
+
+  // Every tick is added as a row when set
+  FILE *csv;
+  const char *scene;
+} AppTickProfile;
+
+// Opens `path` for per-tick rows when it isn't NULL
+bool AppTickProfile_openCsv(AppTickProfile *self, const char *path,
+                            const char *scene);
+void AppTickProfile_closeCsv(AppTickProfile *self);
+// Ticks per second and each phase's share, over `seconds` of wall time
+void AppTickProfile_log(const AppTickProfile *self, double seconds);
+
 typedef struct AppState {
   double delta_time;
   double last_tick;
@@ -43,17 +139,103 @@ typedef struct AppState {
   Allocator *allocator;
 
   AppOptions options;
+  FramePacer pacer;
+  // Owned by the fixed update
+  SubstepController substeps;
+  // Set by input events so idle mode knows to draw the next frame
+  bool input_pending;
   Player player;
   Object2D *testobj;
-  ControllerDevice controller_out;
+  // Drawn over the player once `player_image` is packed into the atlas
+  Sprite *player_sprite;
+  AtlasRegionId player_image;
+  // Root of the static level geometry, drawn through `static_layer`
+  Object2D *level;
+  // Either the built in ground or a level file and what it built
+  Ground *ground;
+  Level *level_file;
+  LevelObject *level_object;
+  // Gamepad players, fed by events on the main thread
+  GamepadRoster gamepads;
+  ControllerManager *controllers;
+  // Deadzones, curves and smoothing for both sticks of every pad
+  AnalogStage analog;
+  // Turns each player's input into their pad. Evaluated by the fixed update,
+  // rebindable from anywhere
+  RemapEngine remap;
+  // What the game wants each pad to look like, and what was last handed to
+  // the output thread
+  ControllerState pads[CONTROLLER_MAX_PADS];
+  ControllerState pads_submitted[CONTROLLER_MAX_PADS];
+
+  // Every tick's input goes to the recorder, or comes from the replay
+  // instead of the controllers. Both belong to the fixed update
+  InputRecorder *recorder;
+  InputReplay *replay;
+  // Set for a networked game, which then drives every player. The local
+  // player's input is published to `netplay_input` instead. Both belong to
+  // the fixed update once started
+  NetplaySession *netplay;
+  PlayerController *netplay_input;
+
+  // Input to uinput latency. The probe is fed by events on the main thread
+  // and sampled by the fixed update
+  LatencyProbe latency_probe;
+  LatencyRecorder latency;
 
   SDL_Thread *fixedUpdate_thread;
   SDL_Mutex* fixedUpdate_mutex;
 
+  // Everything a snapshot captures, and the state the world started in.
+  // Set from any thread, the reset happens at the start of the next tick
+  SnapshotLayout snapshot;
+  Uint8 *initial_snapshot;
+  SDL_AtomicInt reset_pending;
+
+  // Worker threads shared by systems that can split their work
+  JobPool *jobs;
+  RenderList render_list;
+  // Images are queued during init and packed once the renderer exists
+  TextureAtlas atlas;
+  CachedLayer static_layer;
+
   b2WorldId world;
 } AppState;
 
+// NULL if `options.level_path` couldn't be loaded
+AppState *AppState_create(Allocator *allocator, AppOptions options);
 AppState *AppState_default(Allocator *allocator);
 void AppState_destroy(AppState *self);
+/** \brief Runs one fixed update
+ *
+ * Steps the world, updates the player and hands the pads to the output
+ * thread. Returns false without doing anything once a replay has ended or a
+ * netplay peer has gone quiet. During netplay the tick first replays frames
+ * that were mispredicted, and skips the step when it has to wait for the
+ * others. `profile` may be NULL.
+ */
+bool AppState_tick(AppState *self, AppTickProfile *profile);
+
+/** \brief Bytes `AppState_save` writes
+ *
+ * Fixed for the life of the state. Buffers have to be 4 byte aligned.
+ */
+size_t AppState_snapshotSize(const AppState *self);
+/** \brief Captures every moving body, every object and the analog
+ * smoothing, which is all the fixed update carries from one tick to the next
+ */
+void AppState_save(const AppState *self, Uint8 *buffer);
+// False, with nothing changed, if `buffer` isn't from this state
+bool AppState_restore(AppState *self, const Uint8 *buffer);
+// Puts everything back how it was created, at the start of the next tick.
+// Ignored during netplay
+void AppState_requestReset(AppState *self);
+/** \brief Hands every player over to `session` from the next tick on
+ *
+ * Takes `session` and `input`. Needs `options.rollback` and one pad per
+ * player. Call before the fixed update starts.
+ */
+void AppState_startNetplay(AppState *self, NetplaySession *session,
+                           PlayerController *input);
 
 #endif // APP_H
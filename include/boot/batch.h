@@ -0,0 +1,79 @@
+/*
+    Batch World Simulation Structure
+    Copyright (C) 2025  Ashton Warner
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <SDL3/SDL.h>
+#include <box2d/box2d.h>
+#include <stdbool.h>
+
+#include "en/stress.h"
+#include "heap/allocator.h"
+#include "util/jobs.h"
+
+// Box2D keeps every world in a fixed table, so batches are run in waves
+#define BATCH_WAVE_SIZE 64
+#define BATCH_TICK_RATE 60
+
+typedef struct BatchWorldDef {
+  enum StressScene scene;
+  float scene_scale;
+  // Recorded input for the player, NULL to leave it idle. The player stands
+  // still once it runs out
+  const char *script;
+  Uint64 ticks;
+  int substeps;
+} BatchWorldDef;
+
+BatchWorldDef BatchWorldDef_default();
+
+typedef struct BatchWorldResult {
+  bool failed;
+  Uint64 ticks;
+  // Wall time spent stepping this world
+  double seconds;
+  b2Vec2 player_position;
+  int body_count;
+  int contact_count;
+} BatchWorldResult;
+
+typedef struct BatchResult {
+  size_t worlds;
+  size_t failed;
+  Uint64 ticks;
+  double simulated_seconds;
+  // Building and tearing down worlds isn't counted
+  double wall_seconds;
+  double setup_seconds;
+  // Simulated seconds per wall second, across every world
+  double throughput;
+  double slowest_world_seconds;
+} BatchResult;
+
+/** \brief Steps independent headless worlds concurrently
+ *
+ * Each world gets the default level and its def's scene and script. Worlds
+ * are built and destroyed on the calling thread and stepped on `pool`, one job
+ * per world. `results` may be NULL, otherwise it gets one entry per def.
+ */
+BatchResult BatchSim_run(JobPool *pool, Allocator *allocator,
+                         const BatchWorldDef *defs, size_t count,
+                         BatchWorldResult *results);
+
+#endif // BATCH_H
@@ -0,0 +1,76 @@
+/*
+    Netplay Loopback Test Structure
+    Copyright (C) 2025  Ashton Warner
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef LOOPBACK_H
+#define LOOPBACK_H
+
+#include <SDL3/SDL.h>
+#include <stdbool.h>
+
+#include "boot/app.h"
+#include "net/netplay.h"
+#include "net/socket.h"
+
+// Idle rounds after the scripted ones so the last inputs arrive everywhere
+#define LOOPBACK_DRAIN_TICKS 120
+
+typedef struct LoopbackDef {
+  size_t players;
+  // Rounds of scripted input. Every player ticks once a round
+  Uint64 ticks;
+  // For every player's world. Made headless with rollback on
+  AppOptions options;
+  Uint32 input_delay;
+  NetConditions conditions;
+  // Picks the scripted input and which packets are lost
+  Uint64 seed;
+  // Rounds each player starts after the one before, so they begin out of step
+  Uint32 stagger;
+} LoopbackDef;
+
+LoopbackDef LoopbackDef_default();
+
+typedef struct LoopbackResult {
+  bool failed;
+  size_t players;
+  // Rounds run, and the frames every player has every input for
+  Uint64 ticks;
+  Uint32 confirmed;
+  // Checksummed frames every player took, and how many of those disagree
+  size_t compared;
+  size_t mismatched;
+  // Every player's world is identical at `converged_frame`
+  bool converged;
+  Uint32 converged_frame;
+  double wall_seconds;
+  double simulated_seconds;
+  NetplayStats stats[NETPLAY_MAX_PLAYERS];
+  // Each player's average tick, rollbacks included
+  double tick_us[NETPLAY_MAX_PLAYERS];
+} LoopbackResult;
+
+/** \brief Plays a networked game against itself over 127.0.0.1
+ *
+ * Every player gets a headless world, a real UDP socket and a session. They
+ * take turns ticking on the calling thread against a shared clock that moves
+ * one tick a round, so latency and loss play out the same however fast the
+ * machine is. Input is scripted, a random direction held for a while.
+ */
+LoopbackResult Loopback_run(const LoopbackDef *def);
+
+#endif // LOOPBACK_H
@@ -0,0 +1,76 @@
+/*
+    Frame Pacing Structure
+    Copyright (C) 2025  Ashton Warner
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef PACER_H
+#define PACER_H
+
+#include <SDL3/SDL.h>
+#include <stdbool.h>
+
+// Sleeping is only accurate to about a millisecond, so the end of every wait
+// is spent spinning
+#define FRAME_PACER_SPIN_NS (SDL_NS_PER_MS * 2)
+// Idle mode still presents this often so the window never looks frozen
+#define FRAME_PACER_IDLE_NS (SDL_NS_PER_SECOND / 2)
+#define FRAME_PACER_STATS_WINDOW 120
+
+typedef struct FramePacerStats {
+  Uint64 frames;
+  Uint64 skipped_frames;
+  Uint64 missed_deadlines;
+
+  // Present to present intervals in nanoseconds
+  Uint64 last_interval;
+  double average_interval;
+  // Extremes over the last FRAME_PACER_STATS_WINDOW frames
+  Uint64 min_interval;
+  Uint64 max_interval;
+} FramePacerStats;
+
+typedef struct FramePacer {
+  // 0 runs uncapped
+  Uint64 target_ns;
+  Uint64 spin_ns;
+  Uint64 idle_ns;
+  bool idle_mode;
+
+  Uint64 deadline;
+  Uint64 last_present;
+  Uint64 window_frames;
+  Uint64 window_min;
+  Uint64 window_max;
+
+  FramePacerStats stats;
+} FramePacer;
+
+FramePacer FramePacer_create(double target_fps);
+void FramePacer_setTargetFps(FramePacer *self, double target_fps);
+
+/** \brief Decide whether this iteration should draw a frame
+ *
+ * Always true unless idle mode is on. In idle mode a frame is only drawn when
+ * something changed, or to keep presenting every `idle_ns`.
+ */
+bool FramePacer_shouldRender(FramePacer *self, bool changed);
+/** \brief Block until the next frame deadline. Call right before presenting */
+void FramePacer_wait(FramePacer *self);
+/** \brief Sleep through a skipped frame so idle iterations don't spin */
+void FramePacer_skip(FramePacer *self);
+void FramePacer_markPresent(FramePacer *self);
+
+#endif // PACER_H
@@ -0,0 +1,53 @@
+/*
+    Startup Timing Structure
+    Copyright (C) 2025  Ashton Warner
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef STARTUP_H
+#define STARTUP_H
+
+#include <SDL3/SDL.h>
+#include <stdbool.h>
+
+#define STARTUP_MAX_PHASES 16
+
+typedef struct StartupPhase {
+  const char *name;
+  // SDL_GetTicksNS() when the phase ended
+  Uint64 end;
+} StartupPhase;
+
+/** \brief Ordered record of how long each part of startup took
+ *
+ * Phases can end on any thread, e.g. devices created in the background.
+ */
+typedef struct StartupProfile {
+  SDL_SpinLock lock;
+  Uint64 start;
+  size_t count;
+  // Phases already written by `StartupProfile_log`
+  size_t logged;
+  StartupPhase phases[STARTUP_MAX_PHASES];
+} StartupProfile;
+
+StartupProfile StartupProfile_create();
+void StartupProfile_mark(StartupProfile *self, const char *name);
+void StartupProfile_markAt(StartupProfile *self, const char *name,
+                           Uint64 timestamp);
+// Logs every phase that ended since the last call
+void StartupProfile_log(StartupProfile *self);
+
+#endif // STARTUP_H
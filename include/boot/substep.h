@@ -0,0 +1,76 @@
+/*
+    Adaptive Physics Substepping Structure
+    Copyright (C) 2025  Ashton Warner
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef SUBSTEP_H
+#define SUBSTEP_H
+
+#include <SDL3/SDL.h>
+#include <stdbool.h>
+
+#define SUBSTEP_DEFAULT_MIN 2
+#define SUBSTEP_DEFAULT_MAX 8
+#define SUBSTEP_DEFAULT_START 4
+// Shares of the tick budget the world step may use. Above the high water
+// substeps are dropped, one more is only added if it would stay under the low
+// water. The gap keeps the count from flapping
+#define SUBSTEP_HIGH_WATER 0.5
+#define SUBSTEP_LOW_WATER 0.3
+// Ticks a change has to be called for in a row before it is made
+#define SUBSTEP_HOLD_TICKS 30
+
+typedef struct SubstepStats {
+  Uint64 ticks;
+  // Ticks whose work took longer than the budget
+  Uint64 overruns;
+  Uint64 raised;
+  Uint64 lowered;
+  // World step time, smoothed, and the longest one
+  double average_step_ns;
+  Uint64 max_step_ns;
+} SubstepStats;
+
+/** \brief Picks the substep count from how long the world takes to step
+ *
+ * Accuracy is bought with headroom and given back under load, within
+ * [min, max]. An overrun drops a substep straight away.
+ */
+typedef struct SubstepController {
+  int min;
+  int max;
+  int substeps;
+  Uint64 budget_ns;
+
+  // Ticks in a row that asked to raise or lower
+  int raise_ticks;
+  int lower_ticks;
+
+  SubstepStats stats;
+} SubstepController;
+
+SubstepController SubstepController_create(double tick_rate, int min, int max);
+// Stops adapting, e.g. while input is recorded so replays step the same
+void SubstepController_pin(SubstepController *self, int substeps);
+/** \brief Feed one tick's timings back
+ *
+ * `step_ns` is the world step alone and `tick_ns` all of the tick's work,
+ * not counting the sleep after it.
+ */
+void SubstepController_update(SubstepController *self, Uint64 step_ns,
+                              Uint64 tick_ns);
+
+#endif // SUBSTEP_H
@@ -0,0 +1,96 @@
+/*
+    Input Latency Instrumentation Structure
+    Copyright (C) 2025  Ashton Warner
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef LATENCY_H
+#define LATENCY_H
+
+#include <SDL3/SDL.h>
+#include <stdbool.h>
+
+/** \brief Points an input passes on its way to `/dev/uinput` */
+enum LatencyStage {
+  // SDL event timestamp of the key press
+  LATENCY_EVENT,
+  // The fixed update picked the input up
+  LATENCY_SAMPLE,
+  // The tick that used it finished
+  LATENCY_TICK,
+  // The resulting pad state was handed to the output thread
+  LATENCY_REPORT,
+  // The report was written to the device
+  LATENCY_WRITE,
+  LATENCY_STAGE_COUNT,
+};
+
+extern const char *LATENCY_STAGE_NAMES[LATENCY_STAGE_COUNT];
+
+/** \brief Timestamps in SDL_GetTicksNS() time. 0 means not reached */
+typedef struct LatencyTrace {
+  Uint64 stamps[LATENCY_STAGE_COUNT];
+} LatencyTrace;
+
+#define LatencyTrace_active(SELF) ((SELF)->stamps[LATENCY_EVENT] != 0)
+#define LatencyTrace_mark(SELF, STAGE)                                         \
+  ((SELF)->stamps[STAGE] = SDL_GetTicksNS())
+
+/** \brief Remembers the oldest input event nobody has sampled yet */
+typedef struct LatencyProbe {
+  SDL_SpinLock lock;
+  Uint64 pending;
+} LatencyProbe;
+
+LatencyProbe LatencyProbe_create();
+void LatencyProbe_markEvent(LatencyProbe *self, Uint64 timestamp);
+// Takes the pending event, if any, and starts a trace for it
+LatencyTrace LatencyProbe_sample(LatencyProbe *self);
+
+// Log-linear buckets in microseconds. Values under 16us are exact, larger ones
+// are within 1/16th of their size
+#define LATENCY_SUB_BUCKETS 16
+#define LATENCY_BUCKETS (LATENCY_SUB_BUCKETS * 28)
+
+typedef struct LatencyHistogram {
+  SDL_AtomicInt buckets[LATENCY_BUCKETS];
+  SDL_AtomicInt count;
+  SDL_AtomicInt max_us;
+} LatencyHistogram;
+
+typedef struct LatencySummary {
+  int count;
+  Uint64 p50_us;
+  Uint64 p99_us;
+  Uint64 max_us;
+} LatencySummary;
+
+/** \brief Histograms of the time from the input event to each later stage
+ *
+ * Traces are recorded from whichever thread finishes them, so every counter
+ * is atomic and summaries can be read at any time.
+ */
+typedef struct LatencyRecorder {
+  LatencyHistogram stages[LATENCY_STAGE_COUNT];
+} LatencyRecorder;
+
+void LatencyRecorder_reset(LatencyRecorder *self);
+void LatencyRecorder_record(LatencyRecorder *self, const LatencyTrace *trace);
+LatencySummary LatencyRecorder_summarize(LatencyRecorder *self,
+                                         enum LatencyStage stage);
+// Writes the summaries and every non empty bucket as CSV
+bool LatencyRecorder_export(LatencyRecorder *self, const char *path);
+
+#endif // LATENCY_H
@@ -0,0 +1,75 @@
+/*
+    Gamepad Player Controls Structure
+    Copyright (C) 2025  Ashton Warner
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef GAMEPAD_H
+#define GAMEPAD_H
+
+#include <SDL3/SDL.h>
+#include <stdbool.h>
+
+#include "en/player.h"
+
+#define GAMEPAD_MAX_PLAYERS 8
+// Trigger travel that counts as a press
+#define GAMEPAD_TRIGGER_THRESHOLD 16384
+
+// Triggers are tracked as two extra buttons after SDL's own
+enum GamepadSource {
+  GAMEPAD_SOURCE_LEFT_TRIGGER = SDL_GAMEPAD_BUTTON_COUNT,
+  GAMEPAD_SOURCE_RIGHT_TRIGGER,
+  GAMEPAD_SOURCE_COUNT,
+};
+
+/** \brief One player's SDL gamepad
+ *
+ * Axis and button events are folded into `live` as they arrive, so sampling
+ * is a copy no matter how many pads are plugged in. The controller outlives
+ * the pad plugged into it, unplugging just releases everything.
+ */
+typedef struct GamepadController {
+  PlayerController super;
+
+  // NULL while nothing is plugged into this player
+  SDL_Gamepad *gamepad;
+  SDL_JoystickID id;
+
+  // Bit n is `enum GamepadSource` n
+  Uint32 held;
+  InputState live;
+} GamepadController;
+
+/** \brief Hands hot-plugged gamepads out to player slots
+ *
+ * Only driven by events on the main thread, devices are never rescanned.
+ * Each player's controller has a fixed address for the roster's lifetime.
+ */
+typedef struct GamepadRoster {
+  GamepadController players[GAMEPAD_MAX_PLAYERS];
+  size_t connected;
+} GamepadRoster;
+
+GamepadRoster GamepadRoster_create();
+void GamepadRoster_destroy(GamepadRoster *self);
+// Returns the player whose input changed, or -1 when the event isn't one of
+// ours. Publish that player's controller afterwards
+int GamepadRoster_handleEvent(GamepadRoster *self, const SDL_Event *event);
+PlayerController *GamepadRoster_getController(GamepadRoster *self,
+                                              size_t player);
+bool GamepadRoster_isConnected(const GamepadRoster *self, size_t player);
+
+#endif // GAMEPAD_H
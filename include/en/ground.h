@@ -0,0 +1,36 @@
+/*
+    Static Ground Object Structure
+    Copyright (C) 2025  Ashton Warner
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef GROUND_H
+#define GROUND_H
+
+#include <box2d/box2d.h>
+
+#include "en/obj.h"
+
+typedef struct Ground {
+  Object2D super;
+  b2BodyId body;
+  b2Segment segment;
+} Ground;
+
+Ground Ground_create(b2WorldId world, b2Segment segment);
+void Ground_destroy(Ground *self);
+void Ground_render(Ground *self, RenderContext *ctx);
+
+#endif // GROUND_H
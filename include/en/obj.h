@@ -31,6 +31,10 @@ typedef struct Object2D {
   SDL_FPoint pos;
   float width;
   float height;
+  Uint8 layer;
+  // Set when something in this subtree changed since it was last drawn.
+  // Marked by the fixed update and cleared by the frame
+  SDL_AtomicInt dirty;
 
   struct Object2D *parent;
   List children;
@@ -52,4 +56,23 @@ Object2D Object2D_default();
 Object2D Object2D_create(float x, float y, float width, float height);
 void Object2D_destroy(Object2D *self);
 void Object2D_addChild(Object2D *self, Object2D *child);
+
+void Object2D_markDirty(Object2D *self);
+// Clear before drawing, so anything marked while drawing is drawn next time
+void Object2D_clearDirty(Object2D *self);
+bool Object2D_isDirty(Object2D *self);
+void Object2D_setPosition(Object2D *self, SDL_FPoint pos);
+void Object2D_setSize(Object2D *self, float width, float height);
+void Object2D_setLayer(Object2D *self, Uint8 layer);
+
+/** \brief Returns whether any object was marked dirty since the last call
+ *
+ * Safe to call from a different thread than the one marking objects.
+ */
+bool Object2D_takeDamage(void);
+
+/** \brief Copy the transforms of every body that moved during the last step
+ * into the `Object2D` stored in its user data
+ */
+void Object2D_syncBodies(b2WorldId world);
 #endif // OBJ_H
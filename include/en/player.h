@@ -21,30 +21,31 @@
 
 #include "en/obj.h"
 #include "heap/allocator.h"
+#include "input/state.h"
 #include <box2d/box2d.h>
 
+/** \brief Source of a player's input
+ *
+ * The thread owning input calls `PlayerController_publish` to sample the
+ * controller into one `InputState`. The tick reads the newest snapshot once
+ * with `PlayerController_read`.
+ */
 typedef struct PlayerController {
-  float (*getAxisX)(struct PlayerController *);
-  float (*getAxisY)(struct PlayerController *);
-  float (*getAxisRX)(struct PlayerController *);
-  float (*getAxisRY)(struct PlayerController *);
-
-  int (*getHatX)(struct PlayerController *);
-  int (*getHatY)(struct PlayerController *);
-
-  bool (*getPrimaryButton)(struct PlayerController *);
-  bool (*getSecondaryButton)(struct PlayerController *);
-  bool (*getTertiaryButton)(struct PlayerController *);
-  bool (*getQuaternyButton)(struct PlayerController *);
-
-  bool (*getJump)(struct PlayerController *);
-  bool (*getAction)(struct PlayerController *);
-  bool (*getDismount)(struct PlayerController *);
-  bool (*getAttack)(struct PlayerController *);
-
+  void (*sample)(struct PlayerController *, InputState *state);
   void (*destroy)(struct PlayerController *);
+
+  InputChannel channel;
 } PlayerController;
 
+void PlayerController_publish(PlayerController *self);
+// Publishes a snapshot from somewhere else, e.g. a replay, instead of
+// sampling. Only one thread may publish to a controller
+void PlayerController_publishState(PlayerController *self,
+                                   const InputState *state);
+const InputState *PlayerController_read(PlayerController *self);
+// The snapshot the last `PlayerController_read` returned
+const InputState *PlayerController_current(const PlayerController *self);
+
 typedef struct KeyboardController {
 
   PlayerController super;
@@ -90,5 +91,7 @@ Player Player_create(b2WorldId world, float x, float y,
                      PlayerController *controller);
 void Player_destroy(Player *player);
 void Player_render(Player *self, RenderContext *ctx);
+// What the player looks like, drawn in code until there are image files
+SDL_Surface *Player_createImage(int width, int height);
 void Player_update(Player *self, double delta_time);
 #endif // PLAYER_H
@@ -0,0 +1,86 @@
+/*
+    World Snapshot Structure
+    Copyright (C) 2025  Ashton Warner
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <SDL3/SDL.h>
+#include <box2d/box2d.h>
+#include <stdbool.h>
+
+#include "en/obj.h"
+#include "heap/allocator.h"
+
+/*
+ * Snapshot layout, in host byte order since snapshots never leave the
+ * process that made them:
+ *
+ *   "CSNP" body_count:u32 object_count:u32
+ *   SnapshotBody[body_count]
+ *   SnapshotObject[object_count]
+ *   awake bits, one per body, padded to 4 bytes
+ */
+#define SNAPSHOT_MAGIC "CSNP"
+// Half the size of the box every body is looked for in, in meters
+#define SNAPSHOT_WORLD_EXTENT 1.0e6f
+
+typedef struct SnapshotBody {
+  b2Vec2 position;
+  b2Rot rotation;
+  b2Vec2 linear_velocity;
+  float angular_velocity;
+} SnapshotBody;
+
+typedef struct SnapshotObject {
+  SDL_FPoint pos;
+  float width;
+  float height;
+} SnapshotObject;
+
+/** \brief Which bodies and objects a snapshot holds, and where
+ *
+ * Built once, after which saving and restoring is a straight copy with no
+ * allocation. Every body that can move is found through the broadphase, and
+ * every object under the roots by walking the tree. Bodies or objects added
+ * later aren't captured until the layout is rebuilt.
+ *
+ * Box2D keeps contact impulses and sleep timers to itself, so a restored
+ * world starts each contact fresh. Positions, rotations, velocities and
+ * sleep come back exactly.
+ */
+typedef struct SnapshotLayout {
+  Allocator *allocator;
+  b2BodyId *bodies;
+  size_t body_count;
+  Object2D **objects;
+  size_t object_count;
+  // Bytes every snapshot of this layout takes
+  size_t size;
+} SnapshotLayout;
+
+SnapshotLayout SnapshotLayout_create(Allocator *allocator, b2WorldId world,
+                                     Object2D *const *roots,
+                                     size_t root_count);
+void SnapshotLayout_destroy(SnapshotLayout *self);
+
+// Writes `self->size` bytes to `buffer`
+void SnapshotLayout_save(const SnapshotLayout *self, Uint8 *buffer);
+// False, with nothing changed, if `buffer` came from a different layout
+bool SnapshotLayout_restore(const SnapshotLayout *self, const Uint8 *buffer);
+
+#endif // SNAPSHOT_H
@@ -0,0 +1,40 @@
+/*
+    Atlas Sprite Object Structure
+    Copyright (C) 2025  Ashton Warner
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef SPRITE_H
+#define SPRITE_H
+
+#include "en/obj.h"
+#include "screen/atlas.h"
+
+/** \brief Draws an atlas region centered on its position
+ *
+ * Every sprite on the same layer and atlas page is batched into one draw call
+ */
+typedef struct Sprite {
+  Object2D super;
+  const AtlasRegion *region;
+  SDL_FColor tint;
+} Sprite;
+
+Sprite Sprite_create(const AtlasRegion *region, float width, float height);
+void Sprite_render(Sprite *self, RenderContext *ctx);
+void Sprite_setRegion(Sprite *self, const AtlasRegion *region);
+void Sprite_setTint(Sprite *self, SDL_FColor tint);
+
+#endif // SPRITE_H
@@ -0,0 +1,61 @@
+/*
+    Physics Stress Scenes Structure
+    Copyright (C) 2025  Ashton Warner
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef STRESS_H
+#define STRESS_H
+
+#include <box2d/box2d.h>
+#include <stddef.h>
+
+enum StressScene {
+  STRESS_SCENE_NONE,
+  // Thousands of loose boxes piling up
+  STRESS_SCENE_BOXES,
+  // Columns of stacked convex ship hulls
+  STRESS_SCENE_HULLS,
+  // Hanging chains of revolute joints
+  STRESS_SCENE_JOINTS,
+  // Balls raining through a grid of sensors
+  STRESS_SCENE_SENSORS,
+  STRESS_SCENE_COUNT,
+};
+
+#define STRESS_SCENE_NAMES {"none", "boxes", "hulls", "joints", "sensors"}
+// Space left between the level and a scene built next to it
+#define STRESS_SCENE_GAP 4.0f
+
+typedef struct StressSceneInfo {
+  size_t bodies;
+  size_t shapes;
+  size_t joints;
+} StressSceneInfo;
+
+// STRESS_SCENE_COUNT when `name` isn't a scene
+enum StressScene StressScene_fromName(const char *name);
+const char *StressScene_getName(enum StressScene scene);
+/** \brief Adds a scene's bodies to the world
+ *
+ * The bodies are plain Box2D bodies owned by the world, with no objects
+ * attached, so only the debug draw shows them. The scene's floor starts at
+ * `origin` and runs to the right, everything else is above it. `scale`
+ * multiplies how many bodies there are.
+ */
+StressSceneInfo StressScene_build(enum StressScene scene, b2WorldId world,
+                                  b2Vec2 origin, float scale);
+
+#endif // STRESS_H
@@ -0,0 +1,34 @@
+#ifndef COUNTING_ALLOCATOR_H
+#define COUNTING_ALLOCATOR_H
+
+#include <stddef.h>
+
+#include "heap/allocator.h"
+
+/** \brief Passes everything to another allocator, counting as it goes
+ *
+ * Only as thread safe as the allocator it wraps.
+ */
+typedef struct CountingAllocator {
+  union {
+    Allocator super;
+    struct {
+      void *(*alloc)(struct CountingAllocator *, size_t, size_t);
+      void (*free)(struct CountingAllocator *, void *);
+      void *(*remap)(struct CountingAllocator *, size_t, char[], size_t,
+                     size_t);
+    };
+  };
+
+  size_t allocations;
+  size_t frees;
+  size_t remaps;
+  // Requested by alloc and remap
+  size_t bytes;
+  Allocator *m_allocator;
+} CountingAllocator;
+
+CountingAllocator CountingAllocator_create(Allocator *allocator);
+Allocator *CountingAllocator_getAllocator(CountingAllocator *self);
+
+#endif // COUNTING_ALLOCATOR_H
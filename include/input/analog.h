@@ -0,0 +1,98 @@
+/*
+    Analog Axis Processing Structure
+    Copyright (C) 2025  Ashton Warner
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef ANALOG_H
+#define ANALOG_H
+
+#include <SDL3/SDL.h>
+#include <stdbool.h>
+
+#include "heap/allocator.h"
+
+// Sticks processed at once by the vector path. Storage is padded to it
+#define ANALOG_LANES 4
+// Full scale of the virtual pad's sticks
+#define ANALOG_RANGE 32767.0f
+
+/** \brief How one stick is shaped
+ *
+ * \param inner_deadzone  magnitudes below this read as centered
+ * \param outer_deadzone  magnitudes above this read as fully pushed
+ * \param curve           0 responds linearly, 1 cubically, values between
+ *                        blend the two
+ * \param smoothing       0 follows the input at once. Closer to 1 filters
+ *                        harder
+ */
+typedef struct AnalogSettings {
+  float inner_deadzone;
+  float outer_deadzone;
+  float curve;
+  float smoothing;
+} AnalogSettings;
+
+AnalogSettings AnalogSettings_default();
+
+/** \brief Every stick of every controller, processed in one pass per tick
+ *
+ * Stored as structure of arrays so each step runs over ANALOG_LANES sticks
+ * at once. Radial deadzones work on the stick's magnitude, so diagonals
+ * aren't clipped the way per-axis deadzones would.
+ */
+typedef struct AnalogStage {
+  Allocator *allocator;
+  size_t count;
+  size_t capacity;
+
+  // Raw input in [-1, 1], set every tick
+  float *x;
+  float *y;
+
+  float *inner;
+  float *inv_span;
+  float *curve;
+  // 1 - smoothing, the weight of the new value
+  float *alpha;
+
+  // Smoothed output in [-1, 1], and the same scaled to ANALOG_RANGE
+  float *out_x;
+  float *out_y;
+  Sint32 *scaled_x;
+  Sint32 *scaled_y;
+} AnalogStage;
+
+AnalogStage AnalogStage_create(Allocator *allocator, size_t sticks);
+void AnalogStage_destroy(AnalogStage *self);
+void AnalogStage_configure(AnalogStage *self, size_t stick,
+                           AnalogSettings settings);
+void AnalogStage_setInput(AnalogStage *self, size_t stick, float x, float y);
+
+// Uses SSE2 when the build targets it
+void AnalogStage_process(AnalogStage *self);
+// Reference the vector path is checked against
+void AnalogStage_processScalar(AnalogStage *self);
+
+typedef struct AnalogBenchmark {
+  double scalar_ns_per_stick;
+  double vector_ns_per_stick;
+  // Largest difference between the two paths, in output units
+  Sint32 max_difference;
+} AnalogBenchmark;
+
+AnalogBenchmark AnalogStage_benchmark(size_t sticks, size_t iterations);
+
+#endif // ANALOG_H
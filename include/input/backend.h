@@ -0,0 +1,102 @@
+/*
+    Controller Output Backend Structure
+    Copyright (C) 2025  Ashton Warner
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef BACKEND_H
+#define BACKEND_H
+
+#include <SDL3/SDL.h>
+#include <linux/input.h>
+#include <stdbool.h>
+
+#include "heap/allocator.h"
+#include "input/controller.h"
+
+/** \brief Destination of the reports a `ControllerDevice` sends */
+typedef struct ControllerBackend {
+  Allocator *allocator;
+  const char *name;
+  // Descriptor to wait on for writes and feedback, -1 when there is none
+  int fd;
+
+  /** \brief Write one complete report, ending in its SYN_REPORT
+   *
+   * \return false when the report wasn't taken in full
+   */
+  bool (*write)(struct ControllerBackend *, const struct input_event *events,
+                size_t count);
+  /** \brief Handle everything the reader sent back since the last call
+   *
+   * May be NULL. Only called once `fd` is readable
+   * \return whether `feedback` changed
+   */
+  bool (*poll)(struct ControllerBackend *, ControllerFeedback *feedback);
+  void (*destroy)(struct ControllerBackend *);
+} ControllerBackend;
+
+bool ControllerBackend_write(ControllerBackend *self,
+                             const struct input_event *events, size_t count);
+bool ControllerBackend_poll(ControllerBackend *self,
+                            ControllerFeedback *feedback);
+void ControllerBackend_destroy(ControllerBackend *self);
+
+// Rumble effects a game can upload to a uinput pad at once
+#define UINPUT_FF_EFFECTS 16
+
+/** \brief Virtual pad in `/dev/uinput`
+ *
+ * \return NULL when the device couldn't be created. The reason is logged
+ */
+ControllerBackend *UinputBackend_create(Allocator *allocator);
+
+/** \brief Appends raw `input_event`s to a file or pipe
+ *
+ * \param path  "-" writes to stdout
+ */
+ControllerBackend *RecorderBackend_create(Allocator *allocator,
+                                          const char *path);
+
+/** \brief Keeps the most recent events in memory
+ *
+ * Lets the output path run without any kernel device. The sink also replays
+ * every report it receives so the stream can be checked against what the
+ * device believes it sent. Only read it from the writing thread, or once the
+ * writer has stopped.
+ */
+typedef struct MemoryBackend {
+  ControllerBackend super;
+
+  // Power of two
+  size_t capacity;
+  struct input_event *events;
+  // Total events ever written. The ring holds the last `capacity` of them
+  Uint64 written;
+  Uint64 reports;
+
+  // The pad as of the last complete report, and the one being received
+  ControllerState state;
+  ControllerState partial;
+  // Events with codes the pad doesn't have
+  Uint64 unknown_codes;
+} MemoryBackend;
+
+MemoryBackend *MemoryBackend_create(Allocator *allocator, size_t capacity);
+// NULL once the event has been overwritten, or before it was written
+const struct input_event *MemoryBackend_getEvent(const MemoryBackend *self,
+                                                 Uint64 index);
+
+#endif // BACKEND_H
@@ -19,6 +19,7 @@
 #ifndef CONTROLLER_H
 #define CONTROLLER_H
 
+#include <SDL3/SDL.h>
 #include <linux/uinput.h>
 #include <stdbool.h>
 
@@ -29,8 +30,89 @@
 #define HAT_DOWN 2
 #define HAT_LEFT 3
 
+// USB ids the virtual pads report, so our own devices can be told apart.
+// pid.codes' open source vendor and its test product, since Valve's Steam
+// Virtual Gamepad ids would also match every pad Steam Input wraps
+#define CONTROLLER_VENDOR_ID 0x1209
+#define CONTROLLER_PRODUCT_ID 0x0001
+
+enum ControllerButton {
+  CONTROLLER_BUTTON_A,
+  CONTROLLER_BUTTON_B,
+  CONTROLLER_BUTTON_X,
+  CONTROLLER_BUTTON_Y,
+  CONTROLLER_BUTTON_TL,
+  CONTROLLER_BUTTON_TR,
+  CONTROLLER_BUTTON_TL2,
+  CONTROLLER_BUTTON_TR2,
+  CONTROLLER_BUTTON_START,
+  CONTROLLER_BUTTON_SELECT,
+  CONTROLLER_BUTTON_THUMBL,
+  CONTROLLER_BUTTON_THUMBR,
+  CONTROLLER_BUTTON_COUNT,
+};
+
+// The hat is exposed to the game as two axes in [-1, 1]
+enum ControllerAxis {
+  CONTROLLER_AXIS_X,
+  CONTROLLER_AXIS_Y,
+  CONTROLLER_AXIS_RX,
+  CONTROLLER_AXIS_RY,
+  CONTROLLER_AXIS_HAT_X,
+  CONTROLLER_AXIS_HAT_Y,
+  CONTROLLER_AXIS_COUNT,
+};
+
+// Linux input codes for every button and axis, in enum order
+extern const int CONTROLLER_BUTTON_CODES[CONTROLLER_BUTTON_COUNT];
+extern const int CONTROLLER_AXIS_CODES[CONTROLLER_AXIS_COUNT];
+
+/** \brief Complete state of the virtual pad */
+typedef struct ControllerState {
+  // Bit n is `enum ControllerButton` n
+  unsigned int buttons;
+  int axes[CONTROLLER_AXIS_COUNT];
+} ControllerState;
+
+// Every button and axis changing at once still fits, plus the SYN_REPORT
+#define CONTROLLER_REPORT_MAX                                                  \
+  (CONTROLLER_BUTTON_COUNT + CONTROLLER_AXIS_COUNT + 1)
+
+typedef struct ControllerReport {
+  struct timeval time;
+  size_t len;
+  struct input_event events[CONTROLLER_REPORT_MAX];
+} ControllerReport;
+
+/** \brief Filtering applied to an axis before it is sent
+ *
+ * \param min_delta   changes smaller than this are held back until they add
+ *                    up. Defaults to the kernel's fuzz, which would drop them
+ * \param flat        values this close to the center are sent as the center
+ */
+typedef struct ControllerAxisFilter {
+  int min_delta;
+  int flat;
+  int minimum;
+  int maximum;
+} ControllerAxisFilter;
+
+struct input_absinfo ControllerAxis_getAbsInfo(size_t axis);
+
+/** \brief What the game reading the pad asked it to do */
+typedef struct ControllerFeedback {
+  // Rumble magnitudes of the effect playing, 0 when none is
+  Uint16 strong_magnitude;
+  Uint16 weak_magnitude;
+  // Bit n is LED code n
+  unsigned int leds;
+} ControllerFeedback;
+
+struct ControllerBackend;
+
 typedef struct ControllerDevice {
-  int fd;
+  // NULL when no backend could be created. Reports are then dropped
+  struct ControllerBackend *backend;
   union {
     struct {
       unsigned char up : 1;
@@ -38,16 +120,55 @@ typedef struct ControllerDevice {
       unsigned char down : 1;
       unsigned char left : 1;
     };
-    char bytes : 4;
+    unsigned char bytes : 4;
   } hat;
+
+  // `state` is what the game wants, `sent` is what the device last received
+  ControllerState state;
+  ControllerState sent;
+  ControllerAxisFilter filters[CONTROLLER_AXIS_COUNT];
+  ControllerReport report;
 } ControllerDevice;
 
-ControllerDevice ControllerDevice_default();
+// Takes ownership of `backend`
+ControllerDevice ControllerDevice_create(struct ControllerBackend *backend);
+// Uses uinput, or no backend when uinput isn't available
+ControllerDevice ControllerDevice_default(Allocator *allocator);
 void ControllerDevice_destroy(ControllerDevice *self);
+
+// Setters only change the wanted state. Nothing reaches the device until
+// `ControllerDevice_flush` sends the difference at once
 void ControllerDevice_setButton(ControllerDevice *self, int button_id,
                                 bool value);
 void ControllerDevice_setAxis(ControllerDevice *self, int axis_id, int value);
 void ControllerDevice_setHat(ControllerDevice *self, int hat_id, int value);
+void ControllerDevice_setState(ControllerDevice *self,
+                               const ControllerState *state);
+void ControllerDevice_setAxisDelta(ControllerDevice *self, int min_delta);
+
+/** \brief Send every button and axis that differs from the last report,
+ * followed by a single SYN_REPORT
+ *
+ * \return the events written, 0 when nothing changed or there is no backend
+ * yet to take them, and -1 when the write failed. Failed changes are retried
+ * next flush, ones without a backend are dropped
+ */
+int ControllerDevice_flush(ControllerDevice *self);
+
+typedef struct ControllerBenchmark {
+  // Flushes that wrote something, and ones with nothing left to send
+  Uint64 reports;
+  Uint64 unchanged;
+  Uint64 events;
+  Uint64 failed;
+  double seconds;
+} ControllerBenchmark;
+
+/** \brief Flush `reports` reports of a fixed input pattern as fast as the
+ * backend takes them
+ */
+ControllerBenchmark ControllerDevice_benchmark(ControllerDevice *self,
+                                               size_t reports);
 
 enum ComponentId {
   Button,
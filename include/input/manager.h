@@ -0,0 +1,164 @@
+/*
+    Controller Manager Structure
+    Copyright (C) 2025  Ashton Warner
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef MANAGER_H
+#define MANAGER_H
+
+#include <SDL3/SDL.h>
+#include <stdbool.h>
+
+#include "debug/latency.h"
+#include "heap/allocator.h"
+#include "input/backend.h"
+#include "input/controller.h"
+
+// Must be a power of two. A few ticks of updates for every pad
+#define CONTROLLER_QUEUE_SIZE 256
+#define CONTROLLER_MAX_PADS 16
+// Threads creating uinput devices in the background
+#define CONTROLLER_SETUP_THREADS 4
+
+typedef struct ControllerUpdate {
+  // The report stage is stamped on submit
+  LatencyTrace trace;
+  size_t pad;
+  ControllerState state;
+} ControllerUpdate;
+
+typedef struct ControllerQueueSlot {
+  SDL_AtomicU32 sequence;
+  ControllerUpdate update;
+} ControllerQueueSlot;
+
+/** \brief Bounded lock-free queue with many producers and one consumer
+ *
+ * Each slot carries a sequence number telling producers and the consumer
+ * whose turn it is, so neither side ever takes a lock.
+ */
+typedef struct ControllerQueue {
+  ControllerQueueSlot slots[CONTROLLER_QUEUE_SIZE];
+  SDL_AtomicU32 head;
+  SDL_AtomicU32 tail;
+} ControllerQueue;
+
+void ControllerQueue_init(ControllerQueue *self);
+bool ControllerQueue_push(ControllerQueue *self,
+                          const ControllerUpdate *update);
+bool ControllerQueue_pop(ControllerQueue *self, ControllerUpdate *update);
+
+typedef struct ControllerOutputOptions {
+  // Core to pin the thread to, or -1 to let the scheduler decide
+  int cpu;
+  bool realtime;
+  // Finished traces are recorded here when set
+  LatencyRecorder *latency;
+} ControllerOutputOptions;
+
+typedef struct ControllerOutputStats {
+  SDL_AtomicInt updates;
+  SDL_AtomicInt coalesced;
+  SDL_AtomicInt reports;
+  SDL_AtomicInt dropped;
+  SDL_AtomicInt failed_writes;
+  SDL_AtomicInt feedback;
+} ControllerOutputStats;
+
+/** \brief One virtual pad as seen by the manager thread */
+typedef struct ManagedPad {
+  ControllerDevice device;
+  // Has changes the backend hasn't taken yet
+  bool pending;
+  // Backend created in the background, waiting for the manager thread to
+  // take it. Accessed atomically
+  void *incoming;
+} ManagedPad;
+
+/** \brief Owns every virtual pad and the single thread writing to them
+ *
+ * Producers submit whole pad states from any thread. The manager thread
+ * sleeps in one epoll wait covering every pad, wakes up on submits, keeps
+ * only the newest state of each pad and flushes them together. Pads whose
+ * backend is full are retried a millisecond later, and
+ * rumble/LED requests are read back on the same loop.
+ */
+typedef struct ControllerManager {
+  Allocator *allocator;
+  ControllerOutputOptions options;
+
+  size_t pad_count;
+  ManagedPad *pads;
+
+  ControllerQueue queue;
+  int epoll_fd;
+  // eventfd producers poke to wake the thread
+  int wake_fd;
+  SDL_AtomicInt running;
+  SDL_Thread *thread;
+
+  SDL_Thread *setup_threads[CONTROLLER_SETUP_THREADS];
+  SDL_AtomicInt next_setup;
+  SDL_AtomicInt setup_done;
+  // SDL_GetTicksNS() when the last device finished, once `setup_complete`
+  Uint64 setup_finished;
+  SDL_AtomicInt setup_complete;
+
+  // Written by the manager thread, copied out under `feedback_lock`
+  SDL_SpinLock feedback_lock;
+  ControllerFeedback *feedback;
+
+  // Traces waiting on the next successful write of their pad
+  struct {
+    size_t pad;
+    LatencyTrace trace;
+  } traces[CONTROLLER_QUEUE_SIZE];
+  size_t trace_count;
+
+  ControllerOutputStats stats;
+} ControllerManager;
+
+// Pads start without a backend and drop their reports until one is attached
+ControllerManager *ControllerManager_create(Allocator *allocator,
+                                            size_t pad_count,
+                                            ControllerOutputOptions options);
+void ControllerManager_destroy(ControllerManager *self);
+
+// Only before `ControllerManager_start`. Takes ownership of `backend`
+void ControllerManager_attach(ControllerManager *self, size_t pad,
+                              ControllerBackend *backend);
+bool ControllerManager_start(ControllerManager *self);
+
+/** \brief Create a uinput device for every pad without waiting for them
+ *
+ * Only after `ControllerManager_start`. Pads keep the newest submitted state
+ * and send it as soon as their device exists.
+ */
+void ControllerManager_openUinputAsync(ControllerManager *self);
+/** \brief Whether every device started by `openUinputAsync` is done
+ *
+ * \param finished  set to when the last one finished, may be NULL
+ */
+bool ControllerManager_isReady(ControllerManager *self, Uint64 *finished);
+
+// `trace` may be NULL when the update isn't being measured
+bool ControllerManager_submit(ControllerManager *self, size_t pad,
+                              const ControllerState *state,
+                              const LatencyTrace *trace);
+ControllerFeedback ControllerManager_getFeedback(ControllerManager *self,
+                                                 size_t pad);
+
+#endif // MANAGER_H
@@ -0,0 +1,134 @@
+/*
+    Controller Remapping Structure
+    Copyright (C) 2025  Ashton Warner
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef REMAP_H
+#define REMAP_H
+
+#include <SDL3/SDL.h>
+
+#include "heap/allocator.h"
+#include "input/controller.h"
+#include "input/state.h"
+
+// Every control of an `InputState` as one float, so bindings index a flat
+// array instead of branching on the kind of control
+enum RemapSource {
+  REMAP_SOURCE_BUTTON = 0,
+  REMAP_SOURCE_AXIS = REMAP_SOURCE_BUTTON + INPUT_BUTTON_COUNT,
+  REMAP_SOURCE_HAT_X = REMAP_SOURCE_AXIS + INPUT_AXIS_COUNT,
+  REMAP_SOURCE_HAT_Y,
+  REMAP_SOURCE_COUNT,
+};
+
+#define RemapSource_button(BUTTON) (REMAP_SOURCE_BUTTON + (BUTTON))
+#define RemapSource_axis(AXIS) (REMAP_SOURCE_AXIS + (AXIS))
+
+enum RemapTargetKind {
+  REMAP_TARGET_BUTTON,
+  REMAP_TARGET_AXIS,
+};
+
+enum RemapCurve {
+  REMAP_CURVE_LINEAR,
+  REMAP_CURVE_QUADRATIC,
+  REMAP_CURVE_CUBIC,
+};
+
+/** \brief One source control driving one output of the virtual pad
+ *
+ * \param target     `enum ControllerButton` or `enum ControllerAxis`
+ * \param scale      multiplies the shaped value. Negative inverts it
+ * \param deadzone   source magnitudes below this read as 0, the rest is
+ *                   stretched back to [0, 1]
+ * \param threshold  button targets are pressed at or above this value, or
+ *                   at any non-zero value when it is 0
+ */
+typedef struct RemapBinding {
+  int source;
+  enum RemapTargetKind target_kind;
+  int target;
+  float scale;
+  float deadzone;
+  enum RemapCurve curve;
+  float threshold;
+} RemapBinding;
+
+extern const RemapBinding REMAP_DEFAULT_BINDINGS[];
+extern const size_t REMAP_DEFAULT_BINDING_COUNT;
+// The defaults with the sticks swapped
+extern const RemapBinding REMAP_SWAPPED_BINDINGS[];
+extern const size_t REMAP_SWAPPED_BINDING_COUNT;
+
+typedef struct RemapEntry {
+  Uint8 source;
+  Uint8 target;
+  float scale;
+  float deadzone;
+  float inv_range;
+  // Polynomial in the live magnitude, so every curve is evaluated the same way
+  float curve[3];
+  float threshold;
+} RemapEntry;
+
+/** \brief Bindings compiled for evaluation
+ *
+ * Entries are grouped by the kind of output and sorted by source, so a tick
+ * is two straight loops with no lookups, whatever the number of bindings.
+ */
+typedef struct RemapTable {
+  Allocator *allocator;
+  size_t axis_count;
+  RemapEntry *axis_entries;
+  size_t button_count;
+  RemapEntry *button_entries;
+  // Output range of each axis, from the absinfo the device advertises
+  float axis_range[CONTROLLER_AXIS_COUNT];
+} RemapTable;
+
+// Bindings with an out of range source or target are skipped
+RemapTable *RemapTable_compile(Allocator *allocator,
+                               const RemapBinding *bindings, size_t count);
+void RemapTable_destroy(RemapTable *self);
+void RemapTable_evaluate(const RemapTable *self, const InputState *input,
+                         ControllerState *out);
+
+/** \brief Table in use by one reader thread, replaceable from any thread
+ *
+ * A rebind only publishes the new table. The reader swaps it in with
+ * `RemapEngine_update` and frees the old one itself, so it never sees a table
+ * that is being freed.
+ */
+typedef struct RemapEngine {
+  // Reader owned
+  RemapTable *current;
+  // Published table the reader hasn't taken yet. Accessed atomically
+  void *pending;
+} RemapEngine;
+
+// Takes ownership of `table`
+RemapEngine RemapEngine_create(RemapTable *table);
+void RemapEngine_destroy(RemapEngine *self);
+// Takes ownership of `table`. Tables have to use a thread safe allocator
+void RemapEngine_rebind(RemapEngine *self, RemapTable *table);
+// Reader only. Takes up the last rebind, once per tick so every pad in it
+// maps through the same table
+void RemapEngine_update(RemapEngine *self);
+void RemapEngine_evaluate(const RemapEngine *self, const InputState *input,
+                          ControllerState *out);
+
+#endif // REMAP_H
@@ -0,0 +1,121 @@
+/*
+    Input Recording and Replay Structure
+    Copyright (C) 2025  Ashton Warner
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <SDL3/SDL.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "heap/allocator.h"
+#include "input/state.h"
+
+/*
+ * File layout, all integers little endian:
+ *
+ *   "CGIR" version:u8 players:u8 tick_rate:u16 substeps:u8
+ *   records...
+ *
+ * A record is a varint count of unchanged ticks, then one tick of changes for
+ * every player. Each player starts with a mask byte saying which fields
+ * follow, encoded against that player's previous tick:
+ *
+ *   REPLAY_FIELD_BUTTONS  varint of the buttons xor'd with the old ones
+ *   REPLAY_FIELD_HAT      one byte, (hat_x + 1) | (hat_y + 1) << 2
+ *   REPLAY_FIELD_AXIS(n)  zigzag varint of the change in axis n * 32767
+ *
+ * A mask of REPLAY_END in place of the first player's ends the stream.
+ */
+#define REPLAY_MAGIC "CGIR"
+#define REPLAY_VERSION 2
+#define REPLAY_FIELD_BUTTONS 0x01
+#define REPLAY_FIELD_HAT 0x02
+#define REPLAY_FIELD_AXIS(AXIS) (0x04 << (AXIS))
+#define REPLAY_END 0x80
+#define REPLAY_MAX_PLAYERS 16
+
+// What a tick looks like on disk. Inputs all come from 16 bit devices or
+// keys, so the axes survive the trip exactly
+typedef struct ReplayFrame {
+  Uint32 buttons;
+  Sint8 hat_x;
+  Sint8 hat_y;
+  Sint16 axes[INPUT_AXIS_COUNT];
+} ReplayFrame;
+
+ReplayFrame ReplayFrame_fromState(const InputState *state);
+InputState ReplayFrame_toState(const ReplayFrame *frame);
+
+/** \brief Streams every tick's input to a file
+ *
+ * Only ticks where something changed cost anything, and then only the fields
+ * that changed. Written by the fixed update.
+ */
+typedef struct InputRecorder {
+  Allocator *allocator;
+  FILE *file;
+  size_t players;
+  ReplayFrame previous[REPLAY_MAX_PLAYERS];
+  // Unchanged ticks since the last record
+  Uint64 idle;
+
+  Uint64 ticks;
+  Uint64 bytes;
+  bool failed;
+} InputRecorder;
+
+// `substeps` is the pinned count the session steps with, so replays match it
+InputRecorder *InputRecorder_create(Allocator *allocator, const char *path,
+                                    size_t players, Uint16 tick_rate,
+                                    int substeps);
+// Writes the end marker and closes the file
+void InputRecorder_destroy(InputRecorder *self);
+// One tick of `count` players. Extra players are dropped, missing ones are
+// recorded as idle
+bool InputRecorder_write(InputRecorder *self, const InputState *states,
+                         size_t count);
+
+/** \brief Plays a recording back one tick at a time
+ *
+ * The whole file is read up front so a replay does no IO while it runs.
+ */
+typedef struct InputReplay {
+  Allocator *allocator;
+  Uint8 *data;
+  size_t size;
+  size_t offset;
+
+  size_t players;
+  Uint16 tick_rate;
+  // What the recording stepped with
+  int substeps;
+  ReplayFrame current[REPLAY_MAX_PLAYERS];
+  // Ticks left before the next record applies
+  Uint64 idle;
+  bool finished;
+
+  Uint64 ticks;
+} InputReplay;
+
+InputReplay *InputReplay_open(Allocator *allocator, const char *path);
+void InputReplay_destroy(InputReplay *self);
+// Fills `count` players with the next tick. False once the recording ends
+bool InputReplay_next(InputReplay *self, InputState *states, size_t count);
+
+#endif // REPLAY_H
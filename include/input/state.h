@@ -0,0 +1,87 @@
+/*
+    Input Snapshot Structure
+    Copyright (C) 2025  Ashton Warner
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef STATE_H
+#define STATE_H
+
+#include <SDL3/SDL.h>
+#include <stdbool.h>
+
+enum InputButton {
+  INPUT_BUTTON_PRIMARY,
+  INPUT_BUTTON_SECONDARY,
+  INPUT_BUTTON_TERTIARY,
+  INPUT_BUTTON_QUATERNY,
+  INPUT_BUTTON_JUMP,
+  INPUT_BUTTON_ACTION,
+  INPUT_BUTTON_DISMOUNT,
+  INPUT_BUTTON_ATTACK,
+  INPUT_BUTTON_COUNT,
+};
+
+enum InputAxis {
+  INPUT_AXIS_X,
+  INPUT_AXIS_Y,
+  INPUT_AXIS_RX,
+  INPUT_AXIS_RY,
+  INPUT_AXIS_COUNT,
+};
+
+/** \brief Everything a controller reports, taken at one instant */
+typedef struct InputState {
+  // SDL_GetTicksNS() when it was sampled
+  Uint64 timestamp;
+  // Bit n is `enum InputButton` n
+  Uint32 buttons;
+  // In [-1, 1], `enum InputAxis` order
+  float axes[INPUT_AXIS_COUNT];
+  Sint8 hat_x;
+  Sint8 hat_y;
+} InputState;
+
+#define InputState_isPressed(SELF, BUTTON) ((((SELF)->buttons) >> (BUTTON)) & 1)
+#define InputState_setPressed(SELF, BUTTON, PRESSED)                           \
+  ((SELF)->buttons = ((SELF)->buttons & ~(1u << (BUTTON))) |                   \
+                     ((Uint32)(bool)(PRESSED) << (BUTTON)))
+
+// Marks the middle buffer as holding a snapshot the reader hasn't seen
+#define INPUT_CHANNEL_FRESH 4
+
+/** \brief Hands snapshots from one writer thread to one reader thread
+ *
+ * A triple buffer. The writer fills the back buffer and swaps it with the
+ * middle one, the reader swaps the middle one with its front buffer when it
+ * is fresh. Neither side waits and neither ever sees half a snapshot.
+ */
+typedef struct InputChannel {
+  InputState buffers[3];
+  // Writer and reader own these indices
+  int back;
+  int front;
+  // Middle buffer index, with INPUT_CHANNEL_FRESH
+  SDL_AtomicInt middle;
+} InputChannel;
+
+InputChannel InputChannel_create();
+// The buffer to fill before `InputChannel_publish`
+InputState *InputChannel_getBack(InputChannel *self);
+void InputChannel_publish(InputChannel *self);
+// Newest published snapshot. Stays valid until the next call
+const InputState *InputChannel_read(InputChannel *self);
+
+#endif // STATE_H
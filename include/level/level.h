@@ -0,0 +1,215 @@
+/*
+    Binary Level Format Structure
+    Copyright (C) 2025  Ashton Warner
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef LEVEL_H
+#define LEVEL_H
+
+#include <SDL3/SDL.h>
+#include <box2d/box2d.h>
+#include <stdbool.h>
+
+#include "en/obj.h"
+#include "heap/allocator.h"
+#include "util/slice.h"
+
+/*
+ * File layout, all integers and floats little endian:
+ *
+ *   LevelHeader
+ *   sections...
+ *
+ * Every section is a flat array of one of the structs below, starting on a
+ * LEVEL_ALIGNMENT boundary. Records refer to each other by index, never by
+ * pointer, so the file can be mapped anywhere and read in place. Everything
+ * is checked once when it's opened, after which nothing needs a bounds check.
+ *
+ * Each section also records the size of its records, so a file written by a
+ * build with a different layout is turned away instead of misread.
+ */
+#define LEVEL_MAGIC "CLVL"
+#define LEVEL_VERSION 1
+#define LEVEL_ALIGNMENT 8
+
+enum LevelSectionId {
+  LEVEL_SECTION_POINTS,
+  LEVEL_SECTION_SEGMENTS,
+  LEVEL_SECTION_BOXES,
+  LEVEL_SECTION_CHAINS,
+  LEVEL_SECTION_BODIES,
+  LEVEL_SECTION_SPAWNS,
+  LEVEL_SECTION_SHIPS,
+  LEVEL_SECTION_SHIP_PARTS,
+  LEVEL_SECTION_COUNT,
+};
+
+typedef struct LevelSection {
+  Uint32 offset;
+  Uint32 count;
+  Uint32 stride;
+  Uint32 reserved;
+} LevelSection;
+
+typedef struct LevelHeader {
+  char magic[4];
+  Uint16 version;
+  Uint16 section_count;
+  Uint32 file_size;
+  Uint32 reserved;
+  LevelSection sections[LEVEL_SECTION_COUNT];
+} LevelHeader;
+
+// `count` records of a section starting at `first`
+typedef struct LevelRange {
+  Uint32 first;
+  Uint32 count;
+} LevelRange;
+
+// Same layout as `b2Vec2`, so points go straight to Box2D
+typedef struct LevelPoint {
+  float x;
+  float y;
+} LevelPoint;
+
+typedef struct LevelSegment {
+  LevelPoint point1;
+  LevelPoint point2;
+} LevelSegment;
+
+typedef struct LevelBox {
+  LevelPoint center;
+  LevelPoint half_extents;
+  // Radians
+  float angle;
+  Uint32 reserved;
+} LevelBox;
+
+#define LEVEL_CHAIN_LOOP 0x01
+
+// Open chains use their first and last points as ghost vertices, as Box2D
+// does, so only the edges between them collide
+typedef struct LevelChain {
+  LevelRange points;
+  Uint32 flags;
+  Uint32 reserved;
+} LevelChain;
+
+// One static body. Its shapes are relative to `position`
+typedef struct LevelBody {
+  LevelPoint position;
+  LevelRange segments;
+  LevelRange boxes;
+  LevelRange chains;
+} LevelBody;
+
+enum LevelSpawnKind {
+  LEVEL_SPAWN_PLAYER,
+  LEVEL_SPAWN_KIND_COUNT,
+};
+
+#define LEVEL_SPAWN_KIND_NAMES {"player"}
+
+typedef struct LevelSpawn {
+  LevelPoint position;
+  Uint32 kind;
+  Uint32 reserved;
+} LevelSpawn;
+
+// A dynamic body built out of boxes
+typedef struct LevelShip {
+  LevelPoint position;
+  LevelRange parts;
+} LevelShip;
+
+typedef struct LevelShipPart {
+  LevelPoint offset;
+  LevelPoint half_extents;
+  float density;
+  Uint32 reserved;
+} LevelShipPart;
+
+/** \brief A level file mapped into memory
+ *
+ * The slices point straight into the mapping. Read only, so it can be shared
+ * between any number of worlds and threads.
+ */
+typedef struct Level {
+  Allocator *allocator;
+  void *data;
+  size_t size;
+
+  Slice(const LevelPoint) points;
+  Slice(const LevelSegment) segments;
+  Slice(const LevelBox) boxes;
+  Slice(const LevelChain) chains;
+  Slice(const LevelBody) bodies;
+  Slice(const LevelSpawn) spawns;
+  Slice(const LevelShip) ships;
+  Slice(const LevelShipPart) ship_parts;
+} Level;
+
+/** \brief Maps and validates the level at `path`
+ *
+ * Returns NULL and logs why if the file can't be used.
+ */
+Level *Level_open(Allocator *allocator, const char *path);
+void Level_close(Level *self);
+
+/** \brief Where the `index`th spawn of `kind` is, or `fallback` if the level
+ * doesn't have one
+ */
+b2Vec2 Level_getSpawn(const Level *self, enum LevelSpawnKind kind,
+                      size_t index, b2Vec2 fallback);
+
+/** \brief Turns a text level into a binary one
+ *
+ * The source is one record per line, `#` starts a comment:
+ *
+ *   body X Y                    starts a static body
+ *   segment X1 Y1 X2 Y2         adds to the last body
+ *   box X Y HALF_W HALF_H [ANGLE]
+ *   chain loop|open X Y X Y...  at least four points
+ *   spawn KIND X Y
+ *   ship X Y                    starts a ship
+ *   part X Y HALF_W HALF_H DENSITY  adds to the last ship
+ *
+ * Errors are logged with their line number. Each static body's boxes and
+ * segments are merged on the way through, see `LevelMerger`.
+ */
+bool Level_convert(const char *source_path, const char *output_path);
+
+/** \brief Everything a level put into a world
+ *
+ * Draws the static geometry and destroys the bodies with itself. The level
+ * has to outlive it.
+ */
+typedef struct LevelObject {
+  Object2D super;
+  Allocator *allocator;
+  const Level *level;
+  // Static bodies first, in file order, then the ships
+  b2BodyId *bodies;
+  size_t body_count;
+  size_t shape_count;
+} LevelObject;
+
+LevelObject *LevelObject_create(Allocator *allocator, const Level *level,
+                                b2WorldId world);
+void LevelObject_destroy(LevelObject *self);
+void LevelObject_render(LevelObject *self, RenderContext *ctx);
+
+#endif // LEVEL_H
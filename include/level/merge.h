@@ -0,0 +1,78 @@
+/*
+    Static Level Geometry Merging Structure
+    Copyright (C) 2025  Ashton Warner
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef LEVEL_MERGE_H
+#define LEVEL_MERGE_H
+
+#include "heap/allocator.h"
+#include "level/level.h"
+#include "util/stack.h"
+
+// Coordinates are snapped to 1 / LEVEL_MERGE_SCALE meters before they're
+// compared, so tiles written as decimals still meet
+#define LEVEL_MERGE_SCALE 1024.0
+// How far off a multiple of 90 degrees a box can be and still merge
+#define LEVEL_MERGE_ANGLE_EPSILON 1e-4f
+
+typedef struct LevelMergeStats {
+  // Boxes going in, how many were merged and how many came out
+  size_t boxes;
+  size_t boxes_merged;
+  size_t boxes_out;
+  // Segments going in and coming out
+  size_t segments;
+  size_t segments_out;
+  // Chain loops made out of the merged boxes, and their edges
+  size_t loops;
+  size_t loop_edges;
+} LevelMergeStats;
+
+/** \brief Cuts the shape count of static bodies
+ *
+ * Axis aligned boxes are replaced by the outline of their union, as chain
+ * loops wound so Box2D collides with the outside. Edges between touching
+ * boxes disappear and every straight run becomes one edge. Outlines that
+ * come out as a single rectangle stay one box.
+ *
+ * Segments that overlap or meet end to end on the same line become one
+ * segment. They stay segments since a chain would make them one sided.
+ *
+ * Rotated boxes are passed through untouched.
+ */
+typedef struct LevelMerger {
+  Allocator *allocator;
+
+  // The last body's shapes. Each loop is a range of `points`
+  Stack(LevelSegment) segments;
+  Stack(LevelBox) boxes;
+  Stack(LevelPoint) points;
+  Stack(LevelRange) loops;
+
+  // Totals over every body
+  LevelMergeStats stats;
+} LevelMerger;
+
+LevelMerger LevelMerger_create(Allocator *allocator);
+void LevelMerger_destroy(LevelMerger *self);
+
+// Replaces the last body's shapes with the merged `segments` and `boxes`
+void LevelMerger_mergeBody(LevelMerger *self, const LevelSegment *segments,
+                           size_t segment_count, const LevelBox *boxes,
+                           size_t box_count);
+
+#endif // LEVEL_MERGE_H
@@ -0,0 +1,73 @@
+/*
+    Bit Packing Structure
+    Copyright (C) 2025  Ashton Warner
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef BITS_H
+#define BITS_H
+
+#include <SDL3/SDL.h>
+#include <stdbool.h>
+
+/*
+ * Values are packed least significant bit first. Varints are written four
+ * bits at a time, each group followed by a bit saying whether another comes
+ * after it, so anything under 16 takes 5 bits. Signed varints are zigzagged
+ * first so small negative numbers stay small.
+ */
+
+/** \brief Packs values into a fixed buffer
+ *
+ * Running out of room sets `overflow` and drops everything written after it,
+ * so a packet only has to be checked once at the end.
+ */
+typedef struct BitWriter {
+  Uint8 *data;
+  size_t capacity;
+  size_t bits;
+  bool overflow;
+} BitWriter;
+
+BitWriter BitWriter_create(Uint8 *data, size_t capacity);
+// The low `count` bits of `value`, up to 32
+void BitWriter_write(BitWriter *self, Uint32 value, int count);
+void BitWriter_writeVarint(BitWriter *self, Uint32 value);
+void BitWriter_writeSigned(BitWriter *self, Sint32 value);
+// Pads to the next byte and copies `length` bytes straight in
+void BitWriter_writeBytes(BitWriter *self, const Uint8 *bytes, size_t length);
+// Bytes written so far, the last one padded with zeros
+size_t BitWriter_getSize(const BitWriter *self);
+
+/** \brief Unpacks what a `BitWriter` wrote
+ *
+ * Reading past the end sets `overflow` and returns zeros from then on.
+ */
+typedef struct BitReader {
+  const Uint8 *data;
+  size_t size;
+  size_t bits;
+  bool overflow;
+} BitReader;
+
+BitReader BitReader_create(const Uint8 *data, size_t size);
+Uint32 BitReader_read(BitReader *self, int count);
+Uint32 BitReader_readVarint(BitReader *self);
+Sint32 BitReader_readSigned(BitReader *self);
+// Skips to the next byte and returns the `length` bytes there, NULL if the
+// data ends first
+const Uint8 *BitReader_readBytes(BitReader *self, size_t length);
+
+#endif // BITS_H
@@ -0,0 +1,277 @@
+/*
+    Rollback Netplay Structure
+    Copyright (C) 2025  Ashton Warner
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef NETPLAY_H
+#define NETPLAY_H
+
+#include <SDL3/SDL.h>
+#include <stdbool.h>
+
+#include "heap/allocator.h"
+#include "input/replay.h"
+#include "input/state.h"
+#include "net/socket.h"
+
+/*
+ * Packets are bit packed with `BitWriter`. Every one starts with
+ *
+ *   NETPLAY_MAGIC:8 NETPLAY_VERSION:4 kind:4 slot:4 frame:32
+ *
+ * where `frame` is the sender's next frame to simulate. Frames below are
+ * signed varints against it unless said otherwise.
+ *
+ * NETPLAY_PACKET_INPUT carries the sender's inputs, every one the receiver
+ * hasn't acknowledged yet so a lost packet is covered by the next:
+ *
+ *   advantage:signed  frames the sender thinks it is ahead of the receiver
+ *   received:signed   how many of the receiver's inputs the sender has
+ *   first:signed count:varint inputs...
+ *   1 checksum:varint hash:32, or 0. The checksum's frame is `frame` minus it
+ *   1 resync:32, or 0. One past the newest resync the sender has finished
+ *
+ * Each input is one bit, set when it differs from the input before it. The
+ * first is against input `first - 1`, which the receiver acknowledged having.
+ * A changed input has a mask of `REPLAY_FIELD`s, NETPLAY_MASK_BITS long,
+ * followed by the fields in it:
+ *
+ *   REPLAY_FIELD_BUTTONS  INPUT_BUTTON_COUNT bits xor'd with the old ones
+ *   REPLAY_FIELD_HAT      4 bits, (hat_x + 1) | (hat_y + 1) << 2
+ *   REPLAY_FIELD_AXIS(n)  a 2 bit NETPLAY_AXIS tag, then 16 bits for RAW
+ *
+ * NETPLAY_PACKET_RESYNC carries a piece of slot 0's snapshot of `frame`:
+ *
+ *   size:varint piece:varint, then up to NETPLAY_PIECE_SIZE bytes from the
+ *   next byte boundary
+ */
+#define NETPLAY_MAGIC 0xC7
+#define NETPLAY_VERSION 1
+#define NETPLAY_PACKET_INPUT 0
+#define NETPLAY_PACKET_RESYNC 1
+#define NETPLAY_MASK_BITS (2 + INPUT_AXIS_COUNT)
+// Keys and centered sticks are whole, so most axes fit in the tag
+#define NETPLAY_AXIS_ZERO 0
+#define NETPLAY_AXIS_MAX 1
+#define NETPLAY_AXIS_MIN 2
+#define NETPLAY_AXIS_RAW 3
+
+#define NETPLAY_MAX_PLAYERS 8
+#define NETPLAY_TICK_NS (SDL_NS_PER_SECOND / 60)
+// Frames the simulation may run ahead of the oldest input it's missing.
+// Further than that and it waits, which is where lockstep takes over
+#define NETPLAY_MAX_ROLLBACK 8
+// One extra so checksums can still reach the oldest confirmed frame
+#define NETPLAY_SNAPSHOTS (NETPLAY_MAX_ROLLBACK + 2)
+// Frames of input kept for every player. Holds a resync's worth of replaying
+#define NETPLAY_HISTORY 128
+#define NETPLAY_MAX_DELAY 8
+// Ticks the time sync averages over, and how far ahead of a player we can be
+// before giving up a tick
+#define NETPLAY_DRIFT_TICKS 16
+#define NETPLAY_MAX_DRIFT 1.0f
+// Most inputs one packet repeats. Lockstep keeps far fewer unacknowledged
+#define NETPLAY_MAX_REDUNDANT 64
+// Confirmed frames that get checksummed, and how many checksums are kept
+#define NETPLAY_CHECKSUM_INTERVAL 16
+#define NETPLAY_CHECKSUMS 32
+#define NETPLAY_PIECE_SIZE 1024
+#define NETPLAY_PIECES_PER_TICK 8
+#define NETPLAY_TIMEOUT_NS (10 * SDL_NS_PER_SECOND)
+#define NETPLAY_NO_FRAME SDL_MAX_UINT32
+
+typedef struct NetplayDef {
+  size_t players;
+  // The slot played here. Slot 0 is the keyboard player and has the final
+  // say when worlds disagree, the rest are the gamepad players
+  size_t local;
+  // Every slot's address, the local one gives the port to bind
+  NetAddress addresses[NETPLAY_MAX_PLAYERS];
+  // Ticks local input is held back. Hides that much latency without rolling
+  // back, at the cost of that much lag
+  Uint32 input_delay;
+  // Applied to everything sent, `seed` picks which packets are lost
+  NetConditions conditions;
+  Uint64 seed;
+  // Drives every timing when set, e.g. by a test running faster than real
+  // time. SDL_GetTicksNS() otherwise
+  const Uint64 *clock;
+} NetplayDef;
+
+NetplayDef NetplayDef_default();
+
+typedef struct NetplayStats {
+  // What the session sent and read, not counting UDP and IP headers
+  Uint64 packets_sent;
+  Uint64 bytes_sent;
+  Uint64 packets_received;
+  Uint64 bytes_received;
+  // Malformed, from strangers or from a different world
+  Uint64 packets_rejected;
+  // Every copy of every input sent
+  Uint64 inputs_sent;
+
+  // Remote inputs that turned out different from the guess
+  Uint64 mispredictions;
+  Uint64 rollbacks;
+  Uint64 resimulated_frames;
+  Uint64 resimulate_ns;
+  Uint64 max_resimulate_ns;
+  Uint32 max_rollback;
+  // Ticks spent waiting on input that's too late, and ticks given up to let
+  // the others catch up
+  Uint64 stalls;
+  Uint64 waits;
+
+  Uint64 checksums;
+  Uint64 desyncs;
+  // Snapshots slot 0 sent, or that were applied from it
+  Uint64 resyncs;
+  Uint64 resync_bytes;
+} NetplayStats;
+
+typedef struct NetplayChecksum {
+  Uint32 frame;
+  Uint32 hash;
+} NetplayChecksum;
+
+typedef struct NetplayPeer {
+  NetAddress address;
+  // Our inputs they've acknowledged, all of them up to here
+  Uint32 acked;
+  // Their next frame, how far ahead of us they think they are, and when we
+  // heard it
+  Uint32 frame;
+  Sint32 advantage;
+  Uint64 frame_at;
+  // How far ahead of them we are once both guesses are taken into account,
+  // averaged over recent ticks since jitter makes any one tick's guess noisy
+  float drift;
+  Uint64 last_heard;
+  Uint64 rtt_ns;
+  // Their newest checksum, until ours for the same frame is taken. Every
+  // packet repeats it, so only ones past `checksum_through` are new
+  NetplayChecksum checksum;
+  Uint32 checksum_through;
+
+  // Slot 0's side of a resync. The frame is NETPLAY_NO_FRAME until the
+  // snapshot is copied out of the ring
+  bool resync_sending;
+  Uint32 resync_frame;
+  Uint32 resync_piece;
+  Uint8 *resync_data;
+  // One past the newest resync they've finished with
+  Uint32 resync_through;
+} NetplayPeer;
+
+/** \brief Lockstep with rollback over UDP
+ *
+ * Every side simulates the same frames from the same inputs. Inputs that
+ * haven't arrived are guessed to be what that player last held, and when the
+ * real one turns out different everything from that frame on is rolled back
+ * and simulated again. Nobody gets more than NETPLAY_MAX_ROLLBACK frames
+ * ahead of the input they're missing, and whoever is ahead of the others
+ * gives up a tick now and then so the rollbacks are shared.
+ *
+ * Checksums of confirmed frames are compared with slot 0's. A side that
+ * disagrees is sent slot 0's snapshot and replays its inputs on top.
+ *
+ * The session only keeps the books. Whoever owns the world restores, steps
+ * and saves it, see `AppState_tick`. Belongs to the fixed update.
+ */
+typedef struct NetplaySession {
+  Allocator *allocator;
+  NetSocket *socket;
+  const Uint64 *clock;
+
+  size_t players;
+  size_t local;
+  Uint32 input_delay;
+  NetplayPeer peers[NETPLAY_MAX_PLAYERS];
+
+  // Next frame to simulate
+  Uint32 frame;
+  // Every player's inputs by frame modulo NETPLAY_HISTORY. From a player's
+  // `confirmed` on they hold the guesses the frames were simulated with
+  ReplayFrame inputs[NETPLAY_MAX_PLAYERS][NETPLAY_HISTORY];
+  Uint32 confirmed[NETPLAY_MAX_PLAYERS];
+  // When each of our inputs first went out, and how many have
+  Uint64 sent_at[NETPLAY_HISTORY];
+  Uint32 sent;
+  // Oldest frame simulated with a wrong guess
+  Uint32 rollback;
+
+  // The state at the start of each of the last NETPLAY_SNAPSHOTS frames
+  size_t snapshot_size;
+  Uint8 *snapshots;
+
+  NetplayChecksum checksums[NETPLAY_CHECKSUMS];
+  Uint32 next_checksum;
+  NetplayChecksum latest;
+
+  // A snapshot from slot 0 coming in, and which of its pieces have
+  Uint8 *resync_data;
+  Uint8 *resync_pieces;
+  size_t resync_missing;
+  Uint32 resync_frame;
+  Uint32 resync_through;
+
+  bool disconnected;
+  NetplayStats stats;
+} NetplaySession;
+
+/** \brief Starts at frame 0 with nobody heard from yet
+ *
+ * Takes `socket`. Snapshots are `snapshot_size` bytes and 8 byte aligned.
+ */
+NetplaySession *NetplaySession_create(Allocator *allocator, NetSocket *socket,
+                                      const NetplayDef *def,
+                                      size_t snapshot_size);
+void NetplaySession_destroy(NetplaySession *self);
+
+// Reads every packet that arrived. False once someone has been quiet for
+// NETPLAY_TIMEOUT_NS
+bool NetplaySession_poll(NetplaySession *self);
+/** \brief Where to roll back to, if anywhere
+ *
+ * Restore `*snapshot`, then simulate every frame from `*frame` to the
+ * current one again, saving each one's snapshot as it goes.
+ */
+bool NetplaySession_takeRollback(NetplaySession *self, Uint32 *frame,
+                                 const Uint8 **snapshot);
+void NetplaySession_addResimulation(NetplaySession *self, Uint32 frames,
+                                    Uint64 ns);
+// Whether the current frame can be simulated yet
+bool NetplaySession_canAdvance(NetplaySession *self);
+// This tick's input from the local player, which applies `input_delay`
+// frames from now
+void NetplaySession_addLocalInput(NetplaySession *self,
+                                  const InputState *input);
+// Every player's input for `frame`, guessed where it hasn't arrived
+void NetplaySession_getInputs(NetplaySession *self, Uint32 frame,
+                              InputState *inputs);
+// Where the state at the start of `frame` is kept
+Uint8 *NetplaySession_getSnapshot(NetplaySession *self, Uint32 frame);
+// Frames everyone's input has arrived for
+Uint32 NetplaySession_getConfirmed(const NetplaySession *self);
+// Moves to the next frame once its snapshot is saved, then sends
+void NetplaySession_advance(NetplaySession *self);
+// Our inputs and anything else the others are waiting on. Every tick needs
+// one, `NetplaySession_advance` already does it
+void NetplaySession_send(NetplaySession *self);
+void NetplaySession_logStats(const NetplaySession *self, double seconds);
+
+#endif // NETPLAY_H
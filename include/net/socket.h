@@ -0,0 +1,108 @@
+/*
+    UDP Socket Structure
+    Copyright (C) 2025  Ashton Warner
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef NET_SOCKET_H
+#define NET_SOCKET_H
+
+#include <SDL3/SDL.h>
+#include <stdbool.h>
+
+#include "heap/allocator.h"
+#include "util/stack.h"
+
+// Bigger datagrams risk being fragmented on the way
+#define NET_PACKET_MAX 1200
+// IPv4 and UDP headers, which every datagram pays on top of its own bytes
+#define NET_HEADER_SIZE 28
+
+typedef struct NetAddress {
+  // IPv4, host byte order
+  Uint32 host;
+  Uint16 port;
+} NetAddress;
+
+// "HOST:PORT". Names are looked up, which can block
+bool NetAddress_parse(const char *text, NetAddress *out);
+#define NetAddress_equals(A, B) ((A).host == (B).host && (A).port == (B).port)
+
+/** \brief A worse connection than the real one, for testing
+ *
+ * Applied to packets on their way out, so both ends need it to make the
+ * whole trip worse.
+ */
+typedef struct NetConditions {
+  // Every packet is held this long, plus up to `jitter_ns` more. Jitter
+  // lets packets overtake each other
+  Uint64 latency_ns;
+  Uint64 jitter_ns;
+  // Chance in [0, 1] that a packet is dropped
+  float loss;
+} NetConditions;
+
+typedef struct NetHeldPacket {
+  Uint64 due;
+  NetAddress to;
+  size_t length;
+  Uint8 data[NET_PACKET_MAX];
+} NetHeldPacket;
+
+typedef struct NetSocketStats {
+  Uint64 packets_sent;
+  Uint64 bytes_sent;
+  Uint64 packets_received;
+  Uint64 bytes_received;
+  // Thrown away by `NetConditions` and by the kernel refusing them
+  Uint64 packets_dropped;
+  Uint64 send_errors;
+} NetSocketStats;
+
+/** \brief Non-blocking IPv4 UDP socket
+ *
+ * Nothing waits, sends either go out, are held back by the conditions or
+ * are lost, and receives return straight away when nothing has arrived.
+ * Times are passed in, so tests can run faster than real time.
+ */
+typedef struct NetSocket {
+  Allocator *allocator;
+  int fd;
+  // Where we're bound. The port is picked for us when asked for 0
+  NetAddress address;
+
+  NetConditions conditions;
+  Uint64 random;
+  // Packets the conditions are holding back, in no particular order
+  Stack(NetHeldPacket) held;
+
+  NetSocketStats stats;
+} NetSocket;
+
+// Binds every interface on `port`. NULL if the port can't be had
+NetSocket *NetSocket_open(Allocator *allocator, Uint16 port);
+void NetSocket_close(NetSocket *self);
+// `seed` picks which packets are lost, so runs can be repeated
+void NetSocket_setConditions(NetSocket *self, NetConditions conditions,
+                             Uint64 seed);
+void NetSocket_send(NetSocket *self, NetAddress to, const Uint8 *data,
+                    size_t length, Uint64 now);
+// Sends every held packet that is due by `now`
+void NetSocket_flush(NetSocket *self, Uint64 now);
+// Bytes of the next datagram, 0 once nothing is waiting
+size_t NetSocket_receive(NetSocket *self, NetAddress *from, Uint8 *buffer,
+                         size_t capacity);
+
+#endif // NET_SOCKET_H
@@ -0,0 +1,80 @@
+/*
+    Texture Atlas Structure
+    Copyright (C) 2025  Ashton Warner
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef ATLAS_H
+#define ATLAS_H
+
+#include <SDL3/SDL.h>
+#include <stdbool.h>
+
+#include "heap/allocator.h"
+#include "screen/render_list.h"
+#include "util/stack.h"
+
+#ifndef ATLAS_PAGE_SIZE
+#define ATLAS_PAGE_SIZE 1024
+#endif
+
+typedef int AtlasRegionId;
+#define ATLAS_REGION_INVALID -1
+
+typedef struct AtlasRegion {
+  size_t page;
+  SDL_Texture *texture;
+  RenderTextureId texture_id;
+  // Pixel rectangle inside the page and the same rectangle in [0, 1] UVs
+  SDL_Rect rect;
+  SDL_FRect uv;
+} AtlasRegion;
+
+typedef struct AtlasPage {
+  SDL_Surface *surface;
+  SDL_Texture *texture;
+  RenderTextureId texture_id;
+} AtlasPage;
+
+/** \brief Packs many small images into a few large textures
+ *
+ * Images are queued with `TextureAtlas_addImage`/`TextureAtlas_addSurface`
+ * and packed all at once by `TextureAtlas_build` at load time. Region
+ * pointers are only stable after the atlas has been built.
+ */
+typedef struct TextureAtlas {
+  Allocator *allocator;
+  int page_size;
+  int padding;
+  bool built;
+
+  Stack(SDL_Surface *) images;
+  Stack(AtlasRegion) regions;
+  Stack(AtlasPage) pages;
+} TextureAtlas;
+
+TextureAtlas TextureAtlas_create(Allocator *allocator, int page_size);
+void TextureAtlas_destroy(TextureAtlas *self);
+
+AtlasRegionId TextureAtlas_addImage(TextureAtlas *self, const char *path);
+/** \brief Queue a surface for packing. The atlas takes ownership of it */
+AtlasRegionId TextureAtlas_addSurface(TextureAtlas *self, SDL_Surface *surface);
+
+bool TextureAtlas_build(TextureAtlas *self, SDL_Renderer *renderer,
+                        RenderList *render_list);
+const AtlasRegion *TextureAtlas_getRegion(const TextureAtlas *self,
+                                          AtlasRegionId id);
+
+#endif // ATLAS_H
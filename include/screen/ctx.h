@@ -19,6 +19,7 @@
 #ifndef CTX_H
 #define CTX_H
 
+#include "screen/render_list.h"
 #include "util/stack.h"
 #include <SDL3/SDL.h>
 
@@ -28,13 +29,25 @@ typedef struct Camera2D {
 
 } Camera2D;
 
+/** \brief Per-thread rendering state
+ *
+ * \param commands    when commands == NULL. Draws go straight to the renderer
+ */
 typedef struct RenderContext {
   SDL_Renderer *renderer;
+  RenderShard *commands;
   Stack(SDL_FPoint) transforms;
 } RenderContext;
 
-RenderContext RenderContext_create(SDL_Renderer *renderer);
+RenderContext RenderContext_create(SDL_Renderer *renderer,
+                                   RenderShard *commands);
 SDL_FPoint RenderContext_getTransform(RenderContext *self);
+void RenderContext_fillRect(RenderContext *self, Uint8 layer,
+                            const SDL_FRect *rect, SDL_Color color);
+void RenderContext_drawSprite(RenderContext *self, Uint8 layer,
+                              SDL_Texture *texture, RenderTextureId texture_id,
+                              const SDL_FRect *dst, const SDL_FRect *uv,
+                              SDL_FColor tint);
 void RenderContext_destroy(RenderContext *self);
 
 #endif // CTX_H
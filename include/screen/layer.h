@@ -0,0 +1,58 @@
+/*
+    Cached Render Layer Structure
+    Copyright (C) 2025  Ashton Warner
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef LAYER_H
+#define LAYER_H
+
+#include <SDL3/SDL.h>
+#include <stdbool.h>
+
+#include "en/obj.h"
+#include "screen/ctx.h"
+#include "screen/render_list.h"
+
+/** \brief Static content rendered once into a texture
+ *
+ * The tree under `root` is only redrawn when something in it is marked dirty
+ * or the viewport changes size. Every other frame it costs one texture copy.
+ */
+typedef struct CachedLayer {
+  Camera2D camera;
+  RenderList commands;
+  RenderTextureId texture_id;
+  Uint8 layer;
+
+  Object2D *root;
+  bool dirty;
+  size_t redraws;
+} CachedLayer;
+
+CachedLayer CachedLayer_create(Allocator *allocator, Object2D *root,
+                               Uint8 layer);
+void CachedLayer_destroy(CachedLayer *self);
+void CachedLayer_invalidate(CachedLayer *self);
+
+/** \brief Redraw the cached texture if it is out of date
+ *
+ * Must run on the main thread, outside of any other render target.
+ */
+void CachedLayer_update(CachedLayer *self, SDL_Renderer *renderer,
+                        RenderList *frame_list, SDL_FPoint origin);
+void CachedLayer_composite(const CachedLayer *self, RenderShard *shard);
+
+#endif // LAYER_H
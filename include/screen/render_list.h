@@ -0,0 +1,160 @@
+/*
+    Sorted Render Command List Structure
+    Copyright (C) 2025  Ashton Warner
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef RENDER_LIST_H
+#define RENDER_LIST_H
+
+#include <SDL3/SDL.h>
+
+#include "heap/allocator.h"
+#include "util/jobs.h"
+#include "util/slice.h"
+#include "util/stack.h"
+
+// Layers are drawn in ascending order. Inside a layer commands are grouped by
+// renderer state, so anything that has to overlap in a fixed order needs its
+// own layer.
+#define RENDER_LAYER_BACKGROUND 0
+#define RENDER_LAYER_WORLD 64
+#define RENDER_LAYER_FOREGROUND 128
+#define RENDER_LAYER_HUD 192
+
+enum RenderCommandKind {
+  RENDER_FILL_RECT,
+  RENDER_GEOMETRY,
+  RENDER_TEXTURE,
+};
+
+// 0 is reserved for "no texture"
+typedef Uint16 RenderTextureId;
+#define RENDER_TEXTURE_NONE 0
+#define RENDER_TEXTURE_MAX 0xFFF
+
+/** \brief Sort key layout, most significant bits first
+ *
+ * | layer 8 | kind 4 | texture 12 | color rgba 32 | unused 8 |
+ */
+#define RenderKey_create(LAYER, KIND, TEXTURE, COLOR)                          \
+  (((Uint64)(Uint8)(LAYER) << 56) | ((Uint64)((KIND) & 0xF) << 52) |          \
+   ((Uint64)((TEXTURE) & 0xFFF) << 40) | ((Uint64)(Uint32)(COLOR) << 8))
+#define RenderKey_getLayer(KEY) ((Uint8)((KEY) >> 56))
+#define RenderKey_getKind(KEY) ((enum RenderCommandKind)(((KEY) >> 52) & 0xF))
+#define RenderKey_getTexture(KEY) ((RenderTextureId)(((KEY) >> 40) & 0xFFF))
+#define RenderKey_getColor(KEY) ((Uint32)((KEY) >> 8))
+
+#define RenderColor_pack(COLOR)                                                \
+  (((Uint32)(COLOR).r << 24) | ((Uint32)(COLOR).g << 16) |                     \
+   ((Uint32)(COLOR).b << 8) | (Uint32)(COLOR).a)
+
+typedef struct RenderCommand {
+  Uint64 key;
+  // Which shard recorded the command and the index of its geometry there
+  Uint32 shard;
+  Uint32 geometry;
+} RenderCommand;
+
+typedef struct RenderGeometry {
+  Uint32 first_vertex;
+  Uint32 vertex_count;
+  Uint32 first_index;
+  Uint32 index_count;
+} RenderGeometry;
+
+/** \brief Command buffer owned by a single recording thread
+ *
+ * Geometry lives next to the commands so recording never touches shared
+ * state. `RenderList_sort` merges every shard afterwards.
+ */
+typedef struct RenderShard {
+  Stack(RenderCommand) commands;
+  Stack(SDL_FRect) rects;
+  Stack(SDL_Vertex) vertices;
+  Stack(int) indices;
+  Stack(RenderGeometry) geometry;
+} RenderShard;
+
+typedef struct RenderStats {
+  size_t commands;
+  size_t draw_calls;
+  size_t state_changes;
+} RenderStats;
+
+typedef struct RenderList {
+  Allocator *allocator;
+  Slice(RenderShard) shards;
+
+  Stack(RenderCommand) sorted;
+  Stack(RenderCommand) scratch;
+  Stack(SDL_Texture *) textures;
+
+  // Reused between frames when merging runs of commands into one draw call
+  Stack(SDL_FRect) batch_rects;
+  Stack(SDL_Vertex) batch_vertices;
+  Stack(int) batch_indices;
+
+  RenderStats stats;
+} RenderList;
+
+/** \brief Create a command list with one shard per recording thread
+ *
+ * \param allocator   must be thread safe when shards are recorded from
+ *                    worker threads, since shards grow while recording
+ */
+RenderList RenderList_create(Allocator *allocator, size_t shard_count);
+void RenderList_destroy(RenderList *self);
+
+RenderTextureId RenderList_addTexture(RenderList *self, SDL_Texture *texture);
+void RenderList_setTexture(RenderList *self, RenderTextureId id,
+                           SDL_Texture *texture);
+SDL_Texture *RenderList_getTexture(const RenderList *self, RenderTextureId id);
+/** \brief Copy the texture table of `parent` so its ids are valid here */
+void RenderList_inheritTextures(RenderList *self, const RenderList *parent);
+RenderShard *RenderList_getShard(RenderList *self, size_t index);
+
+void RenderList_clear(RenderList *self);
+void RenderList_sort(RenderList *self);
+void RenderList_submit(RenderList *self, SDL_Renderer *renderer);
+
+/** \brief Record the render callbacks of every root into the shards
+ *
+ * Roots are split evenly between the shards and recorded on `jobs`. Render
+ * callbacks must only read object state and write to their own context.
+ */
+struct Object2D;
+void RenderList_record(RenderList *self, JobPool *jobs, SDL_Renderer *renderer,
+                       struct Object2D **roots, size_t root_count,
+                       SDL_FPoint origin);
+
+void RenderShard_fillRect(RenderShard *self, Uint8 layer, const SDL_FRect *rect,
+                          SDL_Color color);
+// `indices` may be NULL with an `index_count` of 0 for a plain triangle list
+void RenderShard_geometry(RenderShard *self, Uint8 layer,
+                          RenderTextureId texture, const SDL_Vertex *vertices,
+                          int vertex_count, const int *indices,
+                          int index_count);
+/** \brief Record a textured quad. Quads sharing a layer and texture are drawn
+ * with a single `SDL_RenderGeometry` call
+ */
+void RenderShard_sprite(RenderShard *self, Uint8 layer,
+                        RenderTextureId texture, const SDL_FRect *dst,
+                        const SDL_FRect *uv, SDL_FColor tint);
+void RenderShard_texture(RenderShard *self, Uint8 layer,
+                         RenderTextureId texture, const SDL_FRect *src,
+                         const SDL_FRect *dst);
+
+#endif // RENDER_LIST_H
@@ -0,0 +1,61 @@
+/*
+    Worker Thread Job Pool Structure
+    Copyright (C) 2025  Ashton Warner
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef JOBS_H
+#define JOBS_H
+
+#include <SDL3/SDL.h>
+#include <stdbool.h>
+
+#include "heap/allocator.h"
+
+/** \brief Job callback. `index` is the job number in [0, count) and `worker`
+ * is the thread running it in [0, JobPool_getThreadCount())
+ */
+typedef void (*JobFn)(void *data, size_t index, size_t worker);
+
+/** \brief Persistent pool of worker threads
+ *
+ * The thread calling `JobPool_run` takes part in the work, so a pool with
+ * zero workers still runs every job (serially on the caller).
+ */
+typedef struct JobPool {
+  Allocator *allocator;
+
+  size_t worker_count;
+  SDL_Thread **workers;
+
+  SDL_Mutex *mutex;
+  SDL_Condition *wake;
+  SDL_Condition *done;
+
+  JobFn fn;
+  void *data;
+  size_t job_count;
+  size_t next_job;
+  size_t finished_jobs;
+  size_t generation;
+  bool running;
+} JobPool;
+
+JobPool *JobPool_create(Allocator *allocator, size_t worker_count);
+size_t JobPool_getThreadCount(const JobPool *self);
+void JobPool_run(JobPool *self, JobFn fn, void *data, size_t count);
+void JobPool_destroy(JobPool *self);
+
+#endif // JOBS_H
@@ -56,6 +56,25 @@
     (SELF).len += 1;                                                           \
   }
 
+// Grow the backing storage so at least COUNT elements fit without remapping.
+// Grows by at least half like `Stack_push`, so reserving a few more at a time
+// stays linear
+#define Stack_reserve(SELF, COUNT)                                             \
+  {                                                                            \
+    const size_t stack_count = (COUNT);                                        \
+    if ((SELF).data.len < stack_count) {                                       \
+      size_t stack_grown = (SELF).data.len * 1.5f;                             \
+      if (stack_grown < stack_count)                                           \
+        stack_grown = stack_count;                                             \
+      (SELF).data.ptr = (typeof((SELF).data.ptr))remapBlock(                   \
+          (SELF).allocator, (SELF).data.len * sizeof(*(SELF).data.ptr),        \
+          (char *)(SELF).data.ptr, sizeof(*(SELF).data.ptr), stack_grown);     \
+      (SELF).data.len = stack_grown;                                           \
+    }                                                                          \
+  }
+
+#define Stack_clear(SELF) ((SELF).len = 0)
+
 #define Stack_pop(SELF)                                                        \
   ({                                                                           \
     debugAssert((SELF).len > 0, #SELF ".len == 0");                            \
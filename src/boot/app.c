@@ -23,35 +23,105 @@
 #include <SDL3/SDL_timer.h>
 #include <box2d/box2d.h>
 #include <box2d/types.h>
+#include <errno.h>
 #include <stdio.h>
+#include <string.h>
 
-AppState *AppState_default(Allocator *allocator) {
+AppOptions AppOptions_default() {
+  return (AppOptions){
+      .vsync = false,
+      .frame_cap = true,
+      .idle_render = true,
+      // Physics ticks at 60Hz so faster frames show nothing new
+      .target_fps = 60.0,
+      .controller_count = 1,
+      .controller_cpu = -1,
+      .controller_realtime = false,
+      .replay_unpaced = false,
+      .headless = false,
+      .scene = STRESS_SCENE_NONE,
+      .scene_scale = 1.0f,
+      .level_path = NULL,
+      .profile_path = NULL,
+      .min_substeps = SUBSTEP_DEFAULT_MIN,
+      .max_substeps = SUBSTEP_DEFAULT_MAX,
+      .rollback = false,
+  };
+}
+
+AppState *AppState_create(Allocator *allocator, AppOptions options) {
+  Level *level_file = NULL;
+  if (options.level_path != NULL) {
+    level_file = Level_open(allocator, options.level_path);
+    if (level_file == NULL)
+      return NULL;
+  }
 
   b2WorldDef world_def = b2DefaultWorldDef();
   world_def.gravity = (b2Vec2){0.0f, 1.0f};
   b2WorldId world = b2CreateWorld(&world_def);
+  if (options.rollback) {
+    b2World_EnableWarmStarting(world, false);
+    b2World_EnableSleeping(world, false);
+  }
 
-  Player player = Player_create(world, 2.0f, -3.0f, NULL);
+  b2Vec2 spawn = {2.0f, -3.0f};
+  if (level_file != NULL) {
+    spawn = Level_getSpawn(level_file, LEVEL_SPAWN_PLAYER, 0, spawn);
+  }
+  Player player = Player_create(world, spawn.x, spawn.y, NULL);
 
   Object2D *testobj = allocPtr(allocator, sizeof(Object2D), 1);
   *testobj = TestObj_create(32.0f, 32.0f);
 
   Object2D_addChild(&player.super, testobj);
 
-  b2BodyDef grounddef = b2DefaultBodyDef();
-  grounddef.position = (b2Vec2){
-      0.0f,
-      0.0f,
-  };
-  b2BodyId ground = b2CreateBody(world, &grounddef);
+  Sprite *player_sprite = allocPtr(allocator, sizeof(Sprite), 1);
+  *player_sprite = Sprite_create(NULL, player.super.width, player.super.height);
+  player_sprite->super.layer = RENDER_LAYER_WORLD + 1;
+  Object2D_addChild(&player.super, &player_sprite->super);
 
-  b2Segment groundsegment = {
-      .point1 = (b2Vec2){0.0f, 0.0f},
-      .point2 = (b2Vec2){10.0f, 0.0f},
-  };
-  b2ShapeDef groundshapedef = b2DefaultShapeDef();
-  groundshapedef.density = 1.0f;
-  b2CreateSegmentShape(ground, &groundshapedef, &groundsegment);
+  // Static level geometry lives under its own root so it can be cached
+  Object2D *level = allocPtr(allocator, sizeof(Object2D), 1);
+  *level = Object2D_default();
+
+  Ground *ground = NULL;
+  LevelObject *level_object = NULL;
+  if (level_file != NULL) {
+    level_object = LevelObject_create(allocator, level_file, world);
+    Object2D_addChild(level, &level_object->super);
+  } else {
+    ground = allocPtr(allocator, sizeof(Ground), 1);
+    *ground = Ground_create(world, (b2Segment){
+                                       .point1 = (b2Vec2){0.0f, 0.0f},
+                                       .point2 = (b2Vec2){10.0f, 0.0f},
+                                   });
+    Object2D_addChild(level, &ground->super);
+  }
+
+  // To the right of everything the level and the player take up, so the
+  // scene doesn't pile onto either
+  if (options.scene != STRESS_SCENE_NONE) {
+    float right = b2Body_ComputeAABB(player.body).upperBound.x;
+    if (ground != NULL) {
+      right = SDL_max(right, b2Body_ComputeAABB(ground->body).upperBound.x);
+    }
+    for (size_t i = 0; level_object != NULL && i < level_object->body_count;
+         i++) {
+      right = SDL_max(right,
+                      b2Body_ComputeAABB(level_object->bodies[i]).upperBound.x);
+    }
+    const StressSceneInfo scene = StressScene_build(
+        options.scene, world, (b2Vec2){right + STRESS_SCENE_GAP, 0.0f},
+        options.scene_scale);
+    SDL_Log("Scene %s: %zu bodies, %zu shapes, %zu joints",
+            StressScene_getName(options.scene), scene.bodies, scene.shapes,
+            scene.joints);
+  }
+
+  // The main and fixed update threads are already busy
+  const int cores = SDL_GetNumLogicalCPUCores();
+  JobPool *jobs = JobPool_create(allocator, cores > 2 ? cores - 2 : 0);
 
   AppState *state = allocPtr(allocator, sizeof(AppState), 1);
   *state = (AppState){
@@ -59,19 +129,95 @@ AppState *AppState_default(Allocator *allocator) {
       .last_tick = SDL_GetTicks(),
       .running = true,
 
-      .controller_out = ControllerDevice_default(),
-      .options = {false, true},
+      .options = options,
+      .pacer = FramePacer_create(options.frame_cap ? options.target_fps : 0.0),
+      .substeps = SubstepController_create(60.0, options.min_substeps,
+                                           options.max_substeps),
+      .input_pending = true,
       .player = player,
       .testobj = testobj,
+      .player_sprite = player_sprite,
+      .player_image = ATLAS_REGION_INVALID,
+      .level = level,
+      .ground = ground,
+      .level_file = level_file,
+      .level_object = level_object,
       .world = world,
       .allocator = allocator,
 
+      .recorder = NULL,
+      .replay = NULL,
+      .netplay = NULL,
+      .netplay_input = NULL,
+
       .fixedUpdate_thread = NULL,
       .fixedUpdate_mutex = NULL,
+
+      .jobs = jobs,
+      // Shards grow on the job threads and the arena isn't thread safe
+      .render_list =
+          RenderList_create(&std_allocator, JobPool_getThreadCount(jobs)),
+      .atlas = TextureAtlas_create(allocator, ATLAS_PAGE_SIZE),
+      .static_layer =
+          CachedLayer_create(&std_allocator, level, RENDER_LAYER_BACKGROUND),
   };
+
+  // The player was copied into the state, so its children need to point at
+  // the copy
+  testobj->parent = &state->player.super;
+  player_sprite->super.parent = &state->player.super;
+  // Nothing draws a headless world, so there's nothing to pack
+  if (!options.headless) {
+    state->player_image = TextureAtlas_addSurface(
+        &state->atlas, Player_createImage((int)player.super.width,
+                                          (int)player.super.height));
+  }
+  state->pacer.idle_mode = state->options.idle_render;
+  state->latency_probe = LatencyProbe_create();
+  LatencyRecorder_reset(&state->latency);
+  state->analog =
+      AnalogStage_create(allocator, state->options.controller_count * 2);
+  // Rebinds free the old table on the fixed update thread
+  state->remap = RemapEngine_create(RemapTable_compile(
+      &std_allocator, REMAP_DEFAULT_BINDINGS, REMAP_DEFAULT_BINDING_COUNT));
+  state->gamepads = GamepadRoster_create();
+  // Headless worlds have nothing to write to, so they get no output thread
+  state->controllers = NULL;
+  if (!state->options.headless) {
+    state->controllers = ControllerManager_create(
+        allocator, state->options.controller_count,
+        (ControllerOutputOptions){
+            .cpu = state->options.controller_cpu,
+            .realtime = state->options.controller_realtime,
+            .latency = &state->latency,
+        });
+    // Creating uinput devices takes long enough to hold up the first frame.
+    // Until they exist the pads only keep their newest state
+    if (ControllerManager_start(state->controllers)) {
+      ControllerManager_openUinputAsync(state->controllers);
+    } else {
+      SDL_Log("Running without virtual pads");
+      ControllerManager_destroy(state->controllers);
+      state->controllers = NULL;
+    }
+  }
+  // Lets the physics sync find the object for the body
+  b2Body_SetUserData(state->player.body, &state->player.super);
+
+  Object2D *const roots[] = {&state->player.super, state->level};
+  state->snapshot = SnapshotLayout_create(allocator, world, roots,
+                                          sizeof(roots) / sizeof(*roots));
+  state->initial_snapshot =
+      allocPtr(allocator, 1, AppState_snapshotSize(state));
+  AppState_save(state, state->initial_snapshot);
+  SDL_SetAtomicInt(&state->reset_pending, 0);
   return state;
 }
 
+AppState *AppState_default(Allocator *allocator) {
+  return AppState_create(allocator, AppOptions_default());
+}
+
 void AppState_destroy(AppState *self) {
   debugAssert(self != NULL, "self == NULL");
   self->running = false;
@@ -84,9 +230,398 @@ void AppState_destroy(AppState *self) {
     self->fixedUpdate_mutex = NULL;
   }
 
+  if (self->controllers != NULL) {
+    ControllerManager_destroy(self->controllers);
+  }
+  GamepadRoster_destroy(&self->gamepads);
+  InputRecorder_destroy(self->recorder);
+  InputReplay_destroy(self->replay);
+  NetplaySession_destroy(self->netplay);
+  if (self->netplay_input != NULL) {
+    objrefcall(self->netplay_input, destroy);
+  }
+  RemapEngine_destroy(&self->remap);
+  AnalogStage_destroy(&self->analog);
+  SnapshotLayout_destroy(&self->snapshot);
+  freePtr(self->allocator, self->initial_snapshot);
+
+  JobPool_destroy(self->jobs);
+  RenderList_destroy(&self->render_list);
+  TextureAtlas_destroy(&self->atlas);
+  CachedLayer_destroy(&self->static_layer);
+
   Player_destroy(&self->player);
   freePtr(self->allocator, self->testobj);
+  freePtr(self->allocator, self->player_sprite);
+  Object2D_destroy(self->level);
+  if (self->ground != NULL) {
+    freePtr(self->allocator, self->ground);
+  }
+  if (self->level_object != NULL) {
+    freePtr(self->allocator, self->level_object);
+  }
+  freePtr(self->allocator, self->level);
+  // The level object drew straight out of the mapping
+  Level_close(self->level_file);
   b2DestroyWorld(self->world);
 
   freePtr(self->allocator, self);
 }
+
+// Publishes one tick's input to every player, the keyboard player first
+static void AppState_publishInputs(AppState *self, const InputState *inputs) {
+  const size_t pad_count = self->options.controller_count;
+  if (self->player.controller != NULL) {
+    PlayerController_publishState(self->player.controller, &inputs[0]);
+  }
+  for (size_t pad = 1; pad < pad_count && pad - 1 < GAMEPAD_MAX_PLAYERS;
+       pad++) {
+    PlayerController_publishState(
+        GamepadRoster_getController(&self->gamepads, pad - 1), &inputs[pad]);
+  }
+}
+
+// Publishes the replay's next tick to every player. False once it has ended
+static bool AppState_feedReplay(AppState *self) {
+  InputState inputs[CONTROLLER_MAX_PADS];
+  if (!InputReplay_next(self->replay, inputs, self->options.controller_count))
+    return false;
+  AppState_publishInputs(self, inputs);
+  return true;
+}
+
+// Runs every player's newest snapshot through the analog stage in one pass,
+// remaps it onto their pad and hands changed pads to the output thread.
+// Only the keyboard's events are traced. A NULL `trace` is a tick being
+// replayed, which only catches the smoothing up
+static void AppState_updatePads(AppState *self, LatencyTrace *trace) {
+  const size_t pad_count = self->options.controller_count;
+  InputState inputs[CONTROLLER_MAX_PADS];
+
+  for (size_t pad = 0; pad < pad_count; pad++) {
+    if (pad == 0) {
+      // The same snapshot the player used
+      inputs[pad] = self->player.controller != NULL
+                        ? *PlayerController_current(self->player.controller)
+                        : (InputState){0};
+    } else if (pad - 1 < GAMEPAD_MAX_PLAYERS) {
+      inputs[pad] = *PlayerController_read(
+          GamepadRoster_getController(&self->gamepads, pad - 1));
+    } else {
+      inputs[pad] = (InputState){0};
+    }
+    AnalogStage_setInput(&self->analog, pad * 2,
+                         inputs[pad].axes[INPUT_AXIS_X],
+                         inputs[pad].axes[INPUT_AXIS_Y]);
+    AnalogStage_setInput(&self->analog, pad * 2 + 1,
+                         inputs[pad].axes[INPUT_AXIS_RX],
+                         inputs[pad].axes[INPUT_AXIS_RY]);
+  }
+  // What the players saw this tick, before any processing
+  if (self->recorder != NULL && trace != NULL) {
+    InputRecorder_write(self->recorder, inputs, pad_count);
+  }
+  AnalogStage_process(&self->analog);
+
+  RemapEngine_update(&self->remap);
+  for (size_t pad = 0; pad < pad_count; pad++) {
+    InputState *input = &inputs[pad];
+    input->axes[INPUT_AXIS_X] = self->analog.out_x[pad * 2];
+    input->axes[INPUT_AXIS_Y] = self->analog.out_y[pad * 2];
+    input->axes[INPUT_AXIS_RX] = self->analog.out_x[pad * 2 + 1];
+    input->axes[INPUT_AXIS_RY] = self->analog.out_y[pad * 2 + 1];
+    RemapEngine_evaluate(&self->remap, input, &self->pads[pad]);
+  }
+  if (trace == NULL)
+    return;
+  if (LatencyTrace_active(trace)) {
+    LatencyTrace_mark(trace, LATENCY_TICK);
+  }
+
+  // Each pad is written as one report. Unchanged pads don't need to wake the
+  // output thread, and the trace ends here if the first one is unchanged
+  bool traced = false;
+  for (size_t pad = 0; pad < pad_count; pad++) {
+    if (self->controllers != NULL &&
+        SDL_memcmp(&self->pads[pad], &self->pads_submitted[pad],
+                   sizeof(ControllerState)) != 0 &&
+        ControllerManager_submit(self->controllers, pad, &self->pads[pad],
+                                 pad == 0 ? trace : NULL)) {
+      self->pads_submitted[pad] = self->pads[pad];
+      traced |= pad == 0;
+    }
+  }
+  if (!traced) {
+    LatencyRecorder_record(&self->latency, trace);
+  }
+}
+
+static void AppTickProfile_lap(AppTickProfile *self, enum AppPhase phase,
+                               Uint64 *mark) {
+  if (self == NULL)
+    return;
+  const Uint64 now = SDL_GetTicksNS();
+  self->phase_ns[phase] += now - *mark;
+  self->tick_ns[phase] = now - *mark;
+  *mark = now;
+}
+
+static void AppTickProfile_addWorld(AppTickProfile *self, b2Profile world) {
+  // Fast bodies are swept against tunneling in the bullets stage
+  self->tick_world_ms[APP_WORLD_PAIRS] = world.pairs;
+  self->tick_world_ms[APP_WORLD_COLLIDE] = world.collide;
+  self->tick_world_ms[APP_WORLD_SOLVE] = world.solve;
+  self->tick_world_ms[APP_WORLD_CONTINUOUS] = world.bullets;
+  self->tick_world_ms[APP_WORLD_SENSORS] = world.sensors;
+  for (size_t phase = 0; phase < APP_WORLD_COUNT; phase++) {
+    self->world_ms[phase] += self->tick_world_ms[phase];
+  }
+}
+
+static void AppTickProfile_writeRow(AppTickProfile *self) {
+  if (self->csv == NULL)
+    return;
+  fprintf(self->csv, "%s,%lu,%d", self->scene, (unsigned long)self->ticks,
+          self->tick_substeps);
+  for (size_t phase = 0; phase < APP_PHASE_COUNT; phase++) {
+    fprintf(self->csv, ",%.2f", self->tick_ns[phase] / 1e3);
+  }
+  for (size_t phase = 0; phase < APP_WORLD_COUNT; phase++) {
+    fprintf(self->csv, ",%.2f", self->tick_world_ms[phase] * 1e3);
+  }
+  fprintf(self->csv, "\n");
+}
+
+bool AppTickProfile_openCsv(AppTickProfile *self, const char *path,
+                            const char *scene) {
+  self->scene = scene;
+  if (path == NULL)
+    return true;
+
+  self->csv = fopen(path, "w");
+  if (self->csv == NULL) {
+    SDL_Log("Couldn't open %s for profiling: %s", path, strerror(errno));
+    return false;
+  }
+  static const char *names[APP_PHASE_COUNT] = APP_PHASE_NAMES;
+  static const char *world_names[APP_WORLD_COUNT] = APP_WORLD_PHASE_NAMES;
+  fprintf(self->csv, "scene,tick,substeps");
+  for (size_t phase = 0; phase < APP_PHASE_COUNT; phase++) {
+    fprintf(self->csv, ",%s_us", names[phase]);
+  }
+  for (size_t phase = 0; phase < APP_WORLD_COUNT; phase++) {
+    fprintf(self->csv, ",b2_%s_us", world_names[phase]);
+  }
+  fprintf(self->csv, "\n");
+  return true;
+}
+
+void AppTickProfile_closeCsv(AppTickProfile *self) {
+  if (self->csv != NULL) {
+    fclose(self->csv);
+    self->csv = NULL;
+  }
+}
+
+// Steps the world and updates the player from the inputs already published,
+// then works out the pads. Returns how long the world step took
+static Uint64 AppState_simulate(AppState *self, AppTickProfile *profile,
+                                bool replaying, Uint64 *mark) {
+  // Update our physics world
+  const float timestep = 1.0f / 60.0f;
+  const int substep_count = self->substeps.substeps;
+
+  // Prevent the Main thread from attempting to access box2d World
+  SDL_LockMutex(self->fixedUpdate_mutex);
+  const Uint64 step_started = SDL_GetTicksNS();
+  b2World_Step(self->world, timestep, substep_count);
+  const Uint64 step_ns = SDL_GetTicksNS() - step_started;
+  AppTickProfile_lap(profile, APP_PHASE_PHYSICS, mark);
+  if (profile != NULL) {
+    AppTickProfile_addWorld(profile, b2World_GetProfile(self->world));
+  }
+  // Only bodies that moved are written back and marked dirty
+  Object2D_syncBodies(self->world);
+  // Allow the Main thread to access box2d again
+  SDL_UnlockMutex(self->fixedUpdate_mutex);
+  AppTickProfile_lap(profile, APP_PHASE_SYNC, mark);
+
+  // The player reads the newest input snapshot during its update. Replayed
+  // ticks leave the probe's event for the real one
+  LatencyTrace trace = {0};
+  if (!replaying) {
+    trace = LatencyProbe_sample(&self->latency_probe);
+  }
+
+  // update our root player
+  // TODO replace with root scene node
+  objcall(self->player.super, update, self->delta_time);
+  AppTickProfile_lap(profile, APP_PHASE_UPDATE, mark);
+
+  AppState_updatePads(self, replaying ? NULL : &trace);
+  AppTickProfile_lap(profile, APP_PHASE_PADS, mark);
+  return step_ns;
+}
+
+// Rolls back and replays whatever was simulated with a wrong guess, then
+// publishes every player's input for this frame. False when the frame has to
+// wait for the others
+static bool AppState_syncNetplay(AppState *self) {
+  NetplaySession *session = self->netplay;
+  InputState inputs[NETPLAY_MAX_PLAYERS];
+
+  Uint32 from;
+  const Uint8 *snapshot;
+  if (NetplaySession_takeRollback(session, &from, &snapshot)) {
+    const Uint64 started = SDL_GetTicksNS();
+    if (AppState_restore(self, snapshot)) {
+      for (Uint32 frame = from; frame < session->frame; frame++) {
+        NetplaySession_getInputs(session, frame, inputs);
+        AppState_publishInputs(self, inputs);
+        Uint64 mark = SDL_GetTicksNS();
+        AppState_simulate(self, NULL, true, &mark);
+        AppState_save(self, NetplaySession_getSnapshot(session, frame + 1));
+      }
+      NetplaySession_addResimulation(session, session->frame - from,
+                                     SDL_GetTicksNS() - started);
+    } else {
+      SDL_Log("Couldn't roll back to frame %u", from);
+    }
+  }
+
+  if (!NetplaySession_canAdvance(session)) {
+    // They still need our inputs and acknowledgements while we wait
+    NetplaySession_send(session);
+    return false;
+  }
+  NetplaySession_addLocalInput(session,
+                               PlayerController_read(self->netplay_input));
+  NetplaySession_getInputs(session, session->frame, inputs);
+  AppState_publishInputs(self, inputs);
+  return true;
+}
+
+bool AppState_tick(AppState *self, AppTickProfile *profile) {
+  debugAssert(self != NULL, "self == NULL");
+  // The substeps adapt to these whether or not we're profiling
+  const Uint64 tick_started = SDL_GetTicksNS();
+  Uint64 mark = tick_started;
+
+  // The others wouldn't reset with us
+  if (SDL_SetAtomicInt(&self->reset_pending, 0) != 0 && self->netplay == NULL) {
+    AppState_restore(self, self->initial_snapshot);
+  }
+
+  // A replay or the network stands in for the controllers before anything
+  // reads them. Rollbacks are counted as input
+  if (self->netplay != NULL) {
+    if (!NetplaySession_poll(self->netplay))
+      return false;
+    if (!AppState_syncNetplay(self)) {
+      AppTickProfile_lap(profile, APP_PHASE_INPUT, &mark);
+      return true;
+    }
+  } else if (self->replay != NULL && !AppState_feedReplay(self)) {
+    return false;
+  }
+  AppTickProfile_lap(profile, APP_PHASE_INPUT, &mark);
+
+  const int substep_count = self->substeps.substeps;
+  const Uint64 step_ns = AppState_simulate(self, profile, false, &mark);
+  if (self->netplay != NULL) {
+    AppState_save(self, NetplaySession_getSnapshot(self->netplay,
+                                                   self->netplay->frame + 1));
+    NetplaySession_advance(self->netplay);
+  }
+
+  SubstepController_update(&self->substeps, step_ns,
+                          SDL_GetTicksNS() - tick_started);
+  if (profile != NULL) {
+    profile->ticks++;
+    profile->tick_substeps = substep_count;
+    AppTickProfile_writeRow(profile);
+  }
+  return true;
+}
+
+size_t AppState_snapshotSize(const AppState *self) {
+  debugAssert(self != NULL, "self == NULL");
+  return self->snapshot.size + self->analog.count * sizeof(float) * 2;
+}
+
+void AppState_save(const AppState *self, Uint8 *buffer) {
+  debugAssert(self != NULL, "self == NULL");
+  SnapshotLayout_save(&self->snapshot, buffer);
+
+  // The pads are remapped from scratch every tick, only the smoothing
+  // remembers earlier ones
+  const size_t stick_bytes = self->analog.count * sizeof(float);
+  Uint8 *sticks = &buffer[self->snapshot.size];
+  SDL_memcpy(sticks, self->analog.out_x, stick_bytes);
+  SDL_memcpy(&sticks[stick_bytes], self->analog.out_y, stick_bytes);
+}
+
+bool AppState_restore(AppState *self, const Uint8 *buffer) {
+  debugAssert(self != NULL, "self == NULL");
+  // The main thread draws the world between ticks
+  SDL_LockMutex(self->fixedUpdate_mutex);
+  const bool restored = SnapshotLayout_restore(&self->snapshot, buffer);
+  SDL_UnlockMutex(self->fixedUpdate_mutex);
+  if (!restored)
+    return false;
+
+  const size_t stick_bytes = self->analog.count * sizeof(float);
+  const Uint8 *sticks = &buffer[self->snapshot.size];
+  SDL_memcpy(self->analog.out_x, sticks, stick_bytes);
+  SDL_memcpy(self->analog.out_y, &sticks[stick_bytes], stick_bytes);
+  return true;
+}
+
+void AppState_requestReset(AppState *self) {
+  debugAssert(self != NULL, "self == NULL");
+  SDL_SetAtomicInt(&self->reset_pending, 1);
+}
+
+void AppState_startNetplay(AppState *self, NetplaySession *session,
+                           PlayerController *input) {
+  debugAssert(self != NULL, "self == NULL");
+  debugAssert(self->options.rollback, "netplay without options.rollback");
+  debugAssert(session->players == self->options.controller_count,
+              "%zu players on %zu pads", session->players,
+              self->options.controller_count);
+  debugAssert(session->snapshot_size == AppState_snapshotSize(self),
+              "%zu byte snapshots for a %zu byte state",
+              session->snapshot_size, AppState_snapshotSize(self));
+  self->netplay = session;
+  self->netplay_input = input;
+  // Every side has to step the same, whatever their machines manage
+  SubstepController_pin(&self->substeps,
+                        SDL_clamp(SUBSTEP_DEFAULT_START, self->substeps.min,
+                                  self->substeps.max));
+  AppState_save(self, NetplaySession_getSnapshot(session, 0));
+}
+
+void AppTickProfile_log(const AppTickProfile *self, double seconds) {
+  static const char *names[APP_PHASE_COUNT] = APP_PHASE_NAMES;
+
+  Uint64 total_ns = 0;
+  for (size_t phase = 0; phase < APP_PHASE_COUNT; phase++) {
+    total_ns += self->phase_ns[phase];
+  }
+  const double ticks = self->ticks > 0 ? (double)self->ticks : 1.0;
+
+  SDL_Log("%lu ticks in %.3fs, %.0f ticks/s, %.2fus per tick",
+          (unsigned long)self->ticks, seconds,
+          seconds > 0 ? self->ticks / seconds : 0.0, total_ns / 1e3 / ticks);
+  for (size_t phase = 0; phase < APP_PHASE_COUNT; phase++) {
+    SDL_Log("  %-8s %8.2fus %5.1f%%", names[phase],
+            self->phase_ns[phase] / 1e3 / ticks,
+            total_ns > 0 ? 100.0 * self->phase_ns[phase] / total_ns : 0.0);
+  }
+  // Box2D's stages overlap and run on its own clock, so no shares
+  static const char *world_names[APP_WORLD_COUNT] = APP_WORLD_PHASE_NAMES;
+  for (size_t phase = 0; phase < APP_WORLD_COUNT; phase++) {
+    SDL_Log("    b2 %-10s %8.2fus", world_names[phase],
+            self->world_ms[phase] * 1e3 / ticks);
+  }
+}
@@ -0,0 +1,183 @@
+/*
+    Batch World Simulation
+    Copyright (C) 2025  Ashton Warner
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "boot/batch.h"
+#include "boot/substep.h"
+#include "debug/debug.h"
+#include "en/ground.h"
+#include "en/player.h"
+#include "heap/arena_allocator.h"
+#include "input/replay.h"
+
+typedef struct BatchWorld {
+  BatchWorldDef def;
+  BatchWorldResult result;
+
+  // Holds the script. Only touched by whichever thread has the world at the
+  // time
+  ArenaAllocator arena;
+
+  b2WorldId world;
+  Ground ground;
+  Player player;
+  // Fed from the script by the stepping thread, which is also its reader
+  PlayerController controller;
+  InputReplay *script;
+} BatchWorld;
+
+BatchWorldDef BatchWorldDef_default() {
+  return (BatchWorldDef){
+      .scene = STRESS_SCENE_NONE,
+      .scene_scale = 1.0f,
+      .script = NULL,
+      .ticks = BATCH_TICK_RATE * 60,
+      .substeps = SUBSTEP_DEFAULT_START,
+  };
+}
+
+// The same level `AppState_create` builds, minus everything that draws
+static bool BatchWorld_init(BatchWorld *self, const BatchWorldDef *def) {
+  *self = (BatchWorld){
+      .def = *def,
+      .result = {0},
+      .controller =
+          {
+              .sample = NULL,
+              .destroy = NULL,
+              .channel = InputChannel_create(),
+          },
+      .script = NULL,
+  };
+  self->arena = ArenaAllocator_create(&std_allocator);
+
+  b2WorldDef world_def = b2DefaultWorldDef();
+  world_def.gravity = (b2Vec2){0.0f, 1.0f};
+  self->world = b2CreateWorld(&world_def);
+  self->ground = Ground_create(self->world, (b2Segment){
+                                                .point1 = (b2Vec2){0.0f, 0.0f},
+                                                .point2 = (b2Vec2){10.0f, 0.0f},
+                                            });
+  // Past the end of the ground, like the app builds it
+  if (def->scene != STRESS_SCENE_NONE) {
+    StressScene_build(def->scene, self->world,
+                      (b2Vec2){10.0f + STRESS_SCENE_GAP, 0.0f},
+                      def->scene_scale);
+  }
+  self->player = Player_create(self->world, 2.0f, -3.0f, &self->controller);
+
+  if (def->script != NULL) {
+    self->script = InputReplay_open(ArenaAllocator_getAllocator(&self->arena),
+                                    def->script);
+    if (self->script == NULL) {
+      self->result.failed = true;
+      return false;
+    }
+  }
+  return true;
+}
+
+static void BatchWorld_destroy(BatchWorld *self) {
+  InputReplay_destroy(self->script);
+  Player_destroy(&self->player);
+  Ground_destroy(&self->ground);
+  b2DestroyWorld(self->world);
+  ArenaAllocator_destroy(&self->arena);
+}
+
+static void BatchWorld_run(BatchWorld *self) {
+  const float timestep = 1.0f / BATCH_TICK_RATE;
+  bool scripted = self->script != NULL;
+
+  const Uint64 started = SDL_GetTicksNS();
+  for (Uint64 tick = 0; tick < self->def.ticks; tick++) {
+    InputState input = {0};
+    if (scripted) {
+      scripted = InputReplay_next(self->script, &input, 1);
+      PlayerController_publishState(&self->controller, &input);
+    }
+    b2World_Step(self->world, timestep, self->def.substeps);
+    Player_update(&self->player, timestep);
+  }
+  self->result.seconds = (SDL_GetTicksNS() - started) / 1e9;
+
+  const b2Counters counters = b2World_GetCounters(self->world);
+  self->result.ticks = self->def.ticks;
+  self->result.player_position = b2Body_GetPosition(self->player.body);
+  self->result.body_count = counters.bodyCount;
+  self->result.contact_count = counters.contactCount;
+}
+
+static void BatchSim_runJob(void *data, size_t index, size_t worker) {
+  BatchWorld *world = &((BatchWorld *)data)[index];
+  if (!world->result.failed) {
+    BatchWorld_run(world);
+  }
+}
+
+BatchResult BatchSim_run(JobPool *pool, Allocator *allocator,
+                         const BatchWorldDef *defs, size_t count,
+                         BatchWorldResult *results) {
+  debugAssert(pool != NULL, "pool == NULL");
+  debugAssert(defs != NULL || count == 0, "defs == NULL");
+
+  BatchResult total = {.worlds = count};
+  const size_t wave_size = SDL_min(count, (size_t)BATCH_WAVE_SIZE);
+  BatchWorld *worlds =
+      wave_size > 0 ? allocPtr(allocator, sizeof(BatchWorld), wave_size) : NULL;
+
+  for (size_t first = 0; first < count; first += wave_size) {
+    const size_t wave = SDL_min(wave_size, count - first);
+
+    // Creating worlds goes through Box2D's global world table
+    Uint64 mark = SDL_GetTicksNS();
+    for (size_t i = 0; i < wave; i++) {
+      BatchWorld_init(&worlds[i], &defs[first + i]);
+    }
+    total.setup_seconds += (SDL_GetTicksNS() - mark) / 1e9;
+
+    mark = SDL_GetTicksNS();
+    JobPool_run(pool, BatchSim_runJob, worlds, wave);
+    total.wall_seconds += (SDL_GetTicksNS() - mark) / 1e9;
+
+    mark = SDL_GetTicksNS();
+    for (size_t i = 0; i < wave; i++) {
+      const BatchWorldResult *result = &worlds[i].result;
+      if (result->failed) {
+        total.failed++;
+      } else {
+        total.ticks += result->ticks;
+        total.slowest_world_seconds =
+            SDL_max(total.slowest_world_seconds, result->seconds);
+      }
+      if (results != NULL) {
+        results[first + i] = *result;
+      }
+      BatchWorld_destroy(&worlds[i]);
+    }
+    total.setup_seconds += (SDL_GetTicksNS() - mark) / 1e9;
+  }
+  if (worlds != NULL) {
+    freePtr(allocator, worlds);
+  }
+
+  total.simulated_seconds = (double)total.ticks / BATCH_TICK_RATE;
+  total.throughput = total.wall_seconds > 0.0
+                         ? total.simulated_seconds / total.wall_seconds
+                         : 0.0;
+  return total;
+}
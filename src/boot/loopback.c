@@ -0,0 +1,268 @@
+/*
+    Netplay Loopback Test
+    Copyright (C) 2025  Ashton Warner
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "boot/loopback.h"
+#include "debug/debug.h"
+#include "en/player.h"
+
+#define LOOPBACK_HOST 0x7F000001
+
+typedef struct LoopbackPeer {
+  AppState *state;
+  AppTickProfile profile;
+  // The scripted input and how many more rounds it's held
+  Uint64 random;
+  InputState input;
+  Uint32 hold;
+  bool ended;
+} LoopbackPeer;
+
+LoopbackDef LoopbackDef_default() {
+  return (LoopbackDef){
+      .players = 2,
+      .ticks = 60 * 60,
+      .options = AppOptions_default(),
+      .input_delay = 2,
+      .conditions = {0},
+      .seed = 1,
+      .stagger = 0,
+  };
+}
+
+// Somebody pressing a direction and letting go, with the odd button and a
+// stick somewhere in between
+static void LoopbackPeer_script(LoopbackPeer *self) {
+  if (self->hold > 0) {
+    self->hold--;
+    return;
+  }
+  self->hold = 4 + SDL_rand_bits_r(&self->random) % 40;
+  const Uint32 bits = SDL_rand_bits_r(&self->random);
+  InputState input = {0};
+  input.axes[INPUT_AXIS_X] = (float)((int)(bits % 3) - 1);
+  input.axes[INPUT_AXIS_Y] = (bits & 0x4) ? -1.0f : 0.0f;
+  input.buttons = (bits >> 3) & 0x3;
+  if ((bits >> 5) % 4 == 0) {
+    input.axes[INPUT_AXIS_RX] = SDL_randf_r(&self->random) * 2.0f - 1.0f;
+  }
+  self->input = input;
+}
+
+static void LoopbackPeer_destroy(LoopbackPeer *self) {
+  if (self->state != NULL) {
+    AppState_destroy(self->state);
+    self->state = NULL;
+  }
+}
+
+static bool LoopbackPeer_init(LoopbackPeer *self, const LoopbackDef *def,
+                              size_t slot) {
+  AppOptions options = def->options;
+  options.headless = true;
+  options.rollback = true;
+  options.controller_count = def->players;
+  *self = (LoopbackPeer){
+      .state = AppState_create(&std_allocator, options),
+      .profile = {0},
+      .random = def->seed * NETPLAY_MAX_PLAYERS + slot,
+      .input = {0},
+      .hold = 0,
+      .ended = false,
+  };
+  if (self->state == NULL)
+    return false;
+  // Nothing samples it, the session publishes to it every frame
+  self->state->player.controller =
+      (PlayerController *)KeyboardController_default(&std_allocator);
+  return true;
+}
+
+// Frames whose checksum every player has, and how many of them disagree. The
+// newest of each player's checksums for a frame is the one that counts
+static void Loopback_recordChecksums(NetplayChecksum *table, size_t rows,
+                                     const LoopbackPeer *peers,
+                                     size_t players) {
+  for (size_t p = 0; p < players; p++) {
+    const NetplaySession *session = peers[p].state->netplay;
+    for (size_t i = 0; i < NETPLAY_CHECKSUMS; i++) {
+      const NetplayChecksum *checksum = &session->checksums[i];
+      const size_t row = checksum->frame / NETPLAY_CHECKSUM_INTERVAL;
+      if (checksum->frame != NETPLAY_NO_FRAME && row < rows)
+        table[row * players + p] = *checksum;
+    }
+  }
+}
+
+static void Loopback_compareChecksums(const NetplayChecksum *table,
+                                      size_t rows, size_t players,
+                                      LoopbackResult *result) {
+  for (size_t row = 0; row < rows; row++) {
+    const NetplayChecksum *checksums = &table[row * players];
+    bool everyone = true;
+    bool agree = true;
+    for (size_t p = 0; p < players; p++) {
+      everyone &= checksums[p].frame != NETPLAY_NO_FRAME;
+      agree &= checksums[p].hash == checksums[0].hash;
+    }
+    if (!everyone)
+      continue;
+    result->compared++;
+    result->mismatched += !agree;
+  }
+}
+
+// Compares every world at the newest frame all of them have confirmed and
+// still keep
+static void Loopback_compareWorlds(LoopbackPeer *peers, size_t players,
+                                   LoopbackResult *result) {
+  Uint32 frame = NETPLAY_NO_FRAME;
+  for (size_t p = 0; p < players; p++) {
+    const NetplaySession *session = peers[p].state->netplay;
+    frame = SDL_min(frame, SDL_min(NetplaySession_getConfirmed(session),
+                                   session->frame));
+  }
+  result->converged_frame = frame;
+  result->converged = true;
+  NetplaySession *first = peers[0].state->netplay;
+  for (size_t p = 0; p < players; p++) {
+    NetplaySession *session = peers[p].state->netplay;
+    // Someone got too far ahead to still have it
+    if (frame + NETPLAY_SNAPSHOTS <= session->frame + 1) {
+      result->converged = false;
+      return;
+    }
+    result->converged &=
+        SDL_memcmp(NetplaySession_getSnapshot(first, frame),
+                   NetplaySession_getSnapshot(session, frame),
+                   session->snapshot_size) == 0;
+  }
+}
+
+LoopbackResult Loopback_run(const LoopbackDef *def) {
+  debugAssert(def != NULL, "def == NULL");
+  debugAssert(def->players >= 2 && def->players <= NETPLAY_MAX_PLAYERS,
+              "%zu players", def->players);
+
+  LoopbackResult result = {.players = def->players};
+  LoopbackPeer peers[NETPLAY_MAX_PLAYERS] = {0};
+  NetSocket *sockets[NETPLAY_MAX_PLAYERS] = {0};
+  NetAddress addresses[NETPLAY_MAX_PLAYERS] = {0};
+  // Every session and socket runs on this instead of the real clock
+  Uint64 now = 0;
+
+  for (size_t p = 0; p < def->players; p++) {
+    sockets[p] = NetSocket_open(&std_allocator, 0);
+    if (sockets[p] == NULL || !LoopbackPeer_init(&peers[p], def, p)) {
+      result.failed = true;
+      break;
+    }
+    addresses[p] = (NetAddress){
+        .host = LOOPBACK_HOST,
+        .port = sockets[p]->address.port,
+    };
+  }
+  if (!result.failed) {
+    for (size_t p = 0; p < def->players; p++) {
+      NetplayDef netplay = NetplayDef_default();
+      netplay.players = def->players;
+      netplay.local = p;
+      SDL_memcpy(netplay.addresses, addresses, sizeof(addresses));
+      netplay.input_delay = def->input_delay;
+      netplay.conditions = def->conditions;
+      netplay.seed = def->seed * NETPLAY_MAX_PLAYERS + p;
+      netplay.clock = &now;
+
+      AppState *state = peers[p].state;
+      NetplaySession *session = NetplaySession_create(
+          &std_allocator, sockets[p], &netplay, AppState_snapshotSize(state));
+      sockets[p] = NULL;
+      PlayerController *input =
+          (PlayerController *)KeyboardController_default(&std_allocator);
+      PlayerController_publishState(input, &(InputState){0});
+      AppState_startNetplay(state, session, input);
+    }
+  }
+  for (size_t p = 0; p < def->players; p++) {
+    NetSocket_close(sockets[p]);
+  }
+  if (result.failed) {
+    for (size_t p = 0; p < def->players; p++) {
+      LoopbackPeer_destroy(&peers[p]);
+    }
+    return result;
+  }
+
+  // Long enough for the slowest packet to make a few round trips
+  const Uint64 trip_ticks =
+      (def->conditions.latency_ns + def->conditions.jitter_ns) /
+      NETPLAY_TICK_NS;
+  const Uint64 rounds = def->ticks + def->stagger * (def->players - 1) +
+                        LOOPBACK_DRAIN_TICKS + trip_ticks * 4;
+  const size_t rows = rounds / NETPLAY_CHECKSUM_INTERVAL + 1;
+  NetplayChecksum *checksums =
+      allocPtr(&std_allocator, sizeof(NetplayChecksum), rows * def->players);
+  for (size_t i = 0; i < rows * def->players; i++) {
+    checksums[i].frame = NETPLAY_NO_FRAME;
+  }
+
+  const Uint64 started = SDL_GetTicksNS();
+  for (Uint64 round = 0; round < rounds; round++) {
+    for (size_t p = 0; p < def->players; p++) {
+      LoopbackPeer *peer = &peers[p];
+      const Uint64 start = (Uint64)def->stagger * p;
+      if (round < start || peer->ended)
+        continue;
+      if (round - start < def->ticks) {
+        LoopbackPeer_script(peer);
+      } else {
+        peer->input = (InputState){0};
+      }
+      PlayerController_publishState(peer->state->netplay_input, &peer->input);
+      if (!AppState_tick(peer->state, &peer->profile)) {
+        peer->ended = true;
+        result.failed = true;
+      }
+    }
+    Loopback_recordChecksums(checksums, rows, peers, def->players);
+    now += NETPLAY_TICK_NS;
+  }
+  result.wall_seconds = (SDL_GetTicksNS() - started) / 1e9;
+  result.ticks = rounds;
+
+  Loopback_compareChecksums(checksums, rows, def->players, &result);
+  Loopback_compareWorlds(peers, def->players, &result);
+  freePtr(&std_allocator, checksums);
+
+  result.confirmed = NETPLAY_NO_FRAME;
+  for (size_t p = 0; p < def->players; p++) {
+    const NetplaySession *session = peers[p].state->netplay;
+    const AppTickProfile *profile = &peers[p].profile;
+    Uint64 tick_ns = 0;
+    for (size_t phase = 0; phase < APP_PHASE_COUNT; phase++) {
+      tick_ns += profile->phase_ns[phase];
+    }
+    result.confirmed =
+        SDL_min(result.confirmed, NetplaySession_getConfirmed(session));
+    result.stats[p] = session->stats;
+    result.tick_us[p] = profile->ticks > 0 ? tick_ns / 1e3 / profile->ticks
+                                           : 0.0;
+    LoopbackPeer_destroy(&peers[p]);
+  }
+  result.simulated_seconds = result.confirmed / 60.0;
+  return result;
+}
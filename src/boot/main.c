@@ -35,10 +35,15 @@
 #include <SDL3/SDL_timer.h>
 
 #include "boot/app.h"
+#include "boot/batch.h"
+#include "boot/loopback.h"
+#include "boot/startup.h"
 #include "debug/debug.h"
 #include "debug/debug_draw.h"
 #include "en/player.h"
 #include "heap/allocator.h"
+#include "heap/counting_allocator.h"
+#include "input/backend.h"
 #include "screen/ctx.h"
 #include "util/safe.h"
 
@@ -52,6 +57,11 @@ bool *KEYS = NULL;
 ArenaAllocator global_arena_allocator;
 Allocator *global_allocator;
 
+// Time to first frame, and to the controllers being usable
+static StartupProfile startup;
+static bool startup_frame_logged = false;
+static bool startup_controllers_logged = false;
+
 #ifdef DEBUG
 // Signal Handler
 static void sigint_handler(int sig) {
@@ -68,59 +78,519 @@ static void sigint_handler(int sig) {
 }
 #endif
 
+// Controllers only take one publishing thread. During a replay or netplay
+// that is the fixed update, so the main thread keeps out. Netplay takes the
+// keyboard through a controller of its own, and local gamepads sit out
+static void publishInput(AppState *state, PlayerController *controller) {
+  if (state->netplay != NULL) {
+    if (controller == state->player.controller) {
+      PlayerController_publish(state->netplay_input);
+    }
+  } else if (state->replay == NULL) {
+    PlayerController_publish(controller);
+  }
+}
+
+static void logSubsteps(const SubstepController *substeps) {
+  const SubstepStats *stats = &substeps->stats;
+  SDL_Log("  %d substeps in [%d, %d], raised %lu lowered %lu, %lu overruns, "
+          "step %.2fus max %.2fus",
+          substeps->substeps, substeps->min, substeps->max,
+          (unsigned long)stats->raised, (unsigned long)stats->lowered,
+          (unsigned long)stats->overruns, stats->average_step_ns / 1e3,
+          stats->max_step_ns / 1e3);
+}
+
 // Fixed Update Loop for main object updating
 // Box2D works best in a fixed update
 static SDL_AppResult fixedUpdate(AppState *state) {
   debugAssert(state != NULL, "appstate == NULL");
   double last_tick = (double)SDL_GetTicks();
 
+  // Replays and profiled runs are timed as a benchmark
+  const Uint64 started = SDL_GetTicksNS();
+  AppTickProfile profile = {0};
+  // Profiling just stays off if the file can't be opened
+  AppTickProfile_openCsv(&profile, state->options.profile_path,
+                         StressScene_getName(state->options.scene));
+
   // Our appstate needs to let us know when to stop
   while (state->running) {
-
-    // Update our physics world
-    const float timestep = 1.0f / 60.0f;
-    const int substep_count = 4;
-
-    // Prevent the Main thread from attempting to access box2d World
-    SDL_LockMutex(state->fixedUpdate_mutex);
-    b2World_Step(state->world, timestep, substep_count);
-    // Allow the Main thread to access box2d again
-    SDL_UnlockMutex(state->fixedUpdate_mutex);
-
-    // update our root player
-    // TODO replace with root scene node
-    objcall(state->player.super, update, state->delta_time);
+    if (!AppState_tick(state, &profile)) {
+      SDL_Log(state->netplay != NULL ? "Netplay ended" : "Replay finished");
+      state->running = false;
+      break;
+    }
 
     // Frame capping
     const double fps_tick = (double)SDL_GetTicks();
     const double wanted_frame_tick = 1000 / 60.0;
     const double dif = fps_tick - last_tick;
-    if (dif >= 0.0f) {
-      SDL_Delay(wanted_frame_tick - dif);
+    const bool paced =
+        state->replay == NULL || !state->options.replay_unpaced;
+    // An overrun tick goes straight into the next one
+    if (paced && dif >= 0.0f && dif < wanted_frame_tick) {
+      SDL_Delay((Uint32)(wanted_frame_tick - dif));
     }
     last_tick = SDL_GetTicks();
   }
+  AppTickProfile_closeCsv(&profile);
+  const double seconds = (SDL_GetTicksNS() - started) / 1e9;
+  if (state->replay != NULL || state->options.profile_path != NULL) {
+    AppTickProfile_log(&profile, seconds);
+    logSubsteps(&state->substeps);
+  }
+  if (state->netplay != NULL) {
+    NetplaySession_logStats(state->netplay, seconds);
+  }
   return SDL_APP_SUCCESS;
 }
 
+// `--controller-bench N [PATH]` pushes N reports through the controller
+// output path without a window. Reports go to memory, or are recorded to PATH
+static SDL_AppResult runControllerBenchmark(int argc, char *argv[]) {
+  const size_t reports = SDL_strtoul(argv[0], NULL, 10);
+  const char *path = argc > 1 ? argv[1] : NULL;
+
+  MemoryBackend *sink = NULL;
+  ControllerBackend *backend;
+  if (path != NULL) {
+    backend = RecorderBackend_create(&std_allocator, path);
+    if (backend == NULL)
+      return SDL_APP_FAILURE;
+  } else {
+    sink = MemoryBackend_create(&std_allocator, 1 << 16);
+    backend = &sink->super;
+  }
+
+  ControllerDevice device = ControllerDevice_create(backend);
+  const ControllerBenchmark result =
+      ControllerDevice_benchmark(&device, reports);
+  SDL_Log("%s: %lu reports, %lu unchanged, %lu events, %lu failed in %.3fs "
+          "(%.0f reports/s)",
+          backend->name, (unsigned long)result.reports,
+          (unsigned long)result.unchanged, (unsigned long)result.events,
+          (unsigned long)result.failed, result.seconds,
+          result.reports / result.seconds);
+
+  // The sink decoded the stream on its own. It has to agree with the device
+  bool valid = result.failed == 0;
+  if (sink != NULL) {
+    valid = valid && sink->written == result.events &&
+            sink->unknown_codes == 0 &&
+            SDL_memcmp(&sink->state, &device.sent, sizeof(device.sent)) == 0;
+    SDL_Log("event stream %s", valid ? "matches" : "DOES NOT match");
+  }
+
+  ControllerDevice_destroy(&device);
+  return valid ? SDL_APP_SUCCESS : SDL_APP_FAILURE;
+}
+
+// `--analog-bench STICKS ITERATIONS` times the vector and scalar analog paths
+// and checks they agree
+static SDL_AppResult runAnalogBenchmark(int argc, char *argv[]) {
+  char *sticks_end;
+  char *iterations_end = "";
+  const size_t sticks = SDL_strtoul(argv[0], &sticks_end, 10);
+  const size_t iterations =
+      argc > 1 ? SDL_strtoul(argv[1], &iterations_end, 10) : 1000;
+  if (*sticks_end != '\0' || *iterations_end != '\0' || sticks == 0 ||
+      iterations == 0) {
+    SDL_Log("Usage: --analog-bench STICKS [ITERATIONS], both above 0");
+    return SDL_APP_FAILURE;
+  }
+
+  const AnalogBenchmark result = AnalogStage_benchmark(sticks, iterations);
+  SDL_Log("%zu sticks x %zu: scalar %.2fns/stick, vector %.2fns/stick, "
+          "max difference %d",
+          sticks, iterations, result.scalar_ns_per_stick,
+          result.vector_ns_per_stick, (int)result.max_difference);
+
+  // Only rounding of exact halves may differ
+  return result.max_difference <= 1 ? SDL_APP_SUCCESS : SDL_APP_FAILURE;
+}
+
+// `--scene NAME` adds a stress scene, `--scene-scale F` resizes it,
+// `--profile PATH` writes every tick's timings as CSV, `--unpaced` runs
+// replays flat out, `--substeps MIN MAX` bounds the physics substeps,
+// `--pads N` creates a virtual pad for the keyboard and N - 1 gamepads and
+// `--realtime-pads` raises the controller output thread to realtime priority
+static bool parseOptions(AppOptions *options, int argc, char *argv[]) {
+  for (int i = 1; i < argc; i++) {
+    if (SDL_strcmp(argv[i], "--scene") == 0 && i + 1 < argc) {
+      options->scene = StressScene_fromName(argv[++i]);
+      if (options->scene == STRESS_SCENE_COUNT) {
+        SDL_Log("There is no scene called %s", argv[i]);
+        return false;
+      }
+    } else if (SDL_strcmp(argv[i], "--scene-scale") == 0 && i + 1 < argc) {
+      options->scene_scale = (float)SDL_atof(argv[++i]);
+      if (!(options->scene_scale > 0.0f)) {
+        SDL_Log("Scene scale needs to be above 0");
+        return false;
+      }
+    } else if (SDL_strcmp(argv[i], "--level") == 0 && i + 1 < argc) {
+      options->level_path = argv[++i];
+    } else if (SDL_strcmp(argv[i], "--profile") == 0 && i + 1 < argc) {
+      options->profile_path = argv[++i];
+    } else if (SDL_strcmp(argv[i], "--unpaced") == 0) {
+      options->replay_unpaced = true;
+    } else if (SDL_strcmp(argv[i], "--pads") == 0 && i + 1 < argc) {
+      const int pads = SDL_atoi(argv[++i]);
+      const int max_pads =
+          SDL_min(CONTROLLER_MAX_PADS, GAMEPAD_MAX_PLAYERS + 1);
+      if (pads <= 0 || pads > max_pads) {
+        SDL_Log("Pads need 0 < N <= %d", max_pads);
+        return false;
+      }
+      options->controller_count = (size_t)pads;
+    } else if (SDL_strcmp(argv[i], "--realtime-pads") == 0) {
+      options->controller_realtime = true;
+    } else if (SDL_strcmp(argv[i], "--substeps") == 0 && i + 2 < argc) {
+      options->min_substeps = SDL_atoi(argv[++i]);
+      options->max_substeps = SDL_atoi(argv[++i]);
+      if (options->min_substeps <= 0 ||
+          options->min_substeps > options->max_substeps) {
+        SDL_Log("Substeps need 0 < MIN <= MAX");
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+// `--record PATH` saves every tick's input and `--replay PATH` plays one back
+// instead of the controllers, stepping with the substeps it was recorded with
+static bool parseRunArgs(AppState *state, int argc, char *argv[]) {
+  const char *record_path = NULL;
+  for (int i = 1; i < argc; i++) {
+    if (SDL_strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+      record_path = argv[++i];
+    } else if (SDL_strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+      state->replay = InputReplay_open(global_allocator, argv[++i]);
+      if (state->replay == NULL)
+        return false;
+    }
+  }
+  // Adapting to the machine would make a replay step differently from the
+  // session it recorded
+  if (state->replay != NULL) {
+    SubstepController_pin(&state->substeps, state->replay->substeps);
+  } else if (record_path != NULL) {
+    SubstepController_pin(&state->substeps, state->substeps.substeps);
+  }
+  if (record_path != NULL) {
+    // The recording keeps the count in a byte
+    if (state->substeps.substeps > 0xFF) {
+      SDL_Log("Can't record with more than 255 substeps");
+      return false;
+    }
+    state->recorder = InputRecorder_create(
+        global_allocator, record_path, state->options.controller_count, 60,
+        state->substeps.substeps);
+    if (state->recorder == NULL)
+      return false;
+  }
+  return true;
+}
+
+// `--netplay SLOT HOST:PORT,HOST:PORT,...` joins a game as player SLOT, with
+// every player's address in slot order. `--net-delay N` holds our input back
+// N ticks, and `--net-latency MS`, `--net-jitter MS` and `--net-loss PERCENT`
+// make the connection worse for testing. Every side needs the same level,
+// scene and substeps
+static bool parseNetplay(NetplayDef *def, int argc, char *argv[]) {
+  for (int i = 1; i < argc; i++) {
+    if (SDL_strcmp(argv[i], "--netplay") == 0 && i + 2 < argc) {
+      def->local = SDL_strtoul(argv[++i], NULL, 10);
+      char list[1024];
+      SDL_strlcpy(list, argv[++i], sizeof(list));
+      def->players = 0;
+      char *rest = NULL;
+      for (char *address = SDL_strtok_r(list, ",", &rest); address != NULL;
+           address = SDL_strtok_r(NULL, ",", &rest)) {
+        if (def->players == NETPLAY_MAX_PLAYERS) {
+          SDL_Log("Netplay takes at most %d players", NETPLAY_MAX_PLAYERS);
+          return false;
+        }
+        if (!NetAddress_parse(address, &def->addresses[def->players++]))
+          return false;
+      }
+      if (def->players < 2 || def->local >= def->players) {
+        SDL_Log("Netplay needs two or more addresses and a slot among them");
+        return false;
+      }
+      def->seed = def->local;
+    } else if (SDL_strcmp(argv[i], "--net-delay") == 0 && i + 1 < argc) {
+      def->input_delay = (Uint32)SDL_min(SDL_strtoul(argv[++i], NULL, 10),
+                                         (unsigned long)NETPLAY_MAX_DELAY);
+    } else if (SDL_strcmp(argv[i], "--net-latency") == 0 && i + 1 < argc) {
+      def->conditions.latency_ns =
+          SDL_strtoull(argv[++i], NULL, 10) * SDL_NS_PER_MS;
+    } else if (SDL_strcmp(argv[i], "--net-jitter") == 0 && i + 1 < argc) {
+      def->conditions.jitter_ns =
+          SDL_strtoull(argv[++i], NULL, 10) * SDL_NS_PER_MS;
+    } else if (SDL_strcmp(argv[i], "--net-loss") == 0 && i + 1 < argc) {
+      def->conditions.loss =
+          SDL_clamp((float)SDL_atof(argv[++i]) / 100.0f, 0.0f, 1.0f);
+    }
+  }
+  return true;
+}
+
+// Joins the game `parseNetplay` found. The session drives every player from
+// here on, our keyboard included
+static bool startNetplay(AppState *state, const NetplayDef *def) {
+  if (state->recorder != NULL || state->replay != NULL) {
+    SDL_Log("Netplay can't be recorded or replayed");
+    return false;
+  }
+  // Both allocate on the fixed update's thread, for held packets and resyncs,
+  // and the arena isn't thread safe
+  NetSocket *socket =
+      NetSocket_open(&std_allocator, def->addresses[def->local].port);
+  if (socket == NULL)
+    return false;
+  SDL_Log("Netplay as player %zu of %zu on port %u", def->local, def->players,
+          socket->address.port);
+
+  NetplaySession *session = NetplaySession_create(
+      &std_allocator, socket, def, AppState_snapshotSize(state));
+  PlayerController *input =
+      (PlayerController *)KeyboardController_default(global_allocator);
+  PlayerController_publish(input);
+  AppState_startNetplay(state, session, input);
+  return true;
+}
+
+// How big the state is and how long it takes to capture and put back
+static void logSnapshot(AppState *state) {
+  const size_t size = AppState_snapshotSize(state);
+  Uint8 *buffer = allocPtr(global_allocator, 1, size);
+
+  const Uint64 started = SDL_GetTicksNS();
+  AppState_save(state, buffer);
+  const Uint64 saved = SDL_GetTicksNS();
+  AppState_restore(state, buffer);
+  const Uint64 restored = SDL_GetTicksNS();
+
+  SDL_Log("  %zu byte snapshot of %zu bodies and %zu objects, saved in "
+          "%.1fus, restored in %.1fus",
+          size, state->snapshot.body_count, state->snapshot.object_count,
+          (saved - started) / 1e3, (restored - saved) / 1e3);
+  freePtr(global_allocator, buffer);
+}
+
+// `--headless TICKS` runs the fixed update back to back for TICKS ticks, or
+// until a `--replay` ends, with no window and no uinput devices. Logs
+// ticks/s, the time spent in each phase and how often the ticks allocated
+static SDL_AppResult runHeadless(Uint64 ticks, int argc, char *argv[]) {
+  global_arena_allocator = ArenaAllocator_create(&std_allocator);
+  CountingAllocator counting = CountingAllocator_create(
+      ArenaAllocator_getAllocator(&global_arena_allocator));
+  global_allocator = CountingAllocator_getAllocator(&counting);
+
+  AppOptions options = AppOptions_default();
+  options.headless = true;
+  if (!parseOptions(&options, argc, argv)) {
+    ArenaAllocator_destroy(&global_arena_allocator);
+    return SDL_APP_FAILURE;
+  }
+  AppState *state = AppState_create(global_allocator, options);
+  if (state == NULL) {
+    ArenaAllocator_destroy(&global_arena_allocator);
+    return SDL_APP_FAILURE;
+  }
+  // Nothing samples it without a window, but replays drive the player
+  // through it
+  state->player.controller =
+      (PlayerController *)KeyboardController_default(global_allocator);
+  AppTickProfile profile = {0};
+  if (!parseRunArgs(state, argc, argv) ||
+      !AppTickProfile_openCsv(&profile, options.profile_path,
+                              StressScene_getName(options.scene))) {
+    AppState_destroy(state);
+    ArenaAllocator_destroy(&global_arena_allocator);
+    return SDL_APP_FAILURE;
+  }
+  const CountingAllocator at_start = counting;
+
+  const Uint64 started = SDL_GetTicksNS();
+  for (Uint64 tick = 0; tick < ticks && AppState_tick(state, &profile);
+       tick++) {
+  }
+  const double seconds = (SDL_GetTicksNS() - started) / 1e9;
+  AppTickProfile_closeCsv(&profile);
+
+  AppTickProfile_log(&profile, seconds);
+  logSubsteps(&state->substeps);
+  SDL_Log("  %zu allocations, %zu frees, %zu remaps while ticking",
+          counting.allocations - at_start.allocations,
+          counting.frees - at_start.frees, counting.remaps - at_start.remaps);
+  SDL_Log("  %zu allocations (%zu bytes) during setup", at_start.allocations,
+          at_start.bytes);
+  logSnapshot(state);
+
+  AppState_destroy(state);
+  ArenaAllocator_destroy(&global_arena_allocator);
+  return SDL_APP_SUCCESS;
+}
+
+// `--batch WORLDS TICKS` steps WORLDS independent headless worlds for TICKS
+// ticks each across every core. `--scene`, `--scene-scale` and `--substeps N N`
+// apply to all of them, and `--replay PATH` drives every player
+static SDL_AppResult runBatch(size_t count, Uint64 ticks, int argc,
+                              char *argv[]) {
+  AppOptions options = AppOptions_default();
+  if (count == 0 || !parseOptions(&options, argc, argv))
+    return SDL_APP_FAILURE;
+
+  BatchWorldDef def = BatchWorldDef_default();
+  def.scene = options.scene;
+  def.scene_scale = options.scene_scale;
+  def.ticks = ticks;
+  // Batch worlds don't adapt, so only fixed `--substeps` bounds count
+  if (options.min_substeps == options.max_substeps) {
+    def.substeps = options.min_substeps;
+  }
+  for (int i = 1; i + 1 < argc; i++) {
+    if (SDL_strcmp(argv[i], "--replay") == 0) {
+      def.script = argv[i + 1];
+    }
+  }
+
+  BatchWorldDef *defs = allocPtr(&std_allocator, sizeof(BatchWorldDef), count);
+  for (size_t i = 0; i < count; i++) {
+    defs[i] = def;
+  }
+
+  // The calling thread works too
+  const int cores = SDL_GetNumLogicalCPUCores();
+  JobPool *pool = JobPool_create(&std_allocator, cores > 1 ? cores - 1 : 0);
+  const BatchResult result =
+      BatchSim_run(pool, &std_allocator, defs, count, NULL);
+  JobPool_destroy(pool);
+
+  SDL_Log("%zu worlds (%zu failed) x %lu ticks on %d threads", result.worlds,
+          result.failed, (unsigned long)ticks, cores);
+  SDL_Log("  %.1f simulated seconds in %.3fs, %.1f sim-s per wall-s",
+          result.simulated_seconds, result.wall_seconds, result.throughput);
+  SDL_Log("  slowest world %.3fs, setup %.3fs", result.slowest_world_seconds,
+          result.setup_seconds);
+
+  freePtr(&std_allocator, defs);
+  return result.failed == 0 ? SDL_APP_SUCCESS : SDL_APP_FAILURE;
+}
+
+// `--netplay-test PLAYERS TICKS` plays a networked game against itself over
+// loopback, TICKS ticks of scripted input each. `--net-delay` and the
+// conditions apply to every player, `--net-stagger N` starts each one N ticks
+// after the last and `--net-seed N` picks the input and the losses. Fails
+// unless every world comes out the same
+static SDL_AppResult runNetplayTest(size_t players, Uint64 ticks, int argc,
+                                    char *argv[]) {
+  if (players < 2 || players > NETPLAY_MAX_PLAYERS) {
+    SDL_Log("Netplay tests take 2 to %d players", NETPLAY_MAX_PLAYERS);
+    return SDL_APP_FAILURE;
+  }
+  LoopbackDef def = LoopbackDef_default();
+  NetplayDef netplay = NetplayDef_default();
+  if (!parseOptions(&def.options, argc, argv) ||
+      !parseNetplay(&netplay, argc, argv))
+    return SDL_APP_FAILURE;
+  def.players = players;
+  def.ticks = ticks;
+  def.input_delay = netplay.input_delay;
+  def.conditions = netplay.conditions;
+  for (int i = 1; i + 1 < argc; i++) {
+    if (SDL_strcmp(argv[i], "--net-stagger") == 0) {
+      def.stagger = (Uint32)SDL_strtoul(argv[i + 1], NULL, 10);
+    } else if (SDL_strcmp(argv[i], "--net-seed") == 0) {
+      def.seed = SDL_strtoull(argv[i + 1], NULL, 10);
+    }
+  }
+
+  const LoopbackResult result = Loopback_run(&def);
+  // The shared clock moved one tick a round
+  const double seconds = result.ticks / 60.0;
+  SDL_Log("%zu players x %lu rounds%s, %u frames confirmed, %.1f simulated "
+          "seconds in %.3fs",
+          result.players, (unsigned long)result.ticks,
+          result.failed ? " (FAILED)" : "", result.confirmed,
+          result.simulated_seconds, result.wall_seconds);
+  SDL_Log("  %zu checksummed frames compared, %zu disagree, worlds %s at "
+          "frame %u",
+          result.compared, result.mismatched,
+          result.converged ? "identical" : "DIFFER", result.converged_frame);
+  for (size_t p = 0; p < result.players; p++) {
+    const NetplayStats *stats = &result.stats[p];
+    const double packets = stats->packets_sent > 0 ? stats->packets_sent : 1;
+    const double frames =
+        stats->resimulated_frames > 0 ? stats->resimulated_frames : 1;
+    SDL_Log("  player %zu: %.2fus a tick, %.2f kbit/s out, %.1f bytes and "
+            "%.1f inputs a packet",
+            p, result.tick_us[p],
+            seconds > 0 ? stats->bytes_sent * 8 / 1000.0 / seconds : 0.0,
+            stats->bytes_sent / packets, stats->inputs_sent / packets);
+    SDL_Log("    %lu mispredictions, %lu rollbacks of %lu frames (deepest "
+            "%u) at %.2fus a frame, %lu stalls, %lu waits, %lu resyncs",
+            (unsigned long)stats->mispredictions,
+            (unsigned long)stats->rollbacks,
+            (unsigned long)stats->resimulated_frames, stats->max_rollback,
+            stats->resimulate_ns / 1e3 / frames, (unsigned long)stats->stalls,
+            (unsigned long)stats->waits, (unsigned long)stats->resyncs);
+  }
+  return !result.failed && result.converged && result.mismatched == 0
+             ? SDL_APP_SUCCESS
+             : SDL_APP_FAILURE;
+}
+
 /* This function runs once at startup. */
 SDL_AppResult SDL_AppInit(void **appstate, int argc, char *argv[]) {
+  startup = StartupProfile_create();
 #ifdef DEBUG
   signal(SIGABRT, sigint_handler);
 #endif
   SDL_SetAppMetadata("Controller The Game", "1.0",
                      "com.drflame.controllergame");
 
-  if (!SDL_Init(SDL_INIT_VIDEO)) {
+  for (int i = 1; i < argc; i++) {
+    if (SDL_strcmp(argv[i], "--controller-bench") == 0 && i + 1 < argc) {
+      return runControllerBenchmark(argc - i - 1, &argv[i + 1]);
+    }
+    if (SDL_strcmp(argv[i], "--analog-bench") == 0 && i + 1 < argc) {
+      return runAnalogBenchmark(argc - i - 1, &argv[i + 1]);
+    }
+    if (SDL_strcmp(argv[i], "--batch") == 0 && i + 2 < argc) {
+      return runBatch(SDL_strtoul(argv[i + 1], NULL, 10),
+                      SDL_strtoull(argv[i + 2], NULL, 10), argc, argv);
+    }
+    // `--convert-level SOURCE OUTPUT` builds a binary level for `--level`
+    if (SDL_strcmp(argv[i], "--convert-level") == 0 && i + 2 < argc) {
+      return Level_convert(argv[i + 1], argv[i + 2]) ? SDL_APP_SUCCESS
+                                                     : SDL_APP_FAILURE;
+    }
+    if (SDL_strcmp(argv[i], "--netplay-test") == 0 && i + 2 < argc) {
+      return runNetplayTest(SDL_strtoul(argv[i + 1], NULL, 10),
+                            SDL_strtoull(argv[i + 2], NULL, 10), argc, argv);
+    }
+    if (SDL_strcmp(argv[i], "--headless") == 0 && i + 1 < argc) {
+      return runHeadless(SDL_strtoull(argv[i + 1], NULL, 10), argc, argv);
+    }
+  }
+
+  if (!SDL_Init(SDL_INIT_VIDEO | SDL_INIT_GAMEPAD)) {
     SDL_Log("Couldn't initialize SDL: %s", SDL_GetError());
     return SDL_APP_FAILURE;
   }
+  StartupProfile_mark(&startup, "sdl init");
 
   if (!SDL_CreateWindowAndRenderer("Controller The Game", 640 * 2, 480 * 2, 0,
                                    &window, &renderer)) {
     SDL_Log("Couldn't create window/renderer: %s", SDL_GetError());
     return SDL_APP_FAILURE;
   }
+  StartupProfile_mark(&startup, "window");
 
   // I am running on a wayland high definition screen so I use
   // a scaled renderer to see the game easier
@@ -141,21 +611,52 @@ SDL_AppResult SDL_AppInit(void **appstate, int argc, char *argv[]) {
 
   // Use the default App State Initialization and create
   // it on the heap so that we can pass it around easily
-  AppState *state = AppState_default(global_allocator);
+  AppOptions options = AppOptions_default();
+  NetplayDef netplay = NetplayDef_default();
+  if (!parseOptions(&options, argc, argv) ||
+      !parseNetplay(&netplay, argc, argv))
+    return SDL_APP_FAILURE;
+  // One pad per player, all of them driven by the session
+  if (netplay.players > 0) {
+    options.rollback = true;
+    options.controller_count = netplay.players;
+  }
+  AppState *state = AppState_create(global_allocator, options);
+  if (state == NULL)
+    return SDL_APP_FAILURE;
+  StartupProfile_mark(&startup, "app state");
 
   // Create a Heap-Allocated Controller Component for our player so we can
   // access movement.
   // TODO make a controller subsystem for handling controls.
   state->player.controller =
       (PlayerController *)KeyboardController_default(global_allocator);
+  // The fixed update only ever reads published snapshots
+  PlayerController_publish(state->player.controller);
+
+  if (!parseRunArgs(state, argc, argv))
+    return SDL_APP_FAILURE;
+  if (netplay.players > 0 && !startNetplay(state, &netplay))
+    return SDL_APP_FAILURE;
+
+  // Pack every image queued by the App State into atlas textures
+  if (!TextureAtlas_build(&state->atlas, renderer, &state->render_list)) {
+    SDL_Log("Failed to build texture atlas");
+    return SDL_APP_FAILURE;
+  }
+  Sprite_setRegion(state->player_sprite,
+                   TextureAtlas_getRegion(&state->atlas, state->player_image));
+  StartupProfile_mark(&startup, "texture atlas");
 
+  // The thread locks the mutex straight away, so it has to exist first
+  state->fixedUpdate_mutex = SDL_CreateMutex();
   state->fixedUpdate_thread = SDL_CreateThread((SDL_ThreadFunction)fixedUpdate,
                                                "Fixed Update", (void *)state);
   if (state->fixedUpdate_thread == NULL) {
     SDL_Log("Failed to create fixedUpdate Thread: %s", SDL_GetError());
     return SDL_APP_FAILURE;
   }
-  state->fixedUpdate_mutex = SDL_CreateMutex();
+  StartupProfile_mark(&startup, "threads");
 
   // This allows our Application to access the state
   *appstate = (void *)state;
@@ -173,7 +674,45 @@ SDL_AppResult SDL_AppEvent(void *appstate, SDL_Event *event) {
   case SDL_EVENT_QUIT:
     return SDL_APP_SUCCESS; // We like success when quitting
 
+  case SDL_EVENT_KEY_UP:
+    publishInput(state, state->player.controller);
+    LatencyProbe_markEvent(&state->latency_probe, event->key.timestamp);
+    state->input_pending = true;
+    break;
+
+  case SDL_EVENT_GAMEPAD_ADDED:
+  case SDL_EVENT_GAMEPAD_REMOVED:
+  case SDL_EVENT_GAMEPAD_AXIS_MOTION:
+  case SDL_EVENT_GAMEPAD_BUTTON_DOWN:
+  case SDL_EVENT_GAMEPAD_BUTTON_UP: {
+    // Only the player the event belongs to is sampled
+    const int player = GamepadRoster_handleEvent(&state->gamepads, event);
+    if (player >= 0) {
+      publishInput(state, GamepadRoster_getController(&state->gamepads,
+                                                      (size_t)player));
+      state->input_pending = true;
+    }
+    // Pad 0 is the keyboard's, so gamepad player n drives pad n + 1
+    if (event->type == SDL_EVENT_GAMEPAD_ADDED && player >= 0 &&
+        (size_t)player + 1 >= state->options.controller_count) {
+      SDL_Log("Gamepad player %d has no pad, start with --pads %d", player,
+              player + 2);
+    }
+    break;
+  }
+
+  case SDL_EVENT_MOUSE_MOTION:
+  case SDL_EVENT_MOUSE_BUTTON_DOWN:
+  case SDL_EVENT_MOUSE_BUTTON_UP:
+  case SDL_EVENT_WINDOW_EXPOSED:
+  case SDL_EVENT_WINDOW_RESIZED:
+    state->input_pending = true;
+    break;
+
   case SDL_EVENT_KEY_DOWN:
+    publishInput(state, state->player.controller);
+    LatencyProbe_markEvent(&state->latency_probe, event->key.timestamp);
+    state->input_pending = true;
     switch (event->key.key) {
     case SDLK_RETURN:
       // We can change the vsync option if we want.
@@ -188,6 +727,39 @@ SDL_AppResult SDL_AppEvent(void *appstate, SDL_Event *event) {
       // Probably unneeded
       // TODO move to an option menu
       state->options.frame_cap = !state->options.frame_cap;
+      FramePacer_setTargetFps(
+          &state->pacer,
+          state->options.frame_cap ? state->options.target_fps : 0.0);
+      break;
+
+    case SDLK_I:
+      // Stop drawing frames when nothing changes
+      // TODO move to an option menu
+      state->options.idle_render = !state->options.idle_render;
+      state->pacer.idle_mode = state->options.idle_render;
+      break;
+
+    case SDLK_F2:
+      // Letter keys belong to the keyboard controller
+      LatencyRecorder_export(&state->latency, "latency.csv");
+      break;
+
+    case SDLK_F3: {
+      // Swaps the sticks of every pad. The fixed update picks the new table
+      // up on its next tick
+      static bool swapped = false;
+      swapped = !swapped;
+      RemapEngine_rebind(
+          &state->remap,
+          swapped ? RemapTable_compile(&std_allocator, REMAP_SWAPPED_BINDINGS,
+                                       REMAP_SWAPPED_BINDING_COUNT)
+                  : RemapTable_compile(&std_allocator, REMAP_DEFAULT_BINDINGS,
+                                       REMAP_DEFAULT_BINDING_COUNT));
+      break;
+    }
+
+    case SDLK_F5:
+      AppState_requestReset(state);
       break;
 
 #ifdef DEBUG
@@ -206,6 +778,22 @@ SDL_AppResult SDL_AppEvent(void *appstate, SDL_Event *event) {
 /* This function runs once per frame, and is the heart of the program. */
 SDL_AppResult SDL_AppIterate(void *appstate) {
   AppState *state = (AppState *)appstate;
+  // The fixed update stops itself when a replay ends
+  if (!state->running)
+    return SDL_APP_SUCCESS;
+
+  // Key events already published their changes, but the keyboard state can
+  // also change without one, e.g. when focus is lost
+  publishInput(state, state->player.controller);
+
+  // Nothing moved and no input arrived. Sleep through the frame instead of
+  // redrawing the same picture
+  const bool changed = Object2D_takeDamage() || state->input_pending;
+  if (!FramePacer_shouldRender(&state->pacer, changed)) {
+    FramePacer_skip(&state->pacer);
+    return SDL_APP_CONTINUE;
+  }
+  state->input_pending = false;
 
   // We need to be able to calculate `delta_time`
   const double now = (double)SDL_GetTicks();
@@ -237,18 +825,29 @@ SDL_AppResult SDL_AppIterate(void *appstate) {
       .y = viewport.h,
   };
 
-  // Create a `RenderContext`
+  // Static geometry is only redrawn when it changes
+  CachedLayer_update(&state->static_layer, renderer, &state->render_list,
+                     initial);
+
+  // Record every root into the command list, then draw it sorted by layer
+  // and renderer state
+  // TODO replace with root scene node
+  Object2D *roots[] = {&state->player.super};
+  RenderList_clear(&state->render_list);
+  CachedLayer_composite(&state->static_layer,
+                        RenderList_getShard(&state->render_list, 0));
+  RenderList_record(&state->render_list, state->jobs, renderer, roots,
+                    sizeof(roots) / sizeof(*roots), initial);
+  RenderList_sort(&state->render_list);
+  RenderList_submit(&state->render_list, renderer);
+
+#ifdef DEBUG
+  // Debug drawing skips the command list and draws straight to the renderer
   // TODO Create it as a static variable and save unnecessary
   // stack operations if the object grows
-  RenderContext frame_ctx = RenderContext_create(renderer);
+  RenderContext frame_ctx = RenderContext_create(renderer, NULL);
   Stack_push(frame_ctx.transforms, initial);
 
-  // Render Root Player Sequence
-  objcall(state->player.super, preRender, &frame_ctx);
-  objcall(state->player.super, render, &frame_ctx);
-  objcall(state->player.super, postRender, &frame_ctx);
-
-#ifdef DEBUG
   // Draw the box2d world
   debug_draw.context = &frame_ctx;
 
@@ -280,17 +879,72 @@ SDL_AppResult SDL_AppIterate(void *appstate) {
   snprintf(buf, 16, "%gs", state->last_tick / 1000.0);
   SDL_RenderDebugText(renderer, 10, ypos++ * 20 + 10, buf);
 
+  const RenderStats *render_stats = &state->render_list.stats;
+  snprintf(buf, 31, "%zu cmds %zu draws", render_stats->commands,
+           render_stats->draw_calls);
+  SDL_RenderDebugText(renderer, 10, ypos++ * 20 + 10, buf);
+
   if (state->options.vsync) {
     SDL_RenderDebugText(renderer, 10, ypos++ * 20 + 10, "VSYNC ENABLED");
   }
   if (state->options.frame_cap) {
     SDL_RenderDebugText(renderer, 10, ypos++ * 20 + 10, "FRAME CAP ENABLED");
   }
+  if (state->options.idle_render) {
+    SDL_RenderDebugText(renderer, 10, ypos++ * 20 + 10, "IDLE RENDER ENABLED");
+  }
+
+  const FramePacerStats *pacing = &state->pacer.stats;
+  snprintf(buf, 31, "%.2fms [%.2f %.2f]", pacing->average_interval / 1e6,
+           pacing->min_interval / 1e6, pacing->max_interval / 1e6);
+  SDL_RenderDebugText(renderer, 10, ypos++ * 20 + 10, buf);
+  snprintf(buf, 31, "%lu missed %lu skipped",
+           (unsigned long)pacing->missed_deadlines,
+           (unsigned long)pacing->skipped_frames);
+  SDL_RenderDebugText(renderer, 10, ypos++ * 20 + 10, buf);
+
+  // Written by the fixed update, a torn read only garbles one frame
+  snprintf(buf, 31, "%d substeps %lu overruns", state->substeps.substeps,
+           (unsigned long)state->substeps.stats.overruns);
+  SDL_RenderDebugText(renderer, 10, ypos++ * 20 + 10, buf);
+
+  // Key press to uinput write, falling back to the tick when the pad didn't
+  // change
+  LatencySummary latency =
+      LatencyRecorder_summarize(&state->latency, LATENCY_WRITE);
+  const char *latency_stage = "write";
+  if (latency.count == 0) {
+    latency = LatencyRecorder_summarize(&state->latency, LATENCY_TICK);
+    latency_stage = "tick";
+  }
+  snprintf(buf, 31, "%s %.1f/%.1f/%.1fms", latency_stage,
+           latency.p50_us / 1e3, latency.p99_us / 1e3, latency.max_us / 1e3);
+  SDL_RenderDebugText(renderer, 10, ypos++ * 20 + 10, buf);
 
 #endif // DEBUG
 
+  // Vsync already paces presentation
+  if (!state->options.vsync) {
+    FramePacer_wait(&state->pacer);
+  }
+
   /* put the newly-cleared rendering on the screen. */
   SDL_RenderPresent(renderer);
+  FramePacer_markPresent(&state->pacer);
+
+  // Devices are created in the background, usually finishing after the
+  // first frame
+  Uint64 controllers_ready;
+  if (!startup_controllers_logged && state->controllers != NULL &&
+      ControllerManager_isReady(state->controllers, &controllers_ready)) {
+    StartupProfile_markAt(&startup, "controllers ready", controllers_ready);
+    startup_controllers_logged = true;
+  }
+  if (!startup_frame_logged) {
+    StartupProfile_mark(&startup, "first frame");
+    startup_frame_logged = true;
+  }
+  StartupProfile_log(&startup);
 
   state->delta_time = ((double)SDL_GetTicks() - state->last_tick) / 1000.0;
   frames++;
@@ -302,6 +956,10 @@ SDL_AppResult SDL_AppIterate(void *appstate) {
 void SDL_AppQuit(void *appstate, SDL_AppResult result) {
   /* SDL will clean up the window/renderer for us. */
 
+  // Nothing was created when init stopped early, e.g. for a benchmark
+  if (appstate == NULL)
+    return;
+
   // Destroy the Application
   AppState_destroy((AppState *)appstate);
 
@@ -0,0 +1,132 @@
+/*
+    Frame Pacing Implementation
+    Copyright (C) 2025  Ashton Warner
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "boot/pacer.h"
+#include "debug/debug.h"
+
+// Skipped frames still tick at this rate when running uncapped
+#define FRAME_PACER_FALLBACK_NS (SDL_NS_PER_SECOND / 60)
+
+FramePacer FramePacer_create(double target_fps) {
+  FramePacer self = {
+      .target_ns = 0,
+      .spin_ns = FRAME_PACER_SPIN_NS,
+      .idle_ns = FRAME_PACER_IDLE_NS,
+      .idle_mode = false,
+
+      .deadline = 0,
+      .last_present = 0,
+      .window_frames = 0,
+      .window_min = UINT64_MAX,
+      .window_max = 0,
+
+      .stats = {0},
+  };
+  FramePacer_setTargetFps(&self, target_fps);
+  return self;
+}
+
+void FramePacer_setTargetFps(FramePacer *self, double target_fps) {
+  self->target_ns =
+      target_fps > 0.0 ? (Uint64)(SDL_NS_PER_SECOND / target_fps) : 0;
+  // Start a fresh schedule instead of catching up to the old one
+  self->deadline = 0;
+}
+
+bool FramePacer_shouldRender(FramePacer *self, bool changed) {
+  if (!self->idle_mode || changed)
+    return true;
+  if (SDL_GetTicksNS() - self->last_present >= self->idle_ns)
+    return true;
+
+  self->stats.skipped_frames++;
+  return false;
+}
+
+// Sleep for most of the wait and spin the rest to land on the deadline
+static void FramePacer_waitUntil(const FramePacer *self, Uint64 deadline) {
+  Uint64 now = SDL_GetTicksNS();
+  if (now >= deadline)
+    return;
+
+  const Uint64 remaining = deadline - now;
+  if (remaining > self->spin_ns) {
+    SDL_DelayNS(remaining - self->spin_ns);
+  }
+  while (SDL_GetTicksNS() < deadline) {
+    SDL_CPUPauseInstruction();
+  }
+}
+
+void FramePacer_wait(FramePacer *self) {
+  if (self->target_ns == 0)
+    return;
+
+  const Uint64 now = SDL_GetTicksNS();
+  if (self->deadline == 0) {
+    self->deadline = now;
+  }
+  self->deadline += self->target_ns;
+
+  if (now >= self->deadline) {
+    self->stats.missed_deadlines++;
+    // Too far behind to catch up. Drop the missed frames and resync
+    if (now - self->deadline > self->target_ns) {
+      self->deadline = now;
+    }
+    return;
+  }
+  FramePacer_waitUntil(self, self->deadline);
+}
+
+void FramePacer_skip(FramePacer *self) {
+  const Uint64 interval =
+      self->target_ns != 0 ? self->target_ns : FRAME_PACER_FALLBACK_NS;
+  // Nothing is presented, so there is no point spinning for accuracy
+  SDL_DelayNS(interval);
+  self->deadline = 0;
+}
+
+void FramePacer_markPresent(FramePacer *self) {
+  const Uint64 now = SDL_GetTicksNS();
+  FramePacerStats *stats = &self->stats;
+
+  if (self->last_present != 0) {
+    const Uint64 interval = now - self->last_present;
+    stats->last_interval = interval;
+    stats->average_interval = stats->average_interval == 0.0
+                                  ? (double)interval
+                                  : stats->average_interval * 0.95 +
+                                        (double)interval * 0.05;
+
+    if (interval < self->window_min)
+      self->window_min = interval;
+    if (interval > self->window_max)
+      self->window_max = interval;
+    if (++self->window_frames >= FRAME_PACER_STATS_WINDOW) {
+      stats->min_interval = self->window_min;
+      stats->max_interval = self->window_max;
+      self->window_frames = 0;
+      self->window_min = UINT64_MAX;
+      self->window_max = 0;
+    }
+  }
+
+  stats->frames++;
+  self->last_present = now;
+}
@@ -0,0 +1,60 @@
+/*
+    Startup Timing
+    Copyright (C) 2025  Ashton Warner
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "boot/startup.h"
+
+StartupProfile StartupProfile_create() {
+  return (StartupProfile){
+      .lock = 0,
+      .start = SDL_GetTicksNS(),
+      .count = 0,
+      .logged = 0,
+      .phases = {{0}},
+  };
+}
+
+void StartupProfile_mark(StartupProfile *self, const char *name) {
+  StartupProfile_markAt(self, name, SDL_GetTicksNS());
+}
+
+void StartupProfile_markAt(StartupProfile *self, const char *name,
+                           Uint64 timestamp) {
+  SDL_LockSpinlock(&self->lock);
+  if (self->count < STARTUP_MAX_PHASES) {
+    self->phases[self->count++] = (StartupPhase){
+        .name = name,
+        .end = timestamp,
+    };
+  }
+  SDL_UnlockSpinlock(&self->lock);
+}
+
+void StartupProfile_log(StartupProfile *self) {
+  SDL_LockSpinlock(&self->lock);
+  for (; self->logged < self->count; self->logged++) {
+    const StartupPhase *phase = &self->phases[self->logged];
+    const Uint64 previous =
+        self->logged == 0 ? self->start : self->phases[self->logged - 1].end;
+    // Background phases can end before the phase logged ahead of them
+    const Uint64 took = phase->end > previous ? phase->end - previous : 0;
+    SDL_Log("startup: %-20s +%7.2fms  at %7.2fms", phase->name,
+            took / (double)SDL_NS_PER_MS,
+            (phase->end - self->start) / (double)SDL_NS_PER_MS);
+  }
+  SDL_UnlockSpinlock(&self->lock);
+}
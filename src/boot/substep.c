@@ -0,0 +1,108 @@
+/*
+    Adaptive Physics Substepping
+    Copyright (C) 2025  Ashton Warner
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "boot/substep.h"
+#include "debug/debug.h"
+
+// Weight of the newest step in the smoothed step time
+#define SUBSTEP_SMOOTHING 0.1
+
+SubstepController SubstepController_create(double tick_rate, int min,
+                                           int max) {
+  debugAssert(tick_rate > 0.0, "tick_rate <= 0");
+  debugAssert(min > 0 && min <= max, "substeps [%d, %d] out of order", min,
+              max);
+
+  return (SubstepController){
+      .min = min,
+      .max = max,
+      .substeps = SDL_clamp(SUBSTEP_DEFAULT_START, min, max),
+      .budget_ns = (Uint64)(SDL_NS_PER_SECOND / tick_rate),
+      .raise_ticks = 0,
+      .lower_ticks = 0,
+      .stats = {0},
+  };
+}
+
+void SubstepController_pin(SubstepController *self, int substeps) {
+  debugAssert(self != NULL, "self == NULL");
+  debugAssert(substeps > 0, "substeps <= 0");
+  self->min = substeps;
+  self->max = substeps;
+  self->substeps = substeps;
+}
+
+static void SubstepController_set(SubstepController *self, int substeps) {
+  substeps = SDL_clamp(substeps, self->min, self->max);
+  if (substeps > self->substeps) {
+    self->stats.raised++;
+  } else if (substeps < self->substeps) {
+    self->stats.lowered++;
+  }
+  // The step time scales with the substeps, so carry the estimate over
+  // instead of waiting for it to catch up
+  self->stats.average_step_ns =
+      self->stats.average_step_ns * substeps / self->substeps;
+  self->substeps = substeps;
+  self->raise_ticks = 0;
+  self->lower_ticks = 0;
+}
+
+void SubstepController_update(SubstepController *self, Uint64 step_ns,
+                              Uint64 tick_ns) {
+  debugAssert(self != NULL, "self == NULL");
+  SubstepStats *stats = &self->stats;
+
+  stats->ticks++;
+  stats->max_step_ns = SDL_max(stats->max_step_ns, step_ns);
+  stats->average_step_ns =
+      stats->ticks == 1
+          ? (double)step_ns
+          : stats->average_step_ns +
+                (step_ns - stats->average_step_ns) * SUBSTEP_SMOOTHING;
+
+  const bool overran = tick_ns > self->budget_ns;
+  if (overran) {
+    stats->overruns++;
+  }
+  if (self->min == self->max)
+    return;
+
+  // Under load we can't wait for the average, the next tick would overrun too
+  if (overran) {
+    SubstepController_set(self, self->substeps - 1);
+    return;
+  }
+
+  const double budget = (double)self->budget_ns;
+  const double per_substep = stats->average_step_ns / self->substeps;
+  if (stats->average_step_ns > budget * SUBSTEP_HIGH_WATER) {
+    self->raise_ticks = 0;
+    if (++self->lower_ticks >= SUBSTEP_HOLD_TICKS) {
+      SubstepController_set(self, self->substeps - 1);
+    }
+  } else if (per_substep * (self->substeps + 1) < budget * SUBSTEP_LOW_WATER) {
+    self->lower_ticks = 0;
+    if (++self->raise_ticks >= SUBSTEP_HOLD_TICKS) {
+      SubstepController_set(self, self->substeps + 1);
+    }
+  } else {
+    self->raise_ticks = 0;
+    self->lower_ticks = 0;
+  }
+}
@@ -0,0 +1,180 @@
+/*
+    Input Latency Instrumentation
+    Copyright (C) 2025  Ashton Warner
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <stdio.h>
+
+#include "debug/debug.h"
+#include "debug/latency.h"
+
+const char *LATENCY_STAGE_NAMES[LATENCY_STAGE_COUNT] = {
+    "event", "sample", "tick", "report", "write",
+};
+
+LatencyProbe LatencyProbe_create() {
+  return (LatencyProbe){
+      .lock = 0,
+      .pending = 0,
+  };
+}
+
+void LatencyProbe_markEvent(LatencyProbe *self, Uint64 timestamp) {
+  SDL_LockSpinlock(&self->lock);
+  // Later events in the same tick are hidden behind the first one
+  if (self->pending == 0) {
+    self->pending = timestamp;
+  }
+  SDL_UnlockSpinlock(&self->lock);
+}
+
+LatencyTrace LatencyProbe_sample(LatencyProbe *self) {
+  LatencyTrace trace = {{0}};
+
+  SDL_LockSpinlock(&self->lock);
+  trace.stamps[LATENCY_EVENT] = self->pending;
+  self->pending = 0;
+  SDL_UnlockSpinlock(&self->lock);
+
+  if (LatencyTrace_active(&trace)) {
+    LatencyTrace_mark(&trace, LATENCY_SAMPLE);
+  }
+  return trace;
+}
+
+static size_t LatencyHistogram_bucket(Uint64 us) {
+  if (us < LATENCY_SUB_BUCKETS)
+    return us;
+  if (us > SDL_MAX_SINT32)
+    us = SDL_MAX_SINT32;
+
+  // Position of the top bit picks the range, the next four bits the bucket
+  // inside it
+  const int top = 63 - __builtin_clzll(us);
+  const size_t sub = (us >> (top - 4)) & (LATENCY_SUB_BUCKETS - 1);
+  return (top - 3) * LATENCY_SUB_BUCKETS + sub;
+}
+
+// Largest value that lands in `bucket`, so percentiles never under report
+static Uint64 LatencyHistogram_bucketLimit(size_t bucket) {
+  if (bucket < LATENCY_SUB_BUCKETS)
+    return bucket;
+
+  const int shift = bucket / LATENCY_SUB_BUCKETS - 1;
+  const Uint64 sub = bucket % LATENCY_SUB_BUCKETS;
+  return ((LATENCY_SUB_BUCKETS + sub + 1) << shift) - 1;
+}
+
+static void LatencyHistogram_add(LatencyHistogram *self, Uint64 us) {
+  SDL_AddAtomicInt(&self->buckets[LatencyHistogram_bucket(us)], 1);
+  SDL_AddAtomicInt(&self->count, 1);
+
+  const int value = us > SDL_MAX_SINT32 ? SDL_MAX_SINT32 : (int)us;
+  int max = SDL_GetAtomicInt(&self->max_us);
+  while (value > max &&
+         !SDL_CompareAndSwapAtomicInt(&self->max_us, max, value)) {
+    max = SDL_GetAtomicInt(&self->max_us);
+  }
+}
+
+static Uint64 LatencyHistogram_percentile(LatencyHistogram *self, int count,
+                                          double percentile) {
+  const int rank = (int)(count * percentile + 0.5);
+  int seen = 0;
+  for (size_t i = 0; i < LATENCY_BUCKETS; i++) {
+    seen += SDL_GetAtomicInt(&self->buckets[i]);
+    if (seen >= rank && seen > 0)
+      return LatencyHistogram_bucketLimit(i);
+  }
+  return 0;
+}
+
+void LatencyRecorder_reset(LatencyRecorder *self) {
+  for (size_t stage = 0; stage < LATENCY_STAGE_COUNT; stage++) {
+    LatencyHistogram *histogram = &self->stages[stage];
+    for (size_t i = 0; i < LATENCY_BUCKETS; i++) {
+      SDL_SetAtomicInt(&histogram->buckets[i], 0);
+    }
+    SDL_SetAtomicInt(&histogram->count, 0);
+    SDL_SetAtomicInt(&histogram->max_us, 0);
+  }
+}
+
+void LatencyRecorder_record(LatencyRecorder *self, const LatencyTrace *trace) {
+  if (!LatencyTrace_active(trace))
+    return;
+
+  const Uint64 start = trace->stamps[LATENCY_EVENT];
+  for (size_t stage = LATENCY_SAMPLE; stage < LATENCY_STAGE_COUNT; stage++) {
+    const Uint64 stamp = trace->stamps[stage];
+    if (stamp == 0)
+      continue;
+    // The event can be stamped slightly after SDL_GetTicksNS() is read on
+    // another thread
+    const Uint64 elapsed = stamp > start ? stamp - start : 0;
+    LatencyHistogram_add(&self->stages[stage], elapsed / SDL_NS_PER_US);
+  }
+}
+
+LatencySummary LatencyRecorder_summarize(LatencyRecorder *self,
+                                         enum LatencyStage stage) {
+  debugAssert(stage < LATENCY_STAGE_COUNT, "invalid stage %d", stage);
+  LatencyHistogram *histogram = &self->stages[stage];
+
+  const int count = SDL_GetAtomicInt(&histogram->count);
+  LatencySummary summary = {
+      .count = count,
+      .p50_us = LatencyHistogram_percentile(histogram, count, 0.50),
+      .p99_us = LatencyHistogram_percentile(histogram, count, 0.99),
+      .max_us = SDL_GetAtomicInt(&histogram->max_us),
+  };
+  // Bucket limits can overshoot the largest value actually seen
+  summary.p50_us = SDL_min(summary.p50_us, summary.max_us);
+  summary.p99_us = SDL_min(summary.p99_us, summary.max_us);
+  return summary;
+}
+
+bool LatencyRecorder_export(LatencyRecorder *self, const char *path) {
+  FILE *file = fopen(path, "w");
+  if (file == NULL) {
+    SDL_Log("Couldn't open %s for the latency export", path);
+    return false;
+  }
+
+  fprintf(file, "stage,count,p50_us,p99_us,max_us\n");
+  for (size_t stage = LATENCY_SAMPLE; stage < LATENCY_STAGE_COUNT; stage++) {
+    const LatencySummary summary = LatencyRecorder_summarize(self, stage);
+    fprintf(file, "%s,%d,%lu,%lu,%lu\n", LATENCY_STAGE_NAMES[stage],
+            summary.count, (unsigned long)summary.p50_us,
+            (unsigned long)summary.p99_us, (unsigned long)summary.max_us);
+  }
+
+  fprintf(file, "\nstage,bucket_us,count\n");
+  for (size_t stage = LATENCY_SAMPLE; stage < LATENCY_STAGE_COUNT; stage++) {
+    LatencyHistogram *histogram = &self->stages[stage];
+    for (size_t i = 0; i < LATENCY_BUCKETS; i++) {
+      const int count = SDL_GetAtomicInt(&histogram->buckets[i]);
+      if (count == 0)
+        continue;
+      fprintf(file, "%s,%lu,%d\n", LATENCY_STAGE_NAMES[stage],
+              (unsigned long)LatencyHistogram_bucketLimit(i), count);
+    }
+  }
+
+  fclose(file);
+  trace("Exported input latency to %s", path);
+  return true;
+}
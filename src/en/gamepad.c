@@ -0,0 +1,249 @@
+/*
+    Gamepad Player Controls
+    Copyright (C) 2025  Ashton Warner
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "en/gamepad.h"
+#include "debug/debug.h"
+#include "input/controller.h"
+
+#define GAMEPAD_BIT(BUTTON) (1u << (BUTTON))
+
+// Mirrors the keyboard layout, where some keys drive two buttons
+static const Uint32 GAMEPAD_SOURCE_BUTTONS[GAMEPAD_SOURCE_COUNT] = {
+    [SDL_GAMEPAD_BUTTON_SOUTH] =
+        GAMEPAD_BIT(INPUT_BUTTON_PRIMARY) | GAMEPAD_BIT(INPUT_BUTTON_JUMP),
+    [SDL_GAMEPAD_BUTTON_EAST] = GAMEPAD_BIT(INPUT_BUTTON_SECONDARY),
+    [SDL_GAMEPAD_BUTTON_WEST] = GAMEPAD_BIT(INPUT_BUTTON_TERTIARY),
+    [SDL_GAMEPAD_BUTTON_NORTH] = GAMEPAD_BIT(INPUT_BUTTON_QUATERNY),
+    [SDL_GAMEPAD_BUTTON_BACK] = GAMEPAD_BIT(INPUT_BUTTON_DISMOUNT),
+    [SDL_GAMEPAD_BUTTON_LEFT_SHOULDER] = GAMEPAD_BIT(INPUT_BUTTON_ATTACK),
+    [SDL_GAMEPAD_BUTTON_RIGHT_SHOULDER] = GAMEPAD_BIT(INPUT_BUTTON_ACTION),
+    [GAMEPAD_SOURCE_LEFT_TRIGGER] = GAMEPAD_BIT(INPUT_BUTTON_ATTACK),
+    [GAMEPAD_SOURCE_RIGHT_TRIGGER] = GAMEPAD_BIT(INPUT_BUTTON_ACTION),
+};
+
+static const int GAMEPAD_STICK_AXES[SDL_GAMEPAD_AXIS_COUNT] = {
+    [SDL_GAMEPAD_AXIS_LEFTX] = INPUT_AXIS_X,
+    [SDL_GAMEPAD_AXIS_LEFTY] = INPUT_AXIS_Y,
+    [SDL_GAMEPAD_AXIS_RIGHTX] = INPUT_AXIS_RX,
+    [SDL_GAMEPAD_AXIS_RIGHTY] = INPUT_AXIS_RY,
+    [SDL_GAMEPAD_AXIS_LEFT_TRIGGER] = -1,
+    [SDL_GAMEPAD_AXIS_RIGHT_TRIGGER] = -1,
+};
+
+// Rebuilds the buttons and hat from the held sources. Several sources share
+// buttons, so releasing one mustn't clear what another still holds
+static void GamepadController_resolve(GamepadController *self) {
+  Uint32 buttons = 0;
+  const Uint32 held = self->held;
+  for (int source = 0; source < GAMEPAD_SOURCE_COUNT; source++) {
+    if ((held >> source) & 1) {
+      buttons |= GAMEPAD_SOURCE_BUTTONS[source];
+    }
+  }
+  self->live.buttons = buttons;
+
+  self->live.hat_x = (Sint8)(((held >> SDL_GAMEPAD_BUTTON_DPAD_RIGHT) & 1) -
+                             ((held >> SDL_GAMEPAD_BUTTON_DPAD_LEFT) & 1));
+  self->live.hat_y = (Sint8)(((held >> SDL_GAMEPAD_BUTTON_DPAD_DOWN) & 1) -
+                             ((held >> SDL_GAMEPAD_BUTTON_DPAD_UP) & 1));
+}
+
+static void GamepadController_setHeld(GamepadController *self, int source,
+                                      bool down) {
+  if (source < 0 || source >= GAMEPAD_SOURCE_COUNT)
+    return;
+  self->held = (self->held & ~GAMEPAD_BIT(source)) |
+               ((Uint32)down << source);
+  GamepadController_resolve(self);
+}
+
+static void GamepadController_setAxis(GamepadController *self,
+                                      SDL_GamepadAxis axis, Sint16 value) {
+  if (axis == SDL_GAMEPAD_AXIS_LEFT_TRIGGER ||
+      axis == SDL_GAMEPAD_AXIS_RIGHT_TRIGGER) {
+    GamepadController_setHeld(self,
+                              axis == SDL_GAMEPAD_AXIS_LEFT_TRIGGER
+                                  ? GAMEPAD_SOURCE_LEFT_TRIGGER
+                                  : GAMEPAD_SOURCE_RIGHT_TRIGGER,
+                              value >= GAMEPAD_TRIGGER_THRESHOLD);
+    return;
+  }
+  if (axis < 0 || axis >= SDL_GAMEPAD_AXIS_COUNT)
+    return;
+  // -32768 would land just past -1
+  self->live.axes[GAMEPAD_STICK_AXES[axis]] =
+      SDL_max(value / 32767.0f, -1.0f);
+}
+
+// Called by `PlayerController_publish`, `live` is already a whole snapshot
+static void GamepadController_sample(GamepadController *self,
+                                     InputState *state) {
+  *state = self->live;
+}
+
+static void GamepadController_close(GamepadController *self) {
+  if (self->gamepad != NULL) {
+    SDL_CloseGamepad(self->gamepad);
+  }
+  self->gamepad = NULL;
+  self->id = 0;
+  self->held = 0;
+  self->live = (InputState){0};
+}
+
+// A pad can already be held when it is plugged in, so read it once. After
+// this only events change it
+static void GamepadController_seed(GamepadController *self) {
+  for (int button = 0; button < SDL_GAMEPAD_BUTTON_COUNT; button++) {
+    if (SDL_GetGamepadButton(self->gamepad, (SDL_GamepadButton)button)) {
+      self->held |= GAMEPAD_BIT(button);
+    }
+  }
+  for (int axis = 0; axis < SDL_GAMEPAD_AXIS_COUNT; axis++) {
+    GamepadController_setAxis(
+        self, (SDL_GamepadAxis)axis,
+        SDL_GetGamepadAxis(self->gamepad, (SDL_GamepadAxis)axis));
+  }
+  GamepadController_resolve(self);
+}
+
+GamepadRoster GamepadRoster_create() {
+  GamepadRoster self = {.connected = 0};
+  for (size_t i = 0; i < GAMEPAD_MAX_PLAYERS; i++) {
+    self.players[i] = (GamepadController){
+        .super =
+            {
+                .sample = (void (*)(PlayerController *,
+                                    InputState *))GamepadController_sample,
+                // The roster owns its controllers
+                .destroy = NULL,
+                .channel = InputChannel_create(),
+            },
+        .gamepad = NULL,
+        .id = 0,
+    };
+  }
+  return self;
+}
+
+void GamepadRoster_destroy(GamepadRoster *self) {
+  debugAssert(self != NULL, "self == NULL");
+  for (size_t i = 0; i < GAMEPAD_MAX_PLAYERS; i++) {
+    GamepadController_close(&self->players[i]);
+  }
+  self->connected = 0;
+}
+
+// Pads only ever number GAMEPAD_MAX_PLAYERS, a scan beats hashing the id
+static int GamepadRoster_find(const GamepadRoster *self, SDL_JoystickID id) {
+  for (int i = 0; i < GAMEPAD_MAX_PLAYERS; i++) {
+    if (self->players[i].gamepad != NULL && self->players[i].id == id) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+static int GamepadRoster_add(GamepadRoster *self, SDL_JoystickID id) {
+  // SDL reports the pads present at init as added too, and our own virtual
+  // pads would feed themselves
+  if (GamepadRoster_find(self, id) >= 0 ||
+      (SDL_GetGamepadVendorForID(id) == CONTROLLER_VENDOR_ID &&
+       SDL_GetGamepadProductForID(id) == CONTROLLER_PRODUCT_ID)) {
+    return -1;
+  }
+
+  int player = -1;
+  for (int i = 0; i < GAMEPAD_MAX_PLAYERS && player < 0; i++) {
+    if (self->players[i].gamepad == NULL) {
+      player = i;
+    }
+  }
+  if (player < 0) {
+    SDL_Log("No free player for gamepad %u", (unsigned)id);
+    return -1;
+  }
+
+  GamepadController *controller = &self->players[player];
+  controller->gamepad = SDL_OpenGamepad(id);
+  if (controller->gamepad == NULL) {
+    SDL_Log("Failed to open gamepad %u: %s", (unsigned)id, SDL_GetError());
+    return -1;
+  }
+  controller->id = id;
+  SDL_SetGamepadPlayerIndex(controller->gamepad, player);
+  GamepadController_seed(controller);
+  self->connected++;
+
+  trace("Gamepad %s is player %d", SDL_GetGamepadName(controller->gamepad),
+        player);
+  return player;
+}
+
+int GamepadRoster_handleEvent(GamepadRoster *self, const SDL_Event *event) {
+  debugAssert(self != NULL, "self == NULL");
+
+  switch (event->type) {
+  case SDL_EVENT_GAMEPAD_ADDED:
+    return GamepadRoster_add(self, event->gdevice.which);
+
+  case SDL_EVENT_GAMEPAD_REMOVED: {
+    const int player = GamepadRoster_find(self, event->gdevice.which);
+    if (player >= 0) {
+      // Publishing the cleared state releases whatever was held
+      GamepadController_close(&self->players[player]);
+      self->connected--;
+    }
+    return player;
+  }
+
+  case SDL_EVENT_GAMEPAD_AXIS_MOTION: {
+    const int player = GamepadRoster_find(self, event->gaxis.which);
+    if (player >= 0) {
+      GamepadController_setAxis(&self->players[player],
+                                (SDL_GamepadAxis)event->gaxis.axis,
+                                event->gaxis.value);
+    }
+    return player;
+  }
+
+  case SDL_EVENT_GAMEPAD_BUTTON_DOWN:
+  case SDL_EVENT_GAMEPAD_BUTTON_UP: {
+    const int player = GamepadRoster_find(self, event->gbutton.which);
+    if (player >= 0) {
+      GamepadController_setHeld(&self->players[player], event->gbutton.button,
+                                event->gbutton.down);
+    }
+    return player;
+  }
+
+  default:
+    return -1;
+  }
+}
+
+PlayerController *GamepadRoster_getController(GamepadRoster *self,
+                                              size_t player) {
+  debugAssert(player < GAMEPAD_MAX_PLAYERS, "player %zu out of range", player);
+  return &self->players[player].super;
+}
+
+bool GamepadRoster_isConnected(const GamepadRoster *self, size_t player) {
+  debugAssert(player < GAMEPAD_MAX_PLAYERS, "player %zu out of range", player);
+  return self->players[player].gamepad != NULL;
+}
@@ -0,0 +1,74 @@
+/*
+    Static Ground Object
+    Copyright (C) 2025  Ashton Warner
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <box2d/types.h>
+#include <math.h>
+
+#include "en/ground.h"
+#include "util/options.h"
+
+Ground Ground_create(b2WorldId world, b2Segment segment) {
+  Object2D super = Object2D_create(0.0f, 0.0f, 0.0f, 0.0f);
+  super.render = (void (*)(Object2D *, RenderContext *))Ground_render;
+  super.destroy = (void (*)(Object2D *))Ground_destroy;
+  super.layer = RENDER_LAYER_BACKGROUND;
+
+  b2BodyDef grounddef = b2DefaultBodyDef();
+  grounddef.position = (b2Vec2){
+      0.0f,
+      0.0f,
+  };
+  b2BodyId body = b2CreateBody(world, &grounddef);
+
+  b2ShapeDef groundshapedef = b2DefaultShapeDef();
+  groundshapedef.density = 1.0f;
+  b2CreateSegmentShape(body, &groundshapedef, &segment);
+
+  return (Ground){
+      .super = super,
+      .body = body,
+      .segment = segment,
+  };
+}
+
+void Ground_destroy(Ground *self) {
+  b2DestroyBody(self->body);
+  self->body = (b2BodyId){0, 0, 0};
+
+  Object2D_destroy(&self->super);
+}
+
+// Segments are drawn as their bounding box so only axis aligned ground looks
+// right
+void Ground_render(Ground *self, RenderContext *ctx) {
+  const float thickness = 2.0f;
+
+  SDL_FPoint transform = RenderContext_getTransform(ctx);
+  const b2Vec2 p1 = self->segment.point1;
+  const b2Vec2 p2 = self->segment.point2;
+
+  SDL_FRect rect = {
+      .x = transform.x + fminf(p1.x, p2.x) * PPM_F,
+      .y = transform.y + fminf(p1.y, p2.y) * PPM_F - thickness,
+      .w = fabsf(p2.x - p1.x) * PPM_F + thickness,
+      .h = fabsf(p2.y - p1.y) * PPM_F + thickness,
+  };
+  RenderContext_fillRect(ctx, self->super.layer, &rect,
+                         (SDL_Color){0x80, 0x80, 0x80, 0xFF});
+  Object2D_render(&self->super, ctx);
+}
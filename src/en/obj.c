@@ -20,9 +20,14 @@
 #include "debug/debug.h"
 #include "screen/ctx.h"
 #include "util/safe.h"
+#include "util/options.h"
 #include "util/types.h"
 #include <stdio.h>
 
+// Any object marked dirty since the last frame. Objects are marked from the
+// fixed update thread and the frame reads it on the main thread
+static SDL_AtomicInt object_damage = {1};
+
 Object2D Object2D_default() { return Object2D_create(0.0f, 0.0f, 1.0f, 1.0f); }
 
 // This is a very messy constructor
@@ -33,6 +38,8 @@ Object2D Object2D_create(float x, float y, float width, float height) {
       .pos = {.x = x, .y = y},
       .width = width,
       .height = height,
+      .layer = RENDER_LAYER_WORLD,
+      .dirty = {1},
       .children = List_create(&std_allocator, 0),
       .postRender = Object2D_postRender,
       .preRender = Object2D_preRender,
@@ -88,4 +95,68 @@ void Object2D_addChild(Object2D *self, Object2D *child) {
   node->obj = child;
 
   child->parent = self;
+  Object2D_markDirty(self);
+}
+
+void Object2D_markDirty(Object2D *self) {
+  SDL_SetAtomicInt(&object_damage, 1);
+
+  // Stop early. A dirty object always has dirty ancestors
+  for (Object2D *obj = self; obj != NULL && !Object2D_isDirty(obj);
+       obj = obj->parent) {
+    SDL_SetAtomicInt(&obj->dirty, 1);
+  }
+}
+
+void Object2D_clearDirty(Object2D *self) {
+  if (SDL_SetAtomicInt(&self->dirty, 0) == 0)
+    return;
+  for (Object2DNode *head = (Object2DNode *)self->children.head; head != NULL;
+       head = (Object2DNode *)head->next) {
+    Object2D_clearDirty(head->obj);
+  }
+}
+
+bool Object2D_isDirty(Object2D *self) {
+  return SDL_GetAtomicInt(&self->dirty) != 0;
+}
+
+void Object2D_setPosition(Object2D *self, SDL_FPoint pos) {
+  if (self->pos.x == pos.x && self->pos.y == pos.y)
+    return;
+  self->pos = pos;
+  Object2D_markDirty(self);
+}
+
+void Object2D_setSize(Object2D *self, float width, float height) {
+  if (self->width == width && self->height == height)
+    return;
+  self->width = width;
+  self->height = height;
+  Object2D_markDirty(self);
+}
+
+void Object2D_setLayer(Object2D *self, Uint8 layer) {
+  if (self->layer == layer)
+    return;
+  self->layer = layer;
+  Object2D_markDirty(self);
+}
+
+bool Object2D_takeDamage(void) {
+  return SDL_SetAtomicInt(&object_damage, 0) != 0;
+}
+
+void Object2D_syncBodies(b2WorldId world) {
+  // Box2D only reports bodies that moved, so resting bodies cost nothing
+  b2BodyEvents events = b2World_GetBodyEvents(world);
+  for (int i = 0; i < events.moveCount; i++) {
+    const b2BodyMoveEvent *event = &events.moveEvents[i];
+    Object2D *obj = event->userData;
+    if (obj == NULL)
+      continue;
+
+    const b2Vec2 pos = event->transform.p;
+    Object2D_setPosition(obj, (SDL_FPoint){pos.x * PPM_F, pos.y * PPM_F});
+  }
 }
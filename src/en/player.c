@@ -72,23 +72,43 @@ void Player_render(Player *self, RenderContext *ctx) {
       .w = self->super.width,
       .h = self->super.height,
   };
-  SDL_SetRenderDrawColor(ctx->renderer, 0xFF, 0xFF, 0xFF, 0xFF);
-  SDL_RenderFillRect(ctx->renderer, &rect);
+  RenderContext_fillRect(ctx, self->super.layer, &rect,
+                         (SDL_Color){0xFF, 0xFF, 0xFF, 0xFF});
   Object2D_render(&self->super, ctx);
 }
 
-void Player_update(Player *self, double delta_time) {
-  b2Vec2 pos = b2Body_GetPosition(self->body);
-  self->super.pos = (SDL_FPoint){pos.x * PPM_F, pos.y * PPM_F};
+SDL_Surface *Player_createImage(int width, int height) {
+  SDL_Surface *surface =
+      SDL_CreateSurface(width, height, SDL_PIXELFORMAT_RGBA32);
+  if (surface == NULL) {
+    SDL_Log("Failed to create player image: %s", SDL_GetError());
+    return NULL;
+  }
+  SDL_FillSurfaceRect(surface, NULL,
+                      SDL_MapSurfaceRGBA(surface, 0xFF, 0xFF, 0xFF, 0xFF));
+  // A visor across the top quarter, so it's clear which way is up
+  const SDL_Rect visor = {
+      .x = 1,
+      .y = height / 4,
+      .w = width - 2,
+      .h = SDL_max(height / 8, 1),
+  };
+  SDL_FillSurfaceRect(surface, &visor,
+                      SDL_MapSurfaceRGBA(surface, 0x30, 0x60, 0xC0, 0xFF));
+  return surface;
+}
 
+// The position is synced from the body by `Object2D_syncBodies`
+void Player_update(Player *self, double delta_time) {
   if (self->controller == NULL)
     return;
 
+  const InputState *input = PlayerController_read(self->controller);
   b2Vec2 vel = b2Body_GetLinearVelocity(self->body);
 
   b2Vec2 result = {
-      objrefcallorelse(0, self->controller, getAxisX),
-      vel.y + objrefcallorelse(0, self->controller, getAxisY),
+      input->axes[INPUT_AXIS_X],
+      vel.y + input->axes[INPUT_AXIS_Y],
   };
   if (result.x != 0.0f || result.y != vel.y) {
     vel = b2Lerp(vel, result, 0.3f);
@@ -107,86 +127,69 @@ void Player_update(Player *self, double delta_time) {
  * CONTROLLER CODE
  */
 
-float KeyboardController_getAxisX(KeyboardController *self) {
-  return KEYS[self->right] - KEYS[self->left];
-}
-float KeyboardController_getAxisY(KeyboardController *self) {
-  return KEYS[self->down] - KEYS[self->up];
-}
-float KeyboardController_getAxisRX(KeyboardController *self) {
-  return KEYS[self->secondary_right] - KEYS[self->secondary_left];
-}
-float KeyboardController_getAxisRY(KeyboardController *self) {
-  return KEYS[self->secondary_down] - KEYS[self->secondary_up];
+void PlayerController_publish(PlayerController *self) {
+  InputState *state = InputChannel_getBack(&self->channel);
+  *state = (InputState){0};
+  self->sample(self, state);
+  state->timestamp = SDL_GetTicksNS();
+  InputChannel_publish(&self->channel);
 }
 
-int KeyboardController_getHatX(KeyboardController *self) {
-  return KEYS[self->right] - KEYS[self->left];
-}
-int KeyboardController_getHatY(KeyboardController *self) {
-  return KEYS[self->down] - KEYS[self->up];
+void PlayerController_publishState(PlayerController *self,
+                                   const InputState *state) {
+  InputState *back = InputChannel_getBack(&self->channel);
+  *back = *state;
+  back->timestamp = SDL_GetTicksNS();
+  InputChannel_publish(&self->channel);
 }
 
-bool KeyboardController_getPrimaryButton(KeyboardController *self) {
-  return KEYS[self->primary];
-}
-bool KeyboardController_getSecondaryButton(KeyboardController *self) {
-  return KEYS[self->secondary];
+const InputState *PlayerController_read(PlayerController *self) {
+  return InputChannel_read(&self->channel);
 }
-bool KeyboardController_getTertiaryButton(KeyboardController *self) {
-  return KEYS[self->tertiary];
-}
-bool KeyboardController_getQuaternyButton(KeyboardController *self) {
-  return KEYS[self->quaterny];
+const InputState *PlayerController_current(const PlayerController *self) {
+  return &self->channel.buffers[self->channel.front];
 }
 
-bool KeyboardController_getJump(KeyboardController *self) {
-  return KEYS[self->jump];
-}
-bool KeyboardController_getAction(KeyboardController *self) {
-  return KEYS[self->action];
-}
-bool KeyboardController_getDismount(KeyboardController *self) {
-  return KEYS[self->dismount];
-}
-bool KeyboardController_getAttack(KeyboardController *self) {
-  return KEYS[self->attack];
+// Reads `KEYS`, so only call it on the main thread
+void KeyboardController_sample(KeyboardController *self, InputState *state) {
+  state->axes[INPUT_AXIS_X] = KEYS[self->right] - KEYS[self->left];
+  state->axes[INPUT_AXIS_Y] = KEYS[self->down] - KEYS[self->up];
+  state->axes[INPUT_AXIS_RX] =
+      KEYS[self->secondary_right] - KEYS[self->secondary_left];
+  state->axes[INPUT_AXIS_RY] =
+      KEYS[self->secondary_down] - KEYS[self->secondary_up];
+
+  state->hat_x = KEYS[self->right] - KEYS[self->left];
+  state->hat_y = KEYS[self->down] - KEYS[self->up];
+
+  InputState_setPressed(state, INPUT_BUTTON_PRIMARY, KEYS[self->primary]);
+  InputState_setPressed(state, INPUT_BUTTON_SECONDARY, KEYS[self->secondary]);
+  InputState_setPressed(state, INPUT_BUTTON_TERTIARY, KEYS[self->tertiary]);
+  InputState_setPressed(state, INPUT_BUTTON_QUATERNY, KEYS[self->quaterny]);
+
+  InputState_setPressed(state, INPUT_BUTTON_JUMP, KEYS[self->jump]);
+  InputState_setPressed(state, INPUT_BUTTON_ACTION, KEYS[self->action]);
+  InputState_setPressed(state, INPUT_BUTTON_DISMOUNT, KEYS[self->dismount]);
+  InputState_setPressed(state, INPUT_BUTTON_ATTACK, KEYS[self->attack]);
 }
+
 void KeyboardController_destroy(KeyboardController *self) {
   debugAssert(self != NULL, "self == NULL");
   freePtr(self->allocator, self);
 }
 
-const PlayerController KEYBOARD_SUPER = {
-    .getAxisX = (float (*)(PlayerController *))KeyboardController_getAxisX,
-    .getAxisY = (float (*)(PlayerController *))KeyboardController_getAxisY,
-    .getAxisRX = (float (*)(PlayerController *))KeyboardController_getAxisRX,
-    .getAxisRY = (float (*)(PlayerController *))KeyboardController_getAxisRY,
-
-    .getHatX = (int (*)(PlayerController *))KeyboardController_getHatX,
-    .getHatY = (int (*)(PlayerController *))KeyboardController_getHatY,
-
-    .getPrimaryButton =
-        (bool (*)(PlayerController *))KeyboardController_getPrimaryButton,
-    .getSecondaryButton =
-        (bool (*)(PlayerController *))KeyboardController_getSecondaryButton,
-    .getTertiaryButton =
-        (bool (*)(PlayerController *))KeyboardController_getTertiaryButton,
-    .getQuaternyButton =
-        (bool (*)(PlayerController *))KeyboardController_getQuaternyButton,
-
-    .getJump = (bool (*)(PlayerController *))KeyboardController_getJump,
-    .getAction = (bool (*)(PlayerController *))KeyboardController_getAction,
-    .getDismount = (bool (*)(PlayerController *))KeyboardController_getDismount,
-    .getAttack = (bool (*)(PlayerController *))KeyboardController_getAttack,
-    .destroy = (void (*)(PlayerController *))KeyboardController_destroy,
-};
-
 KeyboardController *KeyboardController_default(Allocator *allocator) {
   KeyboardController *self = allocPtr(allocator, sizeof(KeyboardController), 1);
 
   *self = (KeyboardController){
-      .super = KEYBOARD_SUPER,
+      .super =
+          {
+              .sample = (void (*)(PlayerController *,
+                                  InputState *))KeyboardController_sample,
+              .destroy =
+                  (void (*)(PlayerController *))KeyboardController_destroy,
+              .channel = InputChannel_create(),
+          },
       .allocator = allocator,
 
       .left = SDL_SCANCODE_LEFT,
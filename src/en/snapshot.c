@@ -0,0 +1,194 @@
+/*
+    World Snapshot
+    Copyright (C) 2025  Ashton Warner
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "debug/debug.h"
+#include "en/snapshot.h"
+#include "util/stack.h"
+#include "util/types.h"
+
+#define SNAPSHOT_HEADER_SIZE 12
+
+typedef Stack(b2BodyId) SnapshotBodyStack;
+
+static bool SnapshotLayout_collectBody(b2ShapeId shape, void *context) {
+  const b2BodyId body = b2Shape_GetBody(shape);
+  // Static bodies never move
+  if (b2Body_GetType(body) != b2_staticBody) {
+    Stack_push(*(SnapshotBodyStack *)context, body);
+  }
+  return true;
+}
+
+static int SnapshotLayout_compareBodies(const void *a, const void *b) {
+  const b2BodyId *x = a;
+  const b2BodyId *y = b;
+  return (x->index1 > y->index1) - (x->index1 < y->index1);
+}
+
+static size_t SnapshotLayout_countObjects(const Object2D *object) {
+  size_t count = 1;
+  for (Object2DNode *head = (Object2DNode *)object->children.head;
+       head != NULL && head->obj != NULL; head = (Object2DNode *)head->next) {
+    count += SnapshotLayout_countObjects(head->obj);
+  }
+  return count;
+}
+
+static size_t SnapshotLayout_collectObjects(Object2D *object, Object2D **out) {
+  size_t count = 0;
+  out[count++] = object;
+  for (Object2DNode *head = (Object2DNode *)object->children.head;
+       head != NULL && head->obj != NULL; head = (Object2DNode *)head->next) {
+    count += SnapshotLayout_collectObjects(head->obj, &out[count]);
+  }
+  return count;
+}
+
+SnapshotLayout SnapshotLayout_create(Allocator *allocator, b2WorldId world,
+                                     Object2D *const *roots,
+                                     size_t root_count) {
+  // A shape per body is enough, but bodies with several turn up more than
+  // once and have to be dropped
+  SnapshotBodyStack found = Stack_create(b2BodyId, allocator);
+  const b2AABB everywhere = {
+      .lowerBound = {-SNAPSHOT_WORLD_EXTENT, -SNAPSHOT_WORLD_EXTENT},
+      .upperBound = {SNAPSHOT_WORLD_EXTENT, SNAPSHOT_WORLD_EXTENT},
+  };
+  b2World_OverlapAABB(world, everywhere, b2DefaultQueryFilter(),
+                      SnapshotLayout_collectBody, &found);
+  SDL_qsort(found.data.ptr, found.len, sizeof(b2BodyId),
+            SnapshotLayout_compareBodies);
+
+  size_t body_count = 0;
+  for (size_t i = 0; i < found.len; i++) {
+    if (body_count == 0 ||
+        found.data.ptr[i].index1 != found.data.ptr[body_count - 1].index1)
+      found.data.ptr[body_count++] = found.data.ptr[i];
+  }
+  b2BodyId *bodies = NULL;
+  if (body_count > 0) {
+    bodies = allocPtr(allocator, sizeof(b2BodyId), body_count);
+    SDL_memcpy(bodies, found.data.ptr, sizeof(b2BodyId) * body_count);
+  }
+  Stack_destroy(found);
+
+  size_t object_count = 0;
+  for (size_t root = 0; root < root_count; root++) {
+    object_count += SnapshotLayout_countObjects(roots[root]);
+  }
+  Object2D **objects = NULL;
+  if (object_count > 0) {
+    objects = allocPtr(allocator, sizeof(Object2D *), object_count);
+    size_t next = 0;
+    for (size_t root = 0; root < root_count; root++) {
+      next += SnapshotLayout_collectObjects(roots[root], &objects[next]);
+    }
+  }
+
+  const size_t awake_bytes = ((body_count + 31) / 32) * 4;
+  return (SnapshotLayout){
+      .allocator = allocator,
+      .bodies = bodies,
+      .body_count = body_count,
+      .objects = objects,
+      .object_count = object_count,
+      .size = SNAPSHOT_HEADER_SIZE + body_count * sizeof(SnapshotBody) +
+              object_count * sizeof(SnapshotObject) + awake_bytes,
+  };
+}
+
+void SnapshotLayout_destroy(SnapshotLayout *self) {
+  if (self->bodies != NULL) {
+    freePtr(self->allocator, self->bodies);
+  }
+  if (self->objects != NULL) {
+    freePtr(self->allocator, self->objects);
+  }
+  *self = (SnapshotLayout){0};
+}
+
+void SnapshotLayout_save(const SnapshotLayout *self, Uint8 *buffer) {
+  debugAssert(self != NULL, "self == NULL");
+  debugAssert(buffer != NULL, "buffer == NULL");
+
+  const Uint32 counts[2] = {(Uint32)self->body_count,
+                            (Uint32)self->object_count};
+  SDL_memcpy(buffer, SNAPSHOT_MAGIC, 4);
+  SDL_memcpy(&buffer[4], counts, sizeof(counts));
+
+  SnapshotBody *bodies = (SnapshotBody *)&buffer[SNAPSHOT_HEADER_SIZE];
+  SnapshotObject *objects = (SnapshotObject *)&bodies[self->body_count];
+  Uint32 *awake = (Uint32 *)&objects[self->object_count];
+
+  for (size_t i = 0; i < self->body_count; i++) {
+    const b2BodyId body = self->bodies[i];
+    const b2Transform transform = b2Body_GetTransform(body);
+    bodies[i] = (SnapshotBody){
+        .position = transform.p,
+        .rotation = transform.q,
+        .linear_velocity = b2Body_GetLinearVelocity(body),
+        .angular_velocity = b2Body_GetAngularVelocity(body),
+    };
+    if (i % 32 == 0)
+      awake[i / 32] = 0;
+    awake[i / 32] |= (Uint32)b2Body_IsAwake(body) << (i % 32);
+  }
+  for (size_t i = 0; i < self->object_count; i++) {
+    const Object2D *object = self->objects[i];
+    objects[i] = (SnapshotObject){
+        .pos = object->pos,
+        .width = object->width,
+        .height = object->height,
+    };
+  }
+}
+
+bool SnapshotLayout_restore(const SnapshotLayout *self, const Uint8 *buffer) {
+  debugAssert(self != NULL, "self == NULL");
+  debugAssert(buffer != NULL, "buffer == NULL");
+
+  Uint32 counts[2];
+  SDL_memcpy(counts, &buffer[4], sizeof(counts));
+  if (SDL_memcmp(buffer, SNAPSHOT_MAGIC, 4) != 0 ||
+      counts[0] != self->body_count || counts[1] != self->object_count)
+    return false;
+
+  const SnapshotBody *bodies =
+      (const SnapshotBody *)&buffer[SNAPSHOT_HEADER_SIZE];
+  const SnapshotObject *objects =
+      (const SnapshotObject *)&bodies[self->body_count];
+  const Uint32 *awake = (const Uint32 *)&objects[self->object_count];
+
+  for (size_t i = 0; i < self->body_count; i++) {
+    const b2BodyId body = self->bodies[i];
+    const SnapshotBody *saved = &bodies[i];
+    b2Body_SetTransform(body, saved->position, saved->rotation);
+    b2Body_SetLinearVelocity(body, saved->linear_velocity);
+    b2Body_SetAngularVelocity(body, saved->angular_velocity);
+  }
+  // Setting a velocity wakes the body, so sleep goes back last
+  for (size_t i = 0; i < self->body_count; i++) {
+    b2Body_SetAwake(self->bodies[i], (awake[i / 32] >> (i % 32)) & 1);
+  }
+  for (size_t i = 0; i < self->object_count; i++) {
+    Object2D *object = self->objects[i];
+    Object2D_setPosition(object, objects[i].pos);
+    Object2D_setSize(object, objects[i].width, objects[i].height);
+  }
+  return true;
+}
@@ -0,0 +1,63 @@
+/*
+    Atlas Sprite Object
+    Copyright (C) 2025  Ashton Warner
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "en/sprite.h"
+#include "debug/debug.h"
+#include "screen/ctx.h"
+
+Sprite Sprite_create(const AtlasRegion *region, float width, float height) {
+  Object2D super = Object2D_create(0, 0, width, height);
+  super.render = (void (*)(Object2D *, RenderContext *))Sprite_render;
+
+  return (Sprite){
+      .super = super,
+      .region = region,
+      .tint = {1.0f, 1.0f, 1.0f, 1.0f},
+  };
+}
+
+void Sprite_render(Sprite *self, RenderContext *ctx) {
+  if (self->region != NULL) {
+    SDL_FPoint transform = RenderContext_getTransform(ctx);
+    SDL_FRect dst = {
+        .x = transform.x - self->super.width / 2.0f,
+        .y = transform.y - self->super.height / 2.0f,
+        .w = self->super.width,
+        .h = self->super.height,
+    };
+    RenderContext_drawSprite(ctx, self->super.layer, self->region->texture,
+                             self->region->texture_id, &dst,
+                             &self->region->uv, self->tint);
+  }
+  Object2D_render(&self->super, ctx);
+}
+
+void Sprite_setRegion(Sprite *self, const AtlasRegion *region) {
+  if (self->region == region)
+    return;
+  self->region = region;
+  Object2D_markDirty(&self->super);
+}
+
+void Sprite_setTint(Sprite *self, SDL_FColor tint) {
+  if (self->tint.r == tint.r && self->tint.g == tint.g &&
+      self->tint.b == tint.b && self->tint.a == tint.a)
+    return;
+  self->tint = tint;
+  Object2D_markDirty(&self->super);
+}
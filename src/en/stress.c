@@ -0,0 +1,245 @@
+/*
+    Physics Stress Scenes
+    Copyright (C) 2025  Ashton Warner
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <SDL3/SDL.h>
+
+#include "debug/debug.h"
+#include "en/stress.h"
+
+static const char *STRESS_SCENE_NAME_TABLE[STRESS_SCENE_COUNT] =
+    STRESS_SCENE_NAMES;
+
+enum StressScene StressScene_fromName(const char *name) {
+  for (int scene = 0; scene < STRESS_SCENE_COUNT; scene++) {
+    if (SDL_strcmp(name, STRESS_SCENE_NAME_TABLE[scene]) == 0)
+      return (enum StressScene)scene;
+  }
+  return STRESS_SCENE_COUNT;
+}
+
+const char *StressScene_getName(enum StressScene scene) {
+  debugAssert(scene < STRESS_SCENE_COUNT, "scene %d out of range", scene);
+  return STRESS_SCENE_NAME_TABLE[scene];
+}
+
+static size_t StressScene_count(size_t count, float scale) {
+  return SDL_max((size_t)1, (size_t)(count * scale));
+}
+
+// A walled pit `width` wide with its floor along the origin. Up is -y
+static void StressScene_buildPit(StressSceneInfo *info, b2WorldId world,
+                                 b2Vec2 origin, float width, float height) {
+  b2BodyDef body_def = b2DefaultBodyDef();
+  body_def.position = origin;
+  b2BodyId body = b2CreateBody(world, &body_def);
+  b2ShapeDef shape_def = b2DefaultShapeDef();
+
+  const b2Polygon walls[] = {
+      b2MakeOffsetBox(width / 2.0f + 1.0f, 0.5f,
+                      (b2Vec2){width / 2.0f, 0.5f}, b2Rot_identity),
+      b2MakeOffsetBox(0.5f, height / 2.0f,
+                      (b2Vec2){-0.5f, -height / 2.0f}, b2Rot_identity),
+      b2MakeOffsetBox(0.5f, height / 2.0f,
+                      (b2Vec2){width + 0.5f, -height / 2.0f}, b2Rot_identity),
+  };
+  for (size_t i = 0; i < sizeof(walls) / sizeof(*walls); i++) {
+    b2CreatePolygonShape(body, &shape_def, &walls[i]);
+  }
+  info->bodies++;
+  info->shapes += sizeof(walls) / sizeof(*walls);
+}
+
+static void StressScene_buildBoxes(StressSceneInfo *info, b2WorldId world,
+                                   b2Vec2 origin, float scale) {
+  const size_t count = StressScene_count(4000, scale);
+  const size_t columns = 100;
+  const float spacing = 0.25f;
+  StressScene_buildPit(info, world, origin, columns * spacing + spacing,
+                       (count / columns + 1) * spacing + 2.0f);
+
+  b2BodyDef body_def = b2DefaultBodyDef();
+  body_def.type = b2_dynamicBody;
+  b2ShapeDef shape_def = b2DefaultShapeDef();
+  shape_def.density = 1.0f;
+  const b2Polygon box = b2MakeSquare(0.1f);
+
+  for (size_t i = 0; i < count; i++) {
+    // Every other row is offset so the pile settles unevenly
+    const size_t row = i / columns;
+    body_def.position = (b2Vec2){
+        origin.x + spacing + (i % columns) * spacing +
+            (row & 1) * spacing / 2.0f,
+        origin.y - 0.5f - row * spacing,
+    };
+    b2CreatePolygonShape(b2CreateBody(world, &body_def), &shape_def, &box);
+  }
+  info->bodies += count;
+  info->shapes += count;
+}
+
+static void StressScene_buildHulls(StressSceneInfo *info, b2WorldId world,
+                                   b2Vec2 origin, float scale) {
+  const size_t count = StressScene_count(400, scale);
+  const size_t columns = 20;
+  const float width = 2.6f;
+  const float height = 0.8f;
+  StressScene_buildPit(info, world, origin, columns * width,
+                       (count / columns + 1) * height + 2.0f);
+
+  // A ship's cross section, deck up
+  const b2Vec2 points[] = {
+      {-1.2f, -0.3f}, {1.2f, -0.3f}, {1.0f, 0.1f},
+      {0.5f, 0.4f},   {-0.5f, 0.4f}, {-1.0f, 0.1f},
+  };
+  const b2Hull hull = b2ComputeHull(points, sizeof(points) / sizeof(*points));
+  debugAssert(hull.count > 0, "ship hull is degenerate");
+  const b2Polygon polygon = b2MakePolygon(&hull, 0.0f);
+
+  b2BodyDef body_def = b2DefaultBodyDef();
+  body_def.type = b2_dynamicBody;
+  b2ShapeDef shape_def = b2DefaultShapeDef();
+  shape_def.density = 1.0f;
+
+  for (size_t i = 0; i < count; i++) {
+    body_def.position = (b2Vec2){
+        origin.x + width / 2.0f + (i % columns) * width,
+        origin.y - 0.5f - (i / columns) * height,
+    };
+    b2CreatePolygonShape(b2CreateBody(world, &body_def), &shape_def, &polygon);
+  }
+  info->bodies += count;
+  info->shapes += count;
+}
+
+static void StressScene_buildJoints(StressSceneInfo *info, b2WorldId world,
+                                    b2Vec2 origin, float scale) {
+  const size_t links = 50;
+  const size_t chains = StressScene_count(40, scale);
+  const float link_length = 0.25f;
+  const float spacing = 0.5f;
+  const float top = -(links * link_length + 1.0f);
+
+  b2BodyDef anchor_def = b2DefaultBodyDef();
+  anchor_def.position = origin;
+  b2BodyId anchor = b2CreateBody(world, &anchor_def);
+  info->bodies++;
+
+  b2BodyDef body_def = b2DefaultBodyDef();
+  body_def.type = b2_dynamicBody;
+  b2ShapeDef shape_def = b2DefaultShapeDef();
+  shape_def.density = 1.0f;
+  const b2Polygon link = b2MakeBox(link_length / 2.0f, 0.05f);
+
+  b2RevoluteJointDef joint_def = b2DefaultRevoluteJointDef();
+  for (size_t chain = 0; chain < chains; chain++) {
+    const float x = chain * spacing;
+    b2BodyId previous = anchor;
+    b2Vec2 previous_anchor = {x, top};
+
+    // Links start out horizontal so the chains swing
+    for (size_t i = 0; i < links; i++) {
+      body_def.position = (b2Vec2){
+          origin.x + x + (i + 0.5f) * link_length,
+          origin.y + top,
+      };
+      b2BodyId body = b2CreateBody(world, &body_def);
+      b2CreatePolygonShape(body, &shape_def, &link);
+
+      joint_def.bodyIdA = previous;
+      joint_def.bodyIdB = body;
+      joint_def.localAnchorA = previous_anchor;
+      joint_def.localAnchorB = (b2Vec2){-link_length / 2.0f, 0.0f};
+      b2CreateRevoluteJoint(world, &joint_def);
+
+      previous = body;
+      previous_anchor = (b2Vec2){link_length / 2.0f, 0.0f};
+    }
+  }
+  info->bodies += chains * links;
+  info->shapes += chains * links;
+  info->joints += chains * links;
+}
+
+static void StressScene_buildSensors(StressSceneInfo *info, b2WorldId world,
+                                     b2Vec2 origin, float scale) {
+  const size_t columns = 25;
+  const size_t rows = 20;
+  const size_t balls = StressScene_count(1000, scale);
+  const float cell = 1.0f;
+  StressScene_buildPit(info, world, origin, columns * cell,
+                       rows * cell + 4.0f);
+
+  // Sensors only report visitors that opt in, on both sides
+  b2BodyDef sensor_body_def = b2DefaultBodyDef();
+  sensor_body_def.position = origin;
+  b2BodyId sensors = b2CreateBody(world, &sensor_body_def);
+  b2ShapeDef sensor_def = b2DefaultShapeDef();
+  sensor_def.isSensor = true;
+  sensor_def.enableSensorEvents = true;
+  for (size_t i = 0; i < columns * rows; i++) {
+    const b2Polygon box = b2MakeOffsetBox(
+        cell * 0.4f, cell * 0.4f,
+        (b2Vec2){(i % columns + 0.5f) * cell, -(i / columns + 0.5f) * cell},
+        b2Rot_identity);
+    b2CreatePolygonShape(sensors, &sensor_def, &box);
+  }
+  info->bodies++;
+  info->shapes += columns * rows;
+
+  b2BodyDef body_def = b2DefaultBodyDef();
+  body_def.type = b2_dynamicBody;
+  b2ShapeDef shape_def = b2DefaultShapeDef();
+  shape_def.density = 1.0f;
+  shape_def.enableSensorEvents = true;
+  const b2Circle circle = {.center = {0.0f, 0.0f}, .radius = 0.1f};
+
+  // Dropped from above the grid so they fall through all of it
+  const size_t per_row = columns * 4;
+  for (size_t i = 0; i < balls; i++) {
+    body_def.position = (b2Vec2){
+        origin.x + (i % per_row + 0.5f) * cell / 4.0f,
+        origin.y - (rows * cell + 1.0f + (i / per_row) * cell / 4.0f),
+    };
+    b2CreateCircleShape(b2CreateBody(world, &body_def), &shape_def, &circle);
+  }
+  info->bodies += balls;
+  info->shapes += balls;
+}
+
+StressSceneInfo StressScene_build(enum StressScene scene, b2WorldId world,
+                                  b2Vec2 origin, float scale) {
+  StressSceneInfo info = {0};
+  switch (scene) {
+  case STRESS_SCENE_BOXES:
+    StressScene_buildBoxes(&info, world, origin, scale);
+    break;
+  case STRESS_SCENE_HULLS:
+    StressScene_buildHulls(&info, world, origin, scale);
+    break;
+  case STRESS_SCENE_JOINTS:
+    StressScene_buildJoints(&info, world, origin, scale);
+    break;
+  case STRESS_SCENE_SENSORS:
+    StressScene_buildSensors(&info, world, origin, scale);
+    break;
+  case STRESS_SCENE_NONE:
+  case STRESS_SCENE_COUNT:
+    break;
+  }
+  return info;
+}
@@ -28,6 +28,8 @@ Object2D TestObj_create(float width, float height) {
   Object2D super = Object2D_create(0, 0, width, height);
 
   super.render = TestObj_render;
+  // Drawn over its parent, and the origin marker over the body
+  super.layer = RENDER_LAYER_WORLD + 1;
   return super;
 }
 
@@ -39,8 +41,8 @@ void TestObj_render(Object2D *self, RenderContext *ctx) {
       .w = self->width,
       .h = self->height,
   };
-  SDL_SetRenderDrawColor(ctx->renderer, 0xff, 0, 0, 0xff);
-  SDL_RenderFillRect(ctx->renderer, &rect);
+  RenderContext_fillRect(ctx, self->layer, &rect,
+                         (SDL_Color){0xff, 0, 0, 0xff});
 
   const int origin_radius = 2;
   SDL_FRect origin_rect = {
@@ -50,8 +52,8 @@ void TestObj_render(Object2D *self, RenderContext *ctx) {
       .h = origin_radius * 2,
   };
 
-  SDL_SetRenderDrawColor(ctx->renderer, 0, 0xff, 0, 0xff);
-  SDL_RenderFillRect(ctx->renderer, &origin_rect);
+  RenderContext_fillRect(ctx, self->layer + 1, &origin_rect,
+                         (SDL_Color){0, 0xff, 0, 0xff});
 
   Object2D_render(self, ctx);
 }
@@ -62,13 +64,15 @@ void TestObj_update(Object2D *self, double delta_time) {
 
   const int speed = 256 / (self->width * self->height) * 1000;
 
+  SDL_FPoint pos = self->pos;
   if (dx != 0 && dy != 0) {
-    self->pos.x += dx * delta_time * speed * M_SQRT1_2;
-    self->pos.y += dy * delta_time * speed * M_SQRT1_2;
+    pos.x += dx * delta_time * speed * M_SQRT1_2;
+    pos.y += dy * delta_time * speed * M_SQRT1_2;
   } else {
-    self->pos.x += dx * delta_time * speed;
-    self->pos.y += dy * delta_time * speed;
+    pos.x += dx * delta_time * speed;
+    pos.y += dy * delta_time * speed;
   }
+  Object2D_setPosition(self, pos);
 
   Object2D_update(self, delta_time);
 }
@@ -0,0 +1,45 @@
+#include "heap/counting_allocator.h"
+#include "debug/debug.h"
+#include "heap/allocator.h"
+
+static void *CountingAllocator_alloc(CountingAllocator *self, size_t elem_size,
+                                     size_t num_of_elems) {
+  debugAssert(self != NULL, "self == NULL");
+  self->allocations++;
+  self->bytes += elem_size * num_of_elems;
+  return allocPtr(self->m_allocator, elem_size, num_of_elems);
+}
+
+static void CountingAllocator_free(CountingAllocator *self, void *ptr) {
+  debugAssert(self != NULL, "self == NULL");
+  self->frees++;
+  freePtr(self->m_allocator, ptr);
+}
+
+static void *CountingAllocator_remap(CountingAllocator *self, size_t ptr_size,
+                                     char ptr[ptr_size], size_t elem_size,
+                                     size_t num_of_elems) {
+  debugAssert(self != NULL, "self == NULL");
+  self->remaps++;
+  self->bytes += elem_size * num_of_elems;
+  return remapBlock(self->m_allocator, ptr_size, ptr, elem_size, num_of_elems);
+}
+
+CountingAllocator CountingAllocator_create(Allocator *allocator) {
+  return (CountingAllocator){
+      .allocations = 0,
+      .frees = 0,
+      .remaps = 0,
+      .bytes = 0,
+      .m_allocator = allocator,
+      .alloc = CountingAllocator_alloc,
+      .free = CountingAllocator_free,
+      .remap = CountingAllocator_remap,
+  };
+}
+
+__attribute__((const)) Allocator *
+CountingAllocator_getAllocator(CountingAllocator *self) {
+  debugAssert(self != NULL, "self == NULL");
+  return &self->super;
+}
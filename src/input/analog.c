@@ -0,0 +1,227 @@
+/*
+    Analog Axis Processing
+    Copyright (C) 2025  Ashton Warner
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "debug/debug.h"
+#include "input/analog.h"
+
+// Keeps the direction of a centered stick from dividing by zero
+#define ANALOG_EPSILON 1e-6f
+
+AnalogSettings AnalogSettings_default() {
+  return (AnalogSettings){
+      .inner_deadzone = 0.1f,
+      .outer_deadzone = 0.95f,
+      .curve = 0.0f,
+      .smoothing = 0.0f,
+  };
+}
+
+AnalogStage AnalogStage_create(Allocator *allocator, size_t sticks) {
+  const size_t capacity =
+      (sticks + ANALOG_LANES - 1) / ANALOG_LANES * ANALOG_LANES;
+  AnalogStage self = {
+      .allocator = allocator,
+      .count = sticks,
+      .capacity = capacity,
+      .x = allocPtr(allocator, sizeof(float), capacity),
+      .y = allocPtr(allocator, sizeof(float), capacity),
+      .inner = allocPtr(allocator, sizeof(float), capacity),
+      .inv_span = allocPtr(allocator, sizeof(float), capacity),
+      .curve = allocPtr(allocator, sizeof(float), capacity),
+      .alpha = allocPtr(allocator, sizeof(float), capacity),
+      .out_x = allocPtr(allocator, sizeof(float), capacity),
+      .out_y = allocPtr(allocator, sizeof(float), capacity),
+      .scaled_x = allocPtr(allocator, sizeof(Sint32), capacity),
+      .scaled_y = allocPtr(allocator, sizeof(Sint32), capacity),
+  };
+  // Padding lanes get settings too, so they compute zeros instead of NaNs
+  for (size_t i = 0; i < capacity; i++) {
+    AnalogStage_configure(&self, i, AnalogSettings_default());
+    self.x[i] = self.y[i] = 0.0f;
+    self.out_x[i] = self.out_y[i] = 0.0f;
+    self.scaled_x[i] = self.scaled_y[i] = 0;
+  }
+  return self;
+}
+
+void AnalogStage_destroy(AnalogStage *self) {
+  freePtr(self->allocator, self->x);
+  freePtr(self->allocator, self->y);
+  freePtr(self->allocator, self->inner);
+  freePtr(self->allocator, self->inv_span);
+  freePtr(self->allocator, self->curve);
+  freePtr(self->allocator, self->alpha);
+  freePtr(self->allocator, self->out_x);
+  freePtr(self->allocator, self->out_y);
+  freePtr(self->allocator, self->scaled_x);
+  freePtr(self->allocator, self->scaled_y);
+}
+
+void AnalogStage_configure(AnalogStage *self, size_t stick,
+                           AnalogSettings settings) {
+  debugAssert(stick < self->capacity, "stick %zu out of range", stick);
+
+  const float inner = SDL_clamp(settings.inner_deadzone, 0.0f, 0.99f);
+  const float outer = SDL_clamp(settings.outer_deadzone, inner + 0.01f, 1.0f);
+  self->inner[stick] = inner;
+  self->inv_span[stick] = 1.0f / (outer - inner);
+  self->curve[stick] = SDL_clamp(settings.curve, 0.0f, 1.0f);
+  self->alpha[stick] = 1.0f - SDL_clamp(settings.smoothing, 0.0f, 0.99f);
+}
+
+void AnalogStage_setInput(AnalogStage *self, size_t stick, float x, float y) {
+  debugAssert(stick < self->count, "stick %zu out of range", stick);
+  self->x[stick] = x;
+  self->y[stick] = y;
+}
+
+void AnalogStage_processScalar(AnalogStage *self) {
+  for (size_t i = 0; i < self->capacity; i++) {
+    const float x = self->x[i];
+    const float y = self->y[i];
+    const float magnitude = SDL_sqrtf(x * x + y * y);
+
+    // Distance past the inner deadzone, as a fraction of the live range
+    const float live =
+        SDL_clamp((magnitude - self->inner[i]) * self->inv_span[i], 0.0f, 1.0f);
+    const float k = self->curve[i];
+    const float shaped = live * ((1.0f - k) + k * live * live);
+    // Keeps the direction, replaces the length
+    const float factor = shaped / SDL_max(magnitude, ANALOG_EPSILON);
+
+    const float alpha = self->alpha[i];
+    self->out_x[i] += alpha * (x * factor - self->out_x[i]);
+    self->out_y[i] += alpha * (y * factor - self->out_y[i]);
+
+    self->scaled_x[i] = SDL_lroundf(self->out_x[i] * ANALOG_RANGE);
+    self->scaled_y[i] = SDL_lroundf(self->out_y[i] * ANALOG_RANGE);
+  }
+}
+
+#ifdef __SSE2__
+static void AnalogStage_processSSE2(AnalogStage *self) {
+  const __m128 zero = _mm_setzero_ps();
+  const __m128 one = _mm_set1_ps(1.0f);
+  const __m128 epsilon = _mm_set1_ps(ANALOG_EPSILON);
+  const __m128 range = _mm_set1_ps(ANALOG_RANGE);
+
+  for (size_t i = 0; i < self->capacity; i += ANALOG_LANES) {
+    const __m128 x = _mm_loadu_ps(&self->x[i]);
+    const __m128 y = _mm_loadu_ps(&self->y[i]);
+    const __m128 magnitude =
+        _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)));
+
+    __m128 live =
+        _mm_mul_ps(_mm_sub_ps(magnitude, _mm_loadu_ps(&self->inner[i])),
+                   _mm_loadu_ps(&self->inv_span[i]));
+    live = _mm_min_ps(_mm_max_ps(live, zero), one);
+    const __m128 k = _mm_loadu_ps(&self->curve[i]);
+    const __m128 shaped = _mm_mul_ps(
+        live, _mm_add_ps(_mm_sub_ps(one, k),
+                         _mm_mul_ps(k, _mm_mul_ps(live, live))));
+    const __m128 factor = _mm_div_ps(shaped, _mm_max_ps(magnitude, epsilon));
+
+    const __m128 alpha = _mm_loadu_ps(&self->alpha[i]);
+    __m128 out_x = _mm_loadu_ps(&self->out_x[i]);
+    __m128 out_y = _mm_loadu_ps(&self->out_y[i]);
+    out_x = _mm_add_ps(
+        out_x, _mm_mul_ps(alpha, _mm_sub_ps(_mm_mul_ps(x, factor), out_x)));
+    out_y = _mm_add_ps(
+        out_y, _mm_mul_ps(alpha, _mm_sub_ps(_mm_mul_ps(y, factor), out_y)));
+    _mm_storeu_ps(&self->out_x[i], out_x);
+    _mm_storeu_ps(&self->out_y[i], out_y);
+
+    // Rounds half to even, where the scalar path rounds half away from zero.
+    // The two can differ by one on exact halves
+    _mm_storeu_si128((__m128i *)&self->scaled_x[i],
+                     _mm_cvtps_epi32(_mm_mul_ps(out_x, range)));
+    _mm_storeu_si128((__m128i *)&self->scaled_y[i],
+                     _mm_cvtps_epi32(_mm_mul_ps(out_y, range)));
+  }
+}
+#endif
+
+void AnalogStage_process(AnalogStage *self) {
+#ifdef __SSE2__
+  AnalogStage_processSSE2(self);
+#else
+  AnalogStage_processScalar(self);
+#endif
+}
+
+// Deterministic stick positions covering the deadzones and the rim
+static void AnalogStage_fillPattern(AnalogStage *self, size_t iteration) {
+  for (size_t i = 0; i < self->count; i++) {
+    const Uint32 hash = (Uint32)((i + 1) * 2654435761u ^ iteration * 40503u);
+    self->x[i] = (float)(hash & 0xFFFF) / 32767.5f - 1.0f;
+    self->y[i] = (float)(hash >> 16) / 32767.5f - 1.0f;
+  }
+}
+
+AnalogBenchmark AnalogStage_benchmark(size_t sticks, size_t iterations) {
+  AnalogStage scalar = AnalogStage_create(&std_allocator, sticks);
+  AnalogStage vector = AnalogStage_create(&std_allocator, sticks);
+  for (size_t i = 0; i < sticks; i++) {
+    const AnalogSettings settings = {
+        .inner_deadzone = 0.05f + (i % 4) * 0.05f,
+        .outer_deadzone = 0.95f,
+        .curve = (i % 3) * 0.5f,
+        .smoothing = (i % 2) * 0.5f,
+    };
+    AnalogStage_configure(&scalar, i, settings);
+    AnalogStage_configure(&vector, i, settings);
+  }
+
+  AnalogBenchmark result = {
+      .scalar_ns_per_stick = 0.0,
+      .vector_ns_per_stick = 0.0,
+      .max_difference = 0,
+  };
+  Uint64 scalar_ns = 0;
+  Uint64 vector_ns = 0;
+  for (size_t n = 0; n < iterations; n++) {
+    AnalogStage_fillPattern(&scalar, n);
+    AnalogStage_fillPattern(&vector, n);
+
+    Uint64 start = SDL_GetTicksNS();
+    AnalogStage_processScalar(&scalar);
+    scalar_ns += SDL_GetTicksNS() - start;
+
+    start = SDL_GetTicksNS();
+    AnalogStage_process(&vector);
+    vector_ns += SDL_GetTicksNS() - start;
+
+    for (size_t i = 0; i < sticks; i++) {
+      const Sint32 dx = SDL_abs(scalar.scaled_x[i] - vector.scaled_x[i]);
+      const Sint32 dy = SDL_abs(scalar.scaled_y[i] - vector.scaled_y[i]);
+      result.max_difference = SDL_max(result.max_difference, SDL_max(dx, dy));
+    }
+  }
+
+  const double processed = (double)sticks * (iterations > 0 ? iterations : 1);
+  result.scalar_ns_per_stick = scalar_ns / processed;
+  result.vector_ns_per_stick = vector_ns / processed;
+
+  AnalogStage_destroy(&scalar);
+  AnalogStage_destroy(&vector);
+  return result;
+}
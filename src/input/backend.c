@@ -0,0 +1,329 @@
+/*
+    Controller Output Backends
+    Copyright (C) 2025  Ashton Warner
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/uinput.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "debug/debug.h"
+#include "input/backend.h"
+#include "util/safe.h"
+
+bool ControllerBackend_write(ControllerBackend *self,
+                             const struct input_event *events, size_t count) {
+  debugAssert(self != NULL, "self == NULL");
+  return self->write(self, events, count);
+}
+
+bool ControllerBackend_poll(ControllerBackend *self,
+                            ControllerFeedback *feedback) {
+  debugAssert(self != NULL, "self == NULL");
+  return safefnelse(false, self->poll, self, feedback);
+}
+
+void ControllerBackend_destroy(ControllerBackend *self) {
+  if (self == NULL)
+    return;
+  self->destroy(self);
+}
+
+// Uinput and the recorder both take whole reports through `fd`
+static bool FdBackend_write(ControllerBackend *self,
+                            const struct input_event *events, size_t count) {
+  // One syscall for the whole report, so the reader never sees half of it
+  const ssize_t expected = count * sizeof(struct input_event);
+  return write(self->fd, events, expected) == expected;
+}
+
+typedef struct UinputBackend {
+  ControllerBackend super;
+  // Effects uploaded by the game, indexed by the id the kernel gave them
+  struct ff_effect effects[UINPUT_FF_EFFECTS];
+} UinputBackend;
+
+// The kernel blocks the uploading game until we answer, so this can't wait
+// for a frame
+static void UinputBackend_answerFF(UinputBackend *self,
+                                   const struct input_event *event) {
+  const int fd = self->super.fd;
+
+  if (event->code == UI_FF_UPLOAD) {
+    struct uinput_ff_upload upload;
+    memset(&upload, 0, sizeof(upload));
+    upload.request_id = event->value;
+    if (ioctl(fd, UI_BEGIN_FF_UPLOAD, &upload) != 0)
+      return;
+
+    if (upload.effect.id >= 0 && upload.effect.id < UINPUT_FF_EFFECTS) {
+      self->effects[upload.effect.id] = upload.effect;
+      upload.retval = 0;
+    } else {
+      upload.retval = -EINVAL;
+    }
+    ioctl(fd, UI_END_FF_UPLOAD, &upload);
+  } else if (event->code == UI_FF_ERASE) {
+    struct uinput_ff_erase erase;
+    memset(&erase, 0, sizeof(erase));
+    erase.request_id = event->value;
+    if (ioctl(fd, UI_BEGIN_FF_ERASE, &erase) != 0)
+      return;
+
+    erase.retval = 0;
+    ioctl(fd, UI_END_FF_ERASE, &erase);
+  }
+}
+
+static bool UinputBackend_poll(ControllerBackend *backend,
+                               ControllerFeedback *feedback) {
+  UinputBackend *self = (UinputBackend *)backend;
+  bool changed = false;
+
+  struct input_event event;
+  while (read(backend->fd, &event, sizeof(event)) == sizeof(event)) {
+    switch (event.type) {
+    case EV_UINPUT:
+      UinputBackend_answerFF(self, &event);
+      break;
+
+    case EV_FF:
+      // Codes below FF_GAIN are effect ids being started or stopped
+      if (event.code >= UINPUT_FF_EFFECTS)
+        break;
+      const struct ff_rumble_effect *rumble =
+          &self->effects[event.code].u.rumble;
+      feedback->strong_magnitude = event.value ? rumble->strong_magnitude : 0;
+      feedback->weak_magnitude = event.value ? rumble->weak_magnitude : 0;
+      changed = true;
+      break;
+
+    case EV_LED:
+      if (event.code >= sizeof(feedback->leds) * 8)
+        break;
+      if (event.value) {
+        feedback->leds |= 1u << event.code;
+      } else {
+        feedback->leds &= ~(1u << event.code);
+      }
+      changed = true;
+      break;
+    }
+  }
+  return changed;
+}
+
+static void UinputBackend_destroy(ControllerBackend *self) {
+  ioctl(self->fd, UI_DEV_DESTROY);
+  close(self->fd);
+  freePtr(self->allocator, self);
+
+  trace("Destroy Device");
+}
+
+ControllerBackend *UinputBackend_create(Allocator *allocator) {
+  // Read access is needed for rumble and LED requests
+  const int fd = open("/dev/uinput", O_RDWR | O_NONBLOCK);
+  if (fd < 0) {
+    SDL_Log("Couldn't open /dev/uinput: %s", strerror(errno));
+    return NULL;
+  }
+
+  bool ok = ioctl(fd, UI_SET_EVBIT, EV_KEY) == 0;
+  for (size_t i = 0; i < CONTROLLER_BUTTON_COUNT; i++) {
+    ok = ok && ioctl(fd, UI_SET_KEYBIT, CONTROLLER_BUTTON_CODES[i]) == 0;
+  }
+
+  ok = ok && ioctl(fd, UI_SET_EVBIT, EV_ABS) == 0;
+  for (size_t i = 0; i < CONTROLLER_AXIS_COUNT; i++) {
+    struct uinput_abs_setup abs = {
+        .code = CONTROLLER_AXIS_CODES[i],
+        .absinfo = ControllerAxis_getAbsInfo(i),
+    };
+    ok = ok && ioctl(fd, UI_ABS_SETUP, &abs) == 0;
+  }
+
+  ok = ok && ioctl(fd, UI_SET_EVBIT, EV_FF) == 0;
+  ok = ok && ioctl(fd, UI_SET_FFBIT, FF_RUMBLE) == 0;
+  // Player indicator
+  ok = ok && ioctl(fd, UI_SET_EVBIT, EV_LED) == 0;
+  ok = ok && ioctl(fd, UI_SET_LEDBIT, LED_MISC) == 0;
+  if (!ok) {
+    SDL_Log("Failed to describe the uinput device: %s", strerror(errno));
+    close(fd);
+    return NULL;
+  }
+
+  struct uinput_setup usetup;
+  memset(&usetup, 0, sizeof(usetup));
+  usetup.id.bustype = BUS_USB;
+  usetup.id.vendor = CONTROLLER_VENDOR_ID;
+  usetup.id.product = CONTROLLER_PRODUCT_ID;
+  usetup.ff_effects_max = UINPUT_FF_EFFECTS;
+  strcpy(usetup.name, "Microsoft X-Box 360 pad x");
+
+  if (-1 == ioctl(fd, UI_DEV_SETUP, &usetup)) {
+    SDL_Log("Failed to setup device: %s", strerror(errno));
+    close(fd);
+    return NULL;
+  }
+  if (-1 == ioctl(fd, UI_DEV_CREATE)) {
+    SDL_Log("Failed to create device: %s", strerror(errno));
+    close(fd);
+    return NULL;
+  }
+  trace("Create Device");
+
+  UinputBackend *self = allocPtr(allocator, sizeof(UinputBackend), 1);
+  *self = (UinputBackend){
+      .super =
+          {
+              .allocator = allocator,
+              .name = "uinput",
+              .fd = fd,
+              .write = FdBackend_write,
+              .poll = UinputBackend_poll,
+              .destroy = UinputBackend_destroy,
+          },
+      .effects = {{0}},
+  };
+  return &self->super;
+}
+
+static void RecorderBackend_destroy(ControllerBackend *self) {
+  if (self->fd != STDOUT_FILENO) {
+    close(self->fd);
+  }
+  freePtr(self->allocator, self);
+}
+
+ControllerBackend *RecorderBackend_create(Allocator *allocator,
+                                          const char *path) {
+  debugAssert(path != NULL, "path == NULL");
+
+  const int fd = strcmp(path, "-") == 0
+                     ? STDOUT_FILENO
+                     : open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) {
+    SDL_Log("Couldn't open %s for recording: %s", path, strerror(errno));
+    return NULL;
+  }
+
+  ControllerBackend *self = allocPtr(allocator, sizeof(ControllerBackend), 1);
+  *self = (ControllerBackend){
+      .allocator = allocator,
+      .name = "recorder",
+      .fd = fd,
+      .write = FdBackend_write,
+      .poll = NULL,
+      .destroy = RecorderBackend_destroy,
+  };
+  return self;
+}
+
+static int MemoryBackend_findCode(const int *codes, size_t count, int code) {
+  for (size_t i = 0; i < count; i++) {
+    if (codes[i] == code)
+      return (int)i;
+  }
+  return -1;
+}
+
+static void MemoryBackend_apply(MemoryBackend *self,
+                                const struct input_event *event) {
+  switch (event->type) {
+  case EV_KEY: {
+    const int button = MemoryBackend_findCode(
+        CONTROLLER_BUTTON_CODES, CONTROLLER_BUTTON_COUNT, event->code);
+    if (button < 0) {
+      self->unknown_codes++;
+    } else if (event->value) {
+      self->partial.buttons |= 1u << button;
+    } else {
+      self->partial.buttons &= ~(1u << button);
+    }
+    break;
+  }
+  case EV_ABS: {
+    const int axis = MemoryBackend_findCode(CONTROLLER_AXIS_CODES,
+                                            CONTROLLER_AXIS_COUNT, event->code);
+    if (axis < 0) {
+      self->unknown_codes++;
+    } else {
+      self->partial.axes[axis] = event->value;
+    }
+    break;
+  }
+  case EV_SYN:
+    if (event->code == SYN_REPORT) {
+      self->state = self->partial;
+      self->reports++;
+    }
+    break;
+  }
+}
+
+static bool MemoryBackend_write(ControllerBackend *backend,
+                                const struct input_event *events,
+                                size_t count) {
+  MemoryBackend *self = (MemoryBackend *)backend;
+  for (size_t i = 0; i < count; i++) {
+    self->events[self->written++ & (self->capacity - 1)] = events[i];
+    MemoryBackend_apply(self, &events[i]);
+  }
+  return true;
+}
+
+static void MemoryBackend_destroy(ControllerBackend *backend) {
+  MemoryBackend *self = (MemoryBackend *)backend;
+  freePtr(backend->allocator, self->events);
+  freePtr(backend->allocator, self);
+}
+
+MemoryBackend *MemoryBackend_create(Allocator *allocator, size_t capacity) {
+  debugAssert(capacity > 0 && (capacity & (capacity - 1)) == 0,
+              "capacity %zu is not a power of two", capacity);
+
+  MemoryBackend *self = allocPtr(allocator, sizeof(MemoryBackend), 1);
+  *self = (MemoryBackend){
+      .super =
+          {
+              .allocator = allocator,
+              .name = "memory",
+              .fd = -1,
+              .write = MemoryBackend_write,
+              .poll = NULL,
+              .destroy = MemoryBackend_destroy,
+          },
+      .capacity = capacity,
+      .events = allocPtr(allocator, sizeof(struct input_event), capacity),
+      .written = 0,
+      .reports = 0,
+      .state = {0},
+      .partial = {0},
+      .unknown_codes = 0,
+  };
+  return self;
+}
+
+const struct input_event *MemoryBackend_getEvent(const MemoryBackend *self,
+                                                 Uint64 index) {
+  if (index >= self->written || self->written - index > self->capacity)
+    return NULL;
+  return &self->events[index & (self->capacity - 1)];
+}
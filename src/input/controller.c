@@ -17,137 +17,237 @@
 */
 
 #include "input/controller.h"
-#include <fcntl.h>
 #include <linux/uinput.h>
 #include <memory.h>
 #include <stdio.h>
 #include <stdlib.h>
-#include <unistd.h>
+#include <sys/time.h>
 
 #include "debug/debug.h"
+#include "input/backend.h"
 
-const ControllerDevice NullControllerDevice = {
-    .fd = -1,
-    .hat = {0},
+const int CONTROLLER_BUTTON_CODES[CONTROLLER_BUTTON_COUNT] = {
+    BTN_A,     BTN_B,      BTN_X,     BTN_Y,      BTN_TL,     BTN_TR,
+    BTN_TL2,   BTN_TR2,    BTN_START, BTN_SELECT, BTN_THUMBL, BTN_THUMBR,
+};
+const int CONTROLLER_AXIS_CODES[CONTROLLER_AXIS_COUNT] = {
+    ABS_X, ABS_Y, ABS_RX, ABS_RY, ABS_HAT0X, ABS_HAT0Y,
 };
 
-ControllerDevice ControllerDevice_default() {
-  struct uinput_setup usetup;
-  int fd = open("/dev/uinput", O_WRONLY | O_NONBLOCK);
-
-  ioctl(fd, UI_SET_EVBIT, EV_KEY);
-  ioctl(fd, UI_SET_KEYBIT, BTN_A);
-  ioctl(fd, UI_SET_KEYBIT, BTN_B);
-  ioctl(fd, UI_SET_KEYBIT, BTN_X);
-  ioctl(fd, UI_SET_KEYBIT, BTN_Y);
-
-  ioctl(fd, UI_SET_KEYBIT, BTN_TL);
-  ioctl(fd, UI_SET_KEYBIT, BTN_TR);
-  ioctl(fd, UI_SET_KEYBIT, BTN_TL2);
-  ioctl(fd, UI_SET_KEYBIT, BTN_TR2);
-  ioctl(fd, UI_SET_KEYBIT, BTN_START);
-  ioctl(fd, UI_SET_KEYBIT, BTN_SELECT);
-  ioctl(fd, UI_SET_KEYBIT, BTN_THUMBL);
-  ioctl(fd, UI_SET_KEYBIT, BTN_THUMBR);
-
-  ioctl(fd, UI_SET_EVBIT, EV_ABS);
-  struct uinput_abs_setup abs = {
-      .code = ABS_X,
-      .absinfo =
-          {
-              .value = 0,
-              .minimum = -32767,
-              .maximum = 32767,
-              .fuzz = 16,
-              .flat = 128,
-              .resolution = 0,
-          },
-  };
+// Ranges reported to the kernel. The axis filters use the same values
+static const struct input_absinfo STICK_ABSINFO = {
+    .value = 0,
+    .minimum = -32767,
+    .maximum = 32767,
+    .fuzz = 16,
+    .flat = 128,
+    .resolution = 0,
+};
+static const struct input_absinfo HAT_ABSINFO = {
+    .value = 0,
+    .minimum = -1,
+    .maximum = 1,
+    .fuzz = 0,
+    .flat = 0,
+    .resolution = 0,
+};
 
-  ioctl(fd, UI_SET_EVBIT, EV_ABS);
-  ioctl(fd, UI_ABS_SETUP, &abs);
-  abs.code = ABS_Y;
-  ioctl(fd, UI_ABS_SETUP, &abs);
-  abs.code = ABS_RX;
-  ioctl(fd, UI_ABS_SETUP, &abs);
-  abs.code = ABS_RY;
-  ioctl(fd, UI_ABS_SETUP, &abs);
-
-  abs.absinfo.flat = 0;
-  abs.absinfo.fuzz = 0;
-  abs.absinfo.maximum = 1;
-  abs.absinfo.minimum = -1;
-  abs.code = ABS_HAT0X;
-  ioctl(fd, UI_ABS_SETUP, &abs);
-  abs.code = ABS_HAT0Y;
-  ioctl(fd, UI_ABS_SETUP, &abs);
-
-  memset(&usetup, 0, sizeof(usetup));
-  usetup.id.bustype = BUS_USB;
-  usetup.id.vendor = 0x28de;
-  usetup.id.product = 0x11ff;
-  strcpy(usetup.name, "Microsoft X-Box 360 pad x");
-
-  if (-1 == ioctl(fd, UI_DEV_SETUP, &usetup)) {
-    fprintf(stderr, "Failed to setup device\n");
-    return NullControllerDevice;
-  }
-  if (-1 == ioctl(fd, UI_DEV_CREATE)) {
-    fprintf(stderr, "Failed to create device\n");
-    return NullControllerDevice;
-  }
-  trace("Create Device");
-  return (ControllerDevice){
-      .fd = fd,
+struct input_absinfo ControllerAxis_getAbsInfo(size_t axis) {
+  return axis >= CONTROLLER_AXIS_HAT_X ? HAT_ABSINFO : STICK_ABSINFO;
+}
+
+ControllerDevice ControllerDevice_create(ControllerBackend *backend) {
+  ControllerDevice self = {
+      .backend = backend,
       .hat = {0},
+      .state = {0},
+      .sent = {0},
+      .filters = {{0}},
+      .report = {0},
   };
+  for (size_t i = 0; i < CONTROLLER_AXIS_COUNT; i++) {
+    const struct input_absinfo info = ControllerAxis_getAbsInfo(i);
+    self.filters[i] = (ControllerAxisFilter){
+        .min_delta = info.fuzz,
+        .flat = info.flat,
+        .minimum = info.minimum,
+        .maximum = info.maximum,
+    };
+  }
+  return self;
 }
 
-void ControllerDevice_destroy(ControllerDevice *self) {
-  ioctl(self->fd, UI_DEV_DESTROY);
-  close(self->fd);
-  self->fd = -1;
-
-  trace("Destroy Device");
+ControllerDevice ControllerDevice_default(Allocator *allocator) {
+  ControllerBackend *backend = UinputBackend_create(allocator);
+  if (backend == NULL) {
+    SDL_Log("Virtual controller disabled, its reports will be dropped");
+  }
+  return ControllerDevice_create(backend);
 }
 
-void emit(int fd, int type, int code, int val) {
-  struct input_event ie;
-
-  ie.type = type;
-  ie.code = code;
-  ie.value = val;
+void ControllerDevice_destroy(ControllerDevice *self) {
+  ControllerBackend_destroy(self->backend);
+  self->backend = NULL;
+}
 
-  ie.time.tv_sec = 0;
-  ie.time.tv_usec = 0;
+static void ControllerReport_push(ControllerReport *self, int type, int code,
+                                  int val) {
+  debugAssert(self->len < CONTROLLER_REPORT_MAX, "controller report is full");
+  self->events[self->len++] = (struct input_event){
+      .time = self->time,
+      .type = type,
+      .code = code,
+      .value = val,
+  };
+}
 
-  write(fd, &ie, sizeof(ie));
+static int ControllerDevice_findCode(const int *codes, size_t count, int code) {
+  for (size_t i = 0; i < count; i++) {
+    if (codes[i] == code)
+      return (int)i;
+  }
+  return -1;
 }
 
 void ControllerDevice_setButton(ControllerDevice *self, int id, bool value) {
-  emit(self->fd, EV_KEY, id, value);
-  emit(self->fd, EV_SYN, SYN_REPORT, 0);
+  const int button = ControllerDevice_findCode(CONTROLLER_BUTTON_CODES,
+                                               CONTROLLER_BUTTON_COUNT, id);
+  if (button < 0)
+    return;
+
+  if (value) {
+    self->state.buttons |= 1u << button;
+  } else {
+    self->state.buttons &= ~(1u << button);
+  }
 }
 void ControllerDevice_setAxis(ControllerDevice *self, int axis_id, int value) {
-  emit(self->fd, EV_ABS, axis_id, value);
-  emit(self->fd, EV_SYN, SYN_REPORT, 0);
+  const int axis = ControllerDevice_findCode(CONTROLLER_AXIS_CODES,
+                                             CONTROLLER_AXIS_COUNT, axis_id);
+  if (axis < 0)
+    return;
+  self->state.axes[axis] = value;
 }
 void ControllerDevice_setHat(ControllerDevice *self, int hat_id, int value) {
   if (hat_id < 0 || hat_id > 3)
     return;
 
   if (value == 0) {
-    self->hat.bytes ^= 1 << hat_id;
+    self->hat.bytes &= ~(1 << hat_id);
   } else {
     self->hat.bytes |= 1 << hat_id;
   }
 
-  int dx = self->hat.right - self->hat.left;
-  int dy = self->hat.up - self->hat.down;
+  self->state.axes[CONTROLLER_AXIS_HAT_X] = self->hat.right - self->hat.left;
+  self->state.axes[CONTROLLER_AXIS_HAT_Y] = self->hat.up - self->hat.down;
+}
+void ControllerDevice_setState(ControllerDevice *self,
+                               const ControllerState *state) {
+  self->state = *state;
+}
+void ControllerDevice_setAxisDelta(ControllerDevice *self, int min_delta) {
+  for (size_t i = 0; i < CONTROLLER_AXIS_HAT_X; i++) {
+    self->filters[i].min_delta = min_delta;
+  }
+}
+
+// The value an axis should be reported as, or `sent` when the change is too
+// small to be worth a report
+static int ControllerAxisFilter_apply(const ControllerAxisFilter *self,
+                                      int value, int sent) {
+  if (value < self->minimum)
+    value = self->minimum;
+  if (value > self->maximum)
+    value = self->maximum;
+  if (value >= -self->flat && value <= self->flat)
+    value = 0;
+
+  // Resting and fully pushed positions always go out exactly
+  if (value == 0 || value == self->minimum || value == self->maximum)
+    return value;
+  if (abs(value - sent) < self->min_delta)
+    return sent;
+  return value;
+}
+
+int ControllerDevice_flush(ControllerDevice *self) {
+  ControllerReport *report = &self->report;
+  report->len = 0;
+  // Every event in a report happened at the same instant
+  gettimeofday(&report->time, NULL);
+
+  ControllerState next = self->sent;
+
+  unsigned int changed = self->state.buttons ^ self->sent.buttons;
+  while (changed != 0) {
+    const int button = __builtin_ctz(changed);
+    changed &= changed - 1;
+
+    const bool pressed = (self->state.buttons >> button) & 1;
+    ControllerReport_push(report, EV_KEY, CONTROLLER_BUTTON_CODES[button],
+                          pressed);
+  }
+  next.buttons = self->state.buttons;
 
-  emit(self->fd, EV_ABS, ABS_HAT0X, dx);
-  emit(self->fd, EV_ABS, ABS_HAT0Y, dy);
-  emit(self->fd, EV_SYN, SYN_REPORT, 0);
+  for (size_t i = 0; i < CONTROLLER_AXIS_COUNT; i++) {
+    const int value = ControllerAxisFilter_apply(
+        &self->filters[i], self->state.axes[i], self->sent.axes[i]);
+    if (value == self->sent.axes[i])
+      continue;
+
+    ControllerReport_push(report, EV_ABS, CONTROLLER_AXIS_CODES[i], value);
+    next.axes[i] = value;
+  }
+
+  if (report->len == 0)
+    return 0;
+  ControllerReport_push(report, EV_SYN, SYN_REPORT, 0);
+
+  // Without a backend the report is dropped rather than retried forever
+  if (self->backend == NULL) {
+    self->sent = next;
+    return 0;
+  }
+  if (!ControllerBackend_write(self->backend, report->events, report->len))
+    return -1;
+
+  self->sent = next;
+  return (int)report->len;
+}
+
+ControllerBenchmark ControllerDevice_benchmark(ControllerDevice *self,
+                                               size_t reports) {
+  ControllerBenchmark result = {
+      .reports = 0,
+      .unchanged = 0,
+      .events = 0,
+      .failed = 0,
+      .seconds = 0.0,
+  };
+
+  const Uint64 start = SDL_GetTicksNS();
+  for (size_t i = 0; i < reports; i++) {
+    // One button toggles and the left stick sweeps every report, with a
+    // full release every so often
+    self->state.buttons ^= 1u << (i % CONTROLLER_BUTTON_COUNT);
+    self->state.axes[CONTROLLER_AXIS_X] = (int)((i * 977) % 65535) - 32767;
+    self->state.axes[CONTROLLER_AXIS_Y] = (int)((i * 331) % 65535) - 32767;
+    if (i % 64 == 63) {
+      self->state = (ControllerState){0};
+    }
+
+    const int written = ControllerDevice_flush(self);
+    if (written < 0) {
+      result.failed++;
+    } else if (written == 0) {
+      result.unchanged++;
+    } else {
+      result.reports++;
+      result.events += written;
+    }
+  }
+  result.seconds = (SDL_GetTicksNS() - start) / (double)SDL_NS_PER_SECOND;
+  return result;
 }
 
 ControllerComponent ControllerComponent_create(Allocator *allocator,
@@ -0,0 +1,455 @@
+/*
+    Controller Manager
+    Copyright (C) 2025  Ashton Warner
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// Needed for pthread_setaffinity_np
+#define _GNU_SOURCE
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include "debug/debug.h"
+#include "input/manager.h"
+
+// How long the thread sleeps when nothing is submitted, and how soon it
+// retries a write the backend refused
+#define CONTROLLER_OUTPUT_IDLE_MS 100
+#define CONTROLLER_OUTPUT_RETRY_MS 1
+#define CONTROLLER_EPOLL_EVENTS 32
+
+void ControllerQueue_init(ControllerQueue *self) {
+  for (Uint32 i = 0; i < CONTROLLER_QUEUE_SIZE; i++) {
+    SDL_SetAtomicU32(&self->slots[i].sequence, i);
+  }
+  SDL_SetAtomicU32(&self->head, 0);
+  SDL_SetAtomicU32(&self->tail, 0);
+}
+
+bool ControllerQueue_push(ControllerQueue *self,
+                          const ControllerUpdate *update) {
+  Uint32 pos = SDL_GetAtomicU32(&self->head);
+  ControllerQueueSlot *slot;
+
+  while (true) {
+    slot = &self->slots[pos & (CONTROLLER_QUEUE_SIZE - 1)];
+    const Sint32 diff = (Sint32)(SDL_GetAtomicU32(&slot->sequence) - pos);
+
+    if (diff == 0) {
+      // The slot is free. Claim it unless another producer got there first
+      if (SDL_CompareAndSwapAtomicU32(&self->head, pos, pos + 1))
+        break;
+    } else if (diff < 0) {
+      // The consumer hasn't emptied this slot yet. The queue is full
+      return false;
+    }
+    pos = SDL_GetAtomicU32(&self->head);
+  }
+
+  slot->update = *update;
+  SDL_MemoryBarrierRelease();
+  SDL_SetAtomicU32(&slot->sequence, pos + 1);
+  return true;
+}
+
+bool ControllerQueue_pop(ControllerQueue *self, ControllerUpdate *update) {
+  const Uint32 pos = SDL_GetAtomicU32(&self->tail);
+  ControllerQueueSlot *slot = &self->slots[pos & (CONTROLLER_QUEUE_SIZE - 1)];
+
+  // Not published yet
+  if (SDL_GetAtomicU32(&slot->sequence) != pos + 1)
+    return false;
+
+  SDL_MemoryBarrierAcquire();
+  *update = slot->update;
+  SDL_SetAtomicU32(&slot->sequence, pos + CONTROLLER_QUEUE_SIZE);
+  SDL_SetAtomicU32(&self->tail, pos + 1);
+  return true;
+}
+
+static void ControllerManager_configureThread(ControllerManager *self) {
+  if (self->options.realtime &&
+      !SDL_SetCurrentThreadPriority(SDL_THREAD_PRIORITY_TIME_CRITICAL)) {
+    trace("Failed to raise controller output priority: %s", SDL_GetError());
+  }
+
+  if (self->options.cpu >= 0) {
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(self->options.cpu, &cpus);
+    if (pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus) != 0) {
+      trace("Failed to pin controller output to cpu %d", self->options.cpu);
+    }
+  }
+}
+
+// Every update of `pad` folded into the write finished with it
+// Traces of a report that never reached a device are dropped unrecorded
+static void ControllerManager_finishTraces(ControllerManager *self, size_t pad,
+                                           bool written) {
+  const Uint64 now = SDL_GetTicksNS();
+  size_t kept = 0;
+  for (size_t i = 0; i < self->trace_count; i++) {
+    if (self->traces[i].pad != pad) {
+      self->traces[kept++] = self->traces[i];
+      continue;
+    }
+    if (written && self->options.latency != NULL) {
+      self->traces[i].trace.stamps[LATENCY_WRITE] = now;
+      LatencyRecorder_record(self->options.latency, &self->traces[i].trace);
+    }
+  }
+  self->trace_count = kept;
+}
+
+static void ControllerManager_pollFeedback(ControllerManager *self,
+                                           size_t pad) {
+  ControllerBackend *backend = self->pads[pad].device.backend;
+
+  // Decode into a copy so readers never see half an update
+  SDL_LockSpinlock(&self->feedback_lock);
+  ControllerFeedback feedback = self->feedback[pad];
+  SDL_UnlockSpinlock(&self->feedback_lock);
+
+  if (!ControllerBackend_poll(backend, &feedback))
+    return;
+
+  SDL_LockSpinlock(&self->feedback_lock);
+  self->feedback[pad] = feedback;
+  SDL_UnlockSpinlock(&self->feedback_lock);
+  SDL_AddAtomicInt(&self->stats.feedback, 1);
+}
+
+static void ControllerManager_watchPad(ControllerManager *self, size_t pad) {
+  ControllerBackend *backend = self->pads[pad].device.backend;
+  // Only feedback is waited on. A pipe's write end is nearly always
+  // writable, so full backends are retried on a timer instead
+  if (backend == NULL || backend->fd < 0 || backend->poll == NULL)
+    return;
+
+  struct epoll_event event = {
+      .events = EPOLLIN,
+      .data.u64 = pad,
+  };
+  epoll_ctl(self->epoll_fd, EPOLL_CTL_ADD, backend->fd, &event);
+}
+
+// Devices created in the background start out empty, so the newest state is
+// sent in full once they arrive
+static void ControllerManager_adoptBackends(ControllerManager *self) {
+  for (size_t pad = 0; pad < self->pad_count; pad++) {
+    ManagedPad *managed = &self->pads[pad];
+    if (SDL_GetAtomicPointer(&managed->incoming) == NULL)
+      continue;
+
+    ControllerBackend *backend =
+        SDL_SetAtomicPointer(&managed->incoming, NULL);
+    ControllerBackend_destroy(managed->device.backend);
+    managed->device.backend = backend;
+    managed->device.sent = (ControllerState){0};
+    managed->pending = true;
+    ControllerManager_watchPad(self, pad);
+  }
+}
+
+// Only the newest state of each pad matters. Older ones would be overwritten
+// within the same report anyway
+static void ControllerManager_drainQueue(ControllerManager *self) {
+  ControllerUpdate update;
+  int popped = 0;
+  int reports = 0;
+  while (ControllerQueue_pop(&self->queue, &update)) {
+    popped++;
+    ManagedPad *managed = &self->pads[update.pad];
+    ControllerDevice_setState(&managed->device, &update.state);
+    if (!managed->pending) {
+      managed->pending = true;
+      reports++;
+    }
+
+    if (LatencyTrace_active(&update.trace) &&
+        self->trace_count < CONTROLLER_QUEUE_SIZE) {
+      self->traces[self->trace_count].pad = update.pad;
+      self->traces[self->trace_count].trace = update.trace;
+      self->trace_count++;
+    }
+  }
+  SDL_AddAtomicInt(&self->stats.updates, popped);
+  SDL_AddAtomicInt(&self->stats.coalesced, popped - reports);
+}
+
+// Flushes every pad with changes. Returns whether one needs a timed retry
+static bool ControllerManager_flushPads(ControllerManager *self) {
+  bool retry = false;
+  int reports = 0;
+  for (size_t pad = 0; pad < self->pad_count; pad++) {
+    ManagedPad *managed = &self->pads[pad];
+    if (!managed->pending)
+      continue;
+
+    const int written = ControllerDevice_flush(&managed->device);
+    if (written >= 0) {
+      managed->pending = false;
+      // Filtering can leave nothing to write, and pads still being set up
+      // have nowhere to write it
+      reports += written > 0;
+      ControllerManager_finishTraces(self, pad, written > 0);
+    } else {
+      SDL_AddAtomicInt(&self->stats.failed_writes, 1);
+      retry = true;
+    }
+  }
+  SDL_AddAtomicInt(&self->stats.reports, reports);
+  return retry;
+}
+
+static int ControllerManager_threadMain(ControllerManager *self) {
+  ControllerManager_configureThread(self);
+
+  struct epoll_event events[CONTROLLER_EPOLL_EVENTS];
+  bool retry = false;
+  while (SDL_GetAtomicInt(&self->running)) {
+    const int count =
+        epoll_wait(self->epoll_fd, events, CONTROLLER_EPOLL_EVENTS,
+                   retry ? CONTROLLER_OUTPUT_RETRY_MS
+                         : CONTROLLER_OUTPUT_IDLE_MS);
+
+    for (int i = 0; i < count; i++) {
+      const Uint64 pad = events[i].data.u64;
+      if (pad == self->pad_count) {
+        // Clears the counter so the next submit wakes us again
+        Uint64 wakes;
+        if (read(self->wake_fd, &wakes, sizeof(wakes)) < 0 && errno != EAGAIN) {
+          trace("Failed to clear controller wakeups: %s", strerror(errno));
+        }
+        continue;
+      }
+      if (events[i].events & EPOLLIN) {
+        ControllerManager_pollFeedback(self, pad);
+      }
+    }
+
+    ControllerManager_adoptBackends(self);
+    ControllerManager_drainQueue(self);
+    retry = ControllerManager_flushPads(self);
+  }
+  return 0;
+}
+
+ControllerManager *ControllerManager_create(Allocator *allocator,
+                                            size_t pad_count,
+                                            ControllerOutputOptions options) {
+  debugAssert(pad_count > 0 && pad_count <= CONTROLLER_MAX_PADS,
+              "pad_count %zu out of range", pad_count);
+
+  ControllerManager *self = allocPtr(allocator, sizeof(ControllerManager), 1);
+  self->allocator = allocator;
+  self->options = options;
+  self->pad_count = pad_count;
+  self->pads = allocPtr(allocator, sizeof(ManagedPad), pad_count);
+  self->feedback = allocPtr(allocator, sizeof(ControllerFeedback), pad_count);
+  for (size_t i = 0; i < pad_count; i++) {
+    self->pads[i] = (ManagedPad){
+        .device = ControllerDevice_create(NULL),
+        .pending = false,
+        .incoming = NULL,
+    };
+    self->feedback[i] = (ControllerFeedback){0};
+  }
+  self->feedback_lock = 0;
+  self->trace_count = 0;
+  self->stats = (ControllerOutputStats){{0}, {0}, {0}, {0}, {0}, {0}};
+  ControllerQueue_init(&self->queue);
+
+  self->epoll_fd = -1;
+  self->wake_fd = -1;
+  self->thread = NULL;
+  SDL_SetAtomicInt(&self->running, 0);
+
+  for (size_t i = 0; i < CONTROLLER_SETUP_THREADS; i++) {
+    self->setup_threads[i] = NULL;
+  }
+  SDL_SetAtomicInt(&self->next_setup, 0);
+  SDL_SetAtomicInt(&self->setup_done, 0);
+  self->setup_finished = 0;
+  SDL_SetAtomicInt(&self->setup_complete, 0);
+  return self;
+}
+
+void ControllerManager_attach(ControllerManager *self, size_t pad,
+                              ControllerBackend *backend) {
+  debugAssert(pad < self->pad_count, "pad %zu out of range", pad);
+  debugAssert(self->thread == NULL, "manager already started");
+
+  ControllerDevice *device = &self->pads[pad].device;
+  ControllerBackend_destroy(device->backend);
+  device->backend = backend;
+}
+
+static void ControllerManager_wake(ControllerManager *self) {
+  const Uint64 one = 1;
+  if (write(self->wake_fd, &one, sizeof(one)) < 0) {
+    trace("Failed to wake controller output: %s", strerror(errno));
+  }
+}
+
+static int ControllerManager_setupMain(ControllerManager *self) {
+  int pad;
+  while (SDL_GetAtomicInt(&self->running) &&
+         (pad = SDL_AddAtomicInt(&self->next_setup, 1)) <
+             (int)self->pad_count) {
+    // UI_DEV_CREATE waits for the kernel and udev to enumerate the device
+    ControllerBackend *backend = UinputBackend_create(&std_allocator);
+    if (backend != NULL) {
+      SDL_SetAtomicPointer(&self->pads[pad].incoming, backend);
+      ControllerManager_wake(self);
+    }
+
+    if (SDL_AddAtomicInt(&self->setup_done, 1) + 1 == (int)self->pad_count) {
+      self->setup_finished = SDL_GetTicksNS();
+      SDL_SetAtomicInt(&self->setup_complete, 1);
+    }
+  }
+  return 0;
+}
+
+void ControllerManager_openUinputAsync(ControllerManager *self) {
+  debugAssert(self->thread != NULL, "manager not started");
+
+  for (size_t i = 0; i < CONTROLLER_SETUP_THREADS && i < self->pad_count;
+       i++) {
+    self->setup_threads[i] = SDL_CreateThread(
+        (SDL_ThreadFunction)ControllerManager_setupMain, "Controller Setup",
+        self);
+    if (self->setup_threads[i] == NULL) {
+      SDL_Log("Failed to create Controller Setup Thread: %s", SDL_GetError());
+    }
+  }
+}
+
+bool ControllerManager_isReady(ControllerManager *self, Uint64 *finished) {
+  if (!SDL_GetAtomicInt(&self->setup_complete))
+    return false;
+  if (finished != NULL) {
+    *finished = self->setup_finished;
+  }
+  return true;
+}
+
+bool ControllerManager_start(ControllerManager *self) {
+  debugAssert(self->thread == NULL, "manager already started");
+
+  self->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+  self->wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (self->epoll_fd < 0 || self->wake_fd < 0) {
+    SDL_Log("Failed to set up controller polling: %s", strerror(errno));
+    return false;
+  }
+
+  struct epoll_event wake = {
+      .events = EPOLLIN,
+      .data.u64 = self->pad_count,
+  };
+  epoll_ctl(self->epoll_fd, EPOLL_CTL_ADD, self->wake_fd, &wake);
+
+  for (size_t pad = 0; pad < self->pad_count; pad++) {
+    ControllerManager_watchPad(self, pad);
+  }
+
+  SDL_SetAtomicInt(&self->running, 1);
+  self->thread = SDL_CreateThread(
+      (SDL_ThreadFunction)ControllerManager_threadMain, "Controller Output",
+      self);
+  if (self->thread == NULL) {
+    SDL_Log("Failed to create Controller Output Thread: %s", SDL_GetError());
+    SDL_SetAtomicInt(&self->running, 0);
+    return false;
+  }
+  return true;
+}
+
+bool ControllerManager_submit(ControllerManager *self, size_t pad,
+                              const ControllerState *state,
+                              const LatencyTrace *trace) {
+  debugAssert(pad < self->pad_count, "pad %zu out of range", pad);
+
+  ControllerUpdate update = {
+      .trace = {{0}},
+      .pad = pad,
+      .state = *state,
+  };
+  if (trace != NULL) {
+    update.trace = *trace;
+  }
+  LatencyTrace_mark(&update.trace, LATENCY_REPORT);
+
+  if (!ControllerQueue_push(&self->queue, &update)) {
+    SDL_AddAtomicInt(&self->stats.dropped, 1);
+    return false;
+  }
+  if (self->wake_fd >= 0) {
+    ControllerManager_wake(self);
+  }
+  return true;
+}
+
+ControllerFeedback ControllerManager_getFeedback(ControllerManager *self,
+                                                 size_t pad) {
+  debugAssert(pad < self->pad_count, "pad %zu out of range", pad);
+
+  SDL_LockSpinlock(&self->feedback_lock);
+  const ControllerFeedback feedback = self->feedback[pad];
+  SDL_UnlockSpinlock(&self->feedback_lock);
+  return feedback;
+}
+
+void ControllerManager_destroy(ControllerManager *self) {
+  debugAssert(self != NULL, "self == NULL");
+
+  // Setup threads stop after the device they are creating
+  SDL_SetAtomicInt(&self->running, 0);
+  for (size_t i = 0; i < CONTROLLER_SETUP_THREADS; i++) {
+    if (self->setup_threads[i] != NULL) {
+      SDL_WaitThread(self->setup_threads[i], NULL);
+      self->setup_threads[i] = NULL;
+    }
+  }
+  if (self->thread != NULL) {
+    ControllerManager_wake(self);
+    SDL_WaitThread(self->thread, NULL);
+    self->thread = NULL;
+  }
+  if (self->wake_fd >= 0) {
+    close(self->wake_fd);
+  }
+  if (self->epoll_fd >= 0) {
+    close(self->epoll_fd);
+  }
+
+  // The output thread has to stop before the devices it writes to
+  for (size_t pad = 0; pad < self->pad_count; pad++) {
+    ControllerBackend_destroy(
+        SDL_SetAtomicPointer(&self->pads[pad].incoming, NULL));
+    ControllerDevice_destroy(&self->pads[pad].device);
+  }
+  freePtr(self->allocator, self->feedback);
+  freePtr(self->allocator, self->pads);
+  freePtr(self->allocator, self);
+}
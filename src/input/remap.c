@@ -0,0 +1,246 @@
+/*
+    Controller Remapping
+    Copyright (C) 2025  Ashton Warner
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <stdlib.h>
+
+#include "debug/debug.h"
+#include "input/remap.h"
+
+#define REMAP_AXIS(SOURCE, AXIS, SCALE)                                        \
+  {                                                                            \
+      .source = (SOURCE),                                                      \
+      .target_kind = REMAP_TARGET_AXIS,                                        \
+      .target = (AXIS),                                                        \
+      .scale = (SCALE),                                                        \
+      /* Sticks already passed the radial deadzone of the analog stage */      \
+      .deadzone = 0.0f,                                                        \
+      .curve = REMAP_CURVE_LINEAR,                                             \
+      .threshold = 0.0f,                                                       \
+  }
+#define REMAP_BUTTON(BUTTON, TARGET)                                           \
+  {                                                                            \
+      .source = RemapSource_button(BUTTON),                                    \
+      .target_kind = REMAP_TARGET_BUTTON,                                      \
+      .target = (TARGET),                                                      \
+      .scale = 1.0f,                                                           \
+      .deadzone = 0.0f,                                                        \
+      .curve = REMAP_CURVE_LINEAR,                                             \
+      .threshold = 0.5f,                                                       \
+  }
+
+#define REMAP_DEFAULT_BUTTONS                                                  \
+  REMAP_BUTTON(INPUT_BUTTON_PRIMARY, CONTROLLER_BUTTON_A),                     \
+      REMAP_BUTTON(INPUT_BUTTON_SECONDARY, CONTROLLER_BUTTON_B),               \
+      REMAP_BUTTON(INPUT_BUTTON_TERTIARY, CONTROLLER_BUTTON_X),                \
+      REMAP_BUTTON(INPUT_BUTTON_QUATERNY, CONTROLLER_BUTTON_Y),                \
+      REMAP_BUTTON(INPUT_BUTTON_JUMP, CONTROLLER_BUTTON_A),                    \
+      REMAP_BUTTON(INPUT_BUTTON_ACTION, CONTROLLER_BUTTON_TR),                 \
+      REMAP_BUTTON(INPUT_BUTTON_DISMOUNT, CONTROLLER_BUTTON_SELECT),           \
+      REMAP_BUTTON(INPUT_BUTTON_ATTACK, CONTROLLER_BUTTON_TL)
+
+const RemapBinding REMAP_DEFAULT_BINDINGS[] = {
+    REMAP_AXIS(RemapSource_axis(INPUT_AXIS_X), CONTROLLER_AXIS_X, 1.0f),
+    REMAP_AXIS(RemapSource_axis(INPUT_AXIS_Y), CONTROLLER_AXIS_Y, 1.0f),
+    REMAP_AXIS(RemapSource_axis(INPUT_AXIS_RX), CONTROLLER_AXIS_RX, 1.0f),
+    REMAP_AXIS(RemapSource_axis(INPUT_AXIS_RY), CONTROLLER_AXIS_RY, 1.0f),
+    REMAP_AXIS(REMAP_SOURCE_HAT_X, CONTROLLER_AXIS_HAT_X, 1.0f),
+    REMAP_AXIS(REMAP_SOURCE_HAT_Y, CONTROLLER_AXIS_HAT_Y, 1.0f),
+
+    REMAP_DEFAULT_BUTTONS,
+};
+const size_t REMAP_DEFAULT_BINDING_COUNT =
+    sizeof(REMAP_DEFAULT_BINDINGS) / sizeof(*REMAP_DEFAULT_BINDINGS);
+
+const RemapBinding REMAP_SWAPPED_BINDINGS[] = {
+    REMAP_AXIS(RemapSource_axis(INPUT_AXIS_RX), CONTROLLER_AXIS_X, 1.0f),
+    REMAP_AXIS(RemapSource_axis(INPUT_AXIS_RY), CONTROLLER_AXIS_Y, 1.0f),
+    REMAP_AXIS(RemapSource_axis(INPUT_AXIS_X), CONTROLLER_AXIS_RX, 1.0f),
+    REMAP_AXIS(RemapSource_axis(INPUT_AXIS_Y), CONTROLLER_AXIS_RY, 1.0f),
+    REMAP_AXIS(REMAP_SOURCE_HAT_X, CONTROLLER_AXIS_HAT_X, 1.0f),
+    REMAP_AXIS(REMAP_SOURCE_HAT_Y, CONTROLLER_AXIS_HAT_Y, 1.0f),
+
+    REMAP_DEFAULT_BUTTONS,
+};
+const size_t REMAP_SWAPPED_BINDING_COUNT =
+    sizeof(REMAP_SWAPPED_BINDINGS) / sizeof(*REMAP_SWAPPED_BINDINGS);
+
+static const float REMAP_CURVES[][3] = {
+    [REMAP_CURVE_LINEAR] = {1.0f, 0.0f, 0.0f},
+    [REMAP_CURVE_QUADRATIC] = {0.0f, 1.0f, 0.0f},
+    [REMAP_CURVE_CUBIC] = {0.0f, 0.0f, 1.0f},
+};
+
+static RemapEntry RemapEntry_compile(const RemapBinding *binding) {
+  const float deadzone = SDL_clamp(binding->deadzone, 0.0f, 0.99f);
+  RemapEntry entry = {
+      .source = binding->source,
+      .target = binding->target,
+      .scale = binding->scale,
+      .deadzone = deadzone,
+      .inv_range = 1.0f / (1.0f - deadzone),
+      .curve = {0},
+      .threshold = binding->threshold,
+  };
+  for (size_t i = 0; i < 3; i++) {
+    entry.curve[i] = REMAP_CURVES[binding->curve][i];
+  }
+  return entry;
+}
+
+static inline float RemapEntry_apply(const RemapEntry *self, float value) {
+  const float live =
+      SDL_max(SDL_fabsf(value) - self->deadzone, 0.0f) * self->inv_range;
+  const float shaped =
+      live * (self->curve[0] + live * (self->curve[1] + live * self->curve[2]));
+  return SDL_copysignf(shaped, value) * self->scale;
+}
+
+static int RemapEntry_compare(const void *a, const void *b) {
+  const RemapEntry *left = a;
+  const RemapEntry *right = b;
+  if (left->source != right->source)
+    return left->source - right->source;
+  return left->target - right->target;
+}
+
+RemapTable *RemapTable_compile(Allocator *allocator,
+                               const RemapBinding *bindings, size_t count) {
+  size_t axis_count = 0;
+  size_t button_count = 0;
+  for (size_t i = 0; i < count; i++) {
+    axis_count += bindings[i].target_kind == REMAP_TARGET_AXIS;
+    button_count += bindings[i].target_kind == REMAP_TARGET_BUTTON;
+  }
+
+  RemapTable *self = allocPtr(allocator, sizeof(RemapTable), 1);
+  *self = (RemapTable){
+      .allocator = allocator,
+      .axis_count = 0,
+      // Keeps the allocation valid when there are no bindings of a kind
+      .axis_entries = allocPtr(allocator, sizeof(RemapEntry), axis_count + 1),
+      .button_count = 0,
+      .button_entries =
+          allocPtr(allocator, sizeof(RemapEntry), button_count + 1),
+      .axis_range = {0},
+  };
+  for (size_t i = 0; i < CONTROLLER_AXIS_COUNT; i++) {
+    self->axis_range[i] = ControllerAxis_getAbsInfo(i).maximum;
+  }
+
+  for (size_t i = 0; i < count; i++) {
+    const RemapBinding *binding = &bindings[i];
+    if (binding->source < 0 || binding->source >= REMAP_SOURCE_COUNT) {
+      trace("Skipping binding %zu, bad source %d", i, binding->source);
+      continue;
+    }
+
+    if (binding->target_kind == REMAP_TARGET_AXIS && binding->target >= 0 &&
+        binding->target < CONTROLLER_AXIS_COUNT) {
+      self->axis_entries[self->axis_count++] = RemapEntry_compile(binding);
+    } else if (binding->target_kind == REMAP_TARGET_BUTTON &&
+               binding->target >= 0 &&
+               binding->target < CONTROLLER_BUTTON_COUNT) {
+      self->button_entries[self->button_count++] = RemapEntry_compile(binding);
+    } else {
+      trace("Skipping binding %zu, bad target %d", i, binding->target);
+    }
+  }
+
+  // Entries of the same source end up next to each other
+  qsort(self->axis_entries, self->axis_count, sizeof(RemapEntry),
+        RemapEntry_compare);
+  qsort(self->button_entries, self->button_count, sizeof(RemapEntry),
+        RemapEntry_compare);
+  return self;
+}
+
+void RemapTable_destroy(RemapTable *self) {
+  if (self == NULL)
+    return;
+  freePtr(self->allocator, self->axis_entries);
+  freePtr(self->allocator, self->button_entries);
+  freePtr(self->allocator, self);
+}
+
+void RemapTable_evaluate(const RemapTable *self, const InputState *input,
+                         ControllerState *out) {
+  float sources[REMAP_SOURCE_COUNT];
+  for (size_t i = 0; i < INPUT_BUTTON_COUNT; i++) {
+    sources[RemapSource_button(i)] = (input->buttons >> i) & 1;
+  }
+  for (size_t i = 0; i < INPUT_AXIS_COUNT; i++) {
+    sources[RemapSource_axis(i)] = input->axes[i];
+  }
+  sources[REMAP_SOURCE_HAT_X] = input->hat_x;
+  sources[REMAP_SOURCE_HAT_Y] = input->hat_y;
+
+  // Several bindings on one axis add up
+  float axes[CONTROLLER_AXIS_COUNT] = {0};
+  for (size_t i = 0; i < self->axis_count; i++) {
+    const RemapEntry *entry = &self->axis_entries[i];
+    axes[entry->target] += RemapEntry_apply(entry, sources[entry->source]);
+  }
+
+  unsigned int buttons = 0;
+  for (size_t i = 0; i < self->button_count; i++) {
+    const RemapEntry *entry = &self->button_entries[i];
+    const float value = RemapEntry_apply(entry, sources[entry->source]);
+    const bool pressed =
+        entry->threshold > 0.0f ? value >= entry->threshold : value != 0.0f;
+    buttons |= (unsigned int)pressed << entry->target;
+  }
+
+  out->buttons = buttons;
+  for (size_t i = 0; i < CONTROLLER_AXIS_COUNT; i++) {
+    out->axes[i] =
+        SDL_lroundf(SDL_clamp(axes[i], -1.0f, 1.0f) * self->axis_range[i]);
+  }
+}
+
+RemapEngine RemapEngine_create(RemapTable *table) {
+  return (RemapEngine){
+      .current = table,
+      .pending = NULL,
+  };
+}
+
+void RemapEngine_destroy(RemapEngine *self) {
+  RemapTable_destroy(SDL_SetAtomicPointer(&self->pending, NULL));
+  RemapTable_destroy(self->current);
+  self->current = NULL;
+}
+
+void RemapEngine_rebind(RemapEngine *self, RemapTable *table) {
+  // A table the reader never picked up can go straight away
+  RemapTable_destroy(SDL_SetAtomicPointer(&self->pending, table));
+}
+
+void RemapEngine_update(RemapEngine *self) {
+  if (SDL_GetAtomicPointer(&self->pending) == NULL)
+    return;
+  RemapTable *next = SDL_SetAtomicPointer(&self->pending, NULL);
+  RemapTable_destroy(self->current);
+  self->current = next;
+}
+
+void RemapEngine_evaluate(const RemapEngine *self, const InputState *input,
+                          ControllerState *out) {
+  if (self->current == NULL)
+    return;
+  RemapTable_evaluate(self->current, input, out);
+}
@@ -0,0 +1,334 @@
+/*
+    Input Recording and Replay
+    Copyright (C) 2025  Ashton Warner
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <errno.h>
+#include <string.h>
+
+#include "debug/debug.h"
+#include "input/replay.h"
+
+#define REPLAY_HEADER_SIZE 9
+// Idle count, then every player with every field
+#define REPLAY_RECORD_MAX                                                      \
+  (10 + REPLAY_MAX_PLAYERS * (1 + 5 + 1 + INPUT_AXIS_COUNT * 3))
+
+ReplayFrame ReplayFrame_fromState(const InputState *state) {
+  ReplayFrame frame = {
+      .buttons = state->buttons,
+      .hat_x = state->hat_x,
+      .hat_y = state->hat_y,
+  };
+  for (size_t axis = 0; axis < INPUT_AXIS_COUNT; axis++) {
+    frame.axes[axis] =
+        (Sint16)SDL_lroundf(SDL_clamp(state->axes[axis], -1.0f, 1.0f) * 32767);
+  }
+  return frame;
+}
+
+InputState ReplayFrame_toState(const ReplayFrame *frame) {
+  InputState state = {
+      .timestamp = 0,
+      .buttons = frame->buttons,
+      .hat_x = frame->hat_x,
+      .hat_y = frame->hat_y,
+  };
+  for (size_t axis = 0; axis < INPUT_AXIS_COUNT; axis++) {
+    state.axes[axis] = frame->axes[axis] / 32767.0f;
+  }
+  return state;
+}
+
+static size_t Replay_putVarint(Uint8 *out, Uint64 value) {
+  size_t length = 0;
+  while (value >= 0x80) {
+    out[length++] = (Uint8)(value | 0x80);
+    value >>= 7;
+  }
+  out[length++] = (Uint8)value;
+  return length;
+}
+
+static Uint32 Replay_zigzag(Sint32 value) {
+  return ((Uint32)value << 1) ^ (Uint32)(value >> 31);
+}
+
+static Sint32 Replay_unzigzag(Uint32 value) {
+  return (Sint32)(value >> 1) ^ -(Sint32)(value & 1);
+}
+
+/*
+ * RECORDING
+ */
+
+InputRecorder *InputRecorder_create(Allocator *allocator, const char *path,
+                                    size_t players, Uint16 tick_rate,
+                                    int substeps) {
+  debugAssert(path != NULL, "path == NULL");
+  debugAssert(players > 0 && players <= REPLAY_MAX_PLAYERS,
+              "%zu players out of range", players);
+  debugAssert(substeps > 0 && substeps <= 0xFF, "%d substeps out of range",
+              substeps);
+
+  FILE *file = fopen(path, "wb");
+  if (file == NULL) {
+    SDL_Log("Couldn't open %s for recording: %s", path, strerror(errno));
+    return NULL;
+  }
+
+  const Uint8 header[REPLAY_HEADER_SIZE] = {
+      REPLAY_MAGIC[0],        REPLAY_MAGIC[1],
+      REPLAY_MAGIC[2],        REPLAY_MAGIC[3],
+      REPLAY_VERSION,         (Uint8)players,
+      (Uint8)tick_rate,       (Uint8)(tick_rate >> 8),
+      (Uint8)substeps,
+  };
+  if (fwrite(header, sizeof(header), 1, file) != 1) {
+    SDL_Log("Couldn't write %s: %s", path, strerror(errno));
+    fclose(file);
+    return NULL;
+  }
+
+  InputRecorder *self = allocPtr(allocator, sizeof(InputRecorder), 1);
+  *self = (InputRecorder){
+      .allocator = allocator,
+      .file = file,
+      .players = players,
+      .previous = {{0}},
+      .idle = 0,
+      .ticks = 0,
+      .bytes = sizeof(header),
+      .failed = false,
+  };
+  return self;
+}
+
+void InputRecorder_destroy(InputRecorder *self) {
+  if (self == NULL)
+    return;
+
+  Uint8 end[11];
+  size_t length = Replay_putVarint(end, self->idle);
+  end[length++] = REPLAY_END;
+  self->bytes += length;
+  if (fwrite(end, length, 1, self->file) != 1 || fclose(self->file) != 0) {
+    SDL_Log("Recording was cut short: %s", strerror(errno));
+  } else {
+    SDL_Log("Recorded %lu ticks in %lu bytes",
+            (unsigned long)self->ticks, (unsigned long)self->bytes);
+  }
+  freePtr(self->allocator, self);
+}
+
+bool InputRecorder_write(InputRecorder *self, const InputState *states,
+                         size_t count) {
+  debugAssert(self != NULL, "self == NULL");
+  if (self->failed)
+    return false;
+  self->ticks++;
+
+  // The idle count goes in front once we know something changed
+  Uint8 body[REPLAY_RECORD_MAX];
+  size_t length = 0;
+  bool changed = false;
+
+  for (size_t player = 0; player < self->players; player++) {
+    const ReplayFrame frame = player < count
+                                  ? ReplayFrame_fromState(&states[player])
+                                  : (ReplayFrame){0};
+    ReplayFrame *previous = &self->previous[player];
+
+    const size_t mask_at = length++;
+    Uint8 mask = 0;
+    if (frame.buttons != previous->buttons) {
+      mask |= REPLAY_FIELD_BUTTONS;
+      length +=
+          Replay_putVarint(&body[length], frame.buttons ^ previous->buttons);
+    }
+    if (frame.hat_x != previous->hat_x || frame.hat_y != previous->hat_y) {
+      mask |= REPLAY_FIELD_HAT;
+      body[length++] = (Uint8)((frame.hat_x + 1) | ((frame.hat_y + 1) << 2));
+    }
+    for (size_t axis = 0; axis < INPUT_AXIS_COUNT; axis++) {
+      if (frame.axes[axis] != previous->axes[axis]) {
+        mask |= REPLAY_FIELD_AXIS(axis);
+        length += Replay_putVarint(
+            &body[length],
+            Replay_zigzag((Sint32)frame.axes[axis] - previous->axes[axis]));
+      }
+    }
+    body[mask_at] = mask;
+    changed |= mask != 0;
+    *previous = frame;
+  }
+
+  if (!changed) {
+    self->idle++;
+    return true;
+  }
+
+  Uint8 record[REPLAY_RECORD_MAX];
+  const size_t prefix = Replay_putVarint(record, self->idle);
+  SDL_memcpy(&record[prefix], body, length);
+  self->idle = 0;
+
+  // stdio buffers this, so most ticks never reach the kernel
+  if (fwrite(record, prefix + length, 1, self->file) != 1) {
+    SDL_Log("Failed to write recording: %s", strerror(errno));
+    self->failed = true;
+    return false;
+  }
+  self->bytes += prefix + length;
+  return true;
+}
+
+/*
+ * REPLAY
+ */
+
+static bool InputReplay_getByte(InputReplay *self, Uint8 *out) {
+  if (self->offset >= self->size)
+    return false;
+  *out = self->data[self->offset++];
+  return true;
+}
+
+static bool InputReplay_getVarint(InputReplay *self, Uint64 *out) {
+  Uint64 value = 0;
+  for (int shift = 0; shift < 64; shift += 7) {
+    Uint8 byte;
+    if (!InputReplay_getByte(self, &byte))
+      return false;
+    value |= (Uint64)(byte & 0x7F) << shift;
+    if ((byte & 0x80) == 0) {
+      *out = value;
+      return true;
+    }
+  }
+  return false;
+}
+
+// Applies one tick of changes. False on a malformed or ended stream
+static bool InputReplay_applyRecord(InputReplay *self) {
+  for (size_t player = 0; player < self->players; player++) {
+    ReplayFrame *frame = &self->current[player];
+    Uint8 mask;
+    if (!InputReplay_getByte(self, &mask) ||
+        (player == 0 && mask == REPLAY_END)) {
+      return false;
+    }
+
+    Uint64 value;
+    if (mask & REPLAY_FIELD_BUTTONS) {
+      if (!InputReplay_getVarint(self, &value))
+        return false;
+      frame->buttons ^= (Uint32)value;
+    }
+    if (mask & REPLAY_FIELD_HAT) {
+      Uint8 hat;
+      if (!InputReplay_getByte(self, &hat))
+        return false;
+      frame->hat_x = (Sint8)((hat & 0x3) - 1);
+      frame->hat_y = (Sint8)(((hat >> 2) & 0x3) - 1);
+    }
+    for (size_t axis = 0; axis < INPUT_AXIS_COUNT; axis++) {
+      if ((mask & REPLAY_FIELD_AXIS(axis)) == 0)
+        continue;
+      if (!InputReplay_getVarint(self, &value))
+        return false;
+      frame->axes[axis] =
+          (Sint16)(frame->axes[axis] + Replay_unzigzag((Uint32)value));
+    }
+  }
+  return InputReplay_getVarint(self, &self->idle);
+}
+
+InputReplay *InputReplay_open(Allocator *allocator, const char *path) {
+  debugAssert(path != NULL, "path == NULL");
+
+  FILE *file = fopen(path, "rb");
+  if (file == NULL) {
+    SDL_Log("Couldn't open replay %s: %s", path, strerror(errno));
+    return NULL;
+  }
+  fseek(file, 0, SEEK_END);
+  const long size = ftell(file);
+  fseek(file, 0, SEEK_SET);
+
+  Uint8 *data = size > 0 ? allocPtr(allocator, 1, (size_t)size) : NULL;
+  if (size < REPLAY_HEADER_SIZE || fread(data, (size_t)size, 1, file) != 1 ||
+      SDL_memcmp(data, REPLAY_MAGIC, 4) != 0 || data[4] != REPLAY_VERSION ||
+      data[5] == 0 || data[5] > REPLAY_MAX_PLAYERS || data[8] == 0) {
+    SDL_Log("%s isn't a version %d replay", path, REPLAY_VERSION);
+    if (data != NULL) {
+      freePtr(allocator, data);
+    }
+    fclose(file);
+    return NULL;
+  }
+  fclose(file);
+
+  InputReplay *self = allocPtr(allocator, sizeof(InputReplay), 1);
+  *self = (InputReplay){
+      .allocator = allocator,
+      .data = data,
+      .size = (size_t)size,
+      .offset = REPLAY_HEADER_SIZE,
+      .players = data[5],
+      .tick_rate = (Uint16)(data[6] | (data[7] << 8)),
+      .substeps = data[8],
+      .current = {{0}},
+      .idle = 0,
+      .finished = false,
+      .ticks = 0,
+  };
+  if (!InputReplay_getVarint(self, &self->idle)) {
+    self->finished = true;
+  }
+  return self;
+}
+
+void InputReplay_destroy(InputReplay *self) {
+  if (self == NULL)
+    return;
+  freePtr(self->allocator, self->data);
+  freePtr(self->allocator, self);
+}
+
+bool InputReplay_next(InputReplay *self, InputState *states, size_t count) {
+  debugAssert(self != NULL, "self == NULL");
+  if (self->finished)
+    return false;
+
+  if (self->idle > 0) {
+    self->idle--;
+  } else if (!InputReplay_applyRecord(self)) {
+    if (self->offset < self->size) {
+      SDL_Log("Replay is corrupt at byte %zu", self->offset);
+    }
+    self->finished = true;
+    return false;
+  }
+
+  for (size_t player = 0; player < count; player++) {
+    states[player] = player < self->players
+                         ? ReplayFrame_toState(&self->current[player])
+                         : (InputState){0};
+  }
+  self->ticks++;
+  return true;
+}
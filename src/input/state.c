@@ -0,0 +1,50 @@
+/*
+    Input Snapshot
+    Copyright (C) 2025  Ashton Warner
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "input/state.h"
+
+InputChannel InputChannel_create() {
+  InputChannel self = {
+      .buffers = {{0}},
+      .back = 0,
+      .front = 1,
+      .middle = {0},
+  };
+  SDL_SetAtomicInt(&self.middle, 2);
+  return self;
+}
+
+InputState *InputChannel_getBack(InputChannel *self) {
+  return &self->buffers[self->back];
+}
+
+void InputChannel_publish(InputChannel *self) {
+  // SDL atomics are full barriers, so the snapshot is written before the
+  // reader can pick it up
+  const int previous =
+      SDL_SetAtomicInt(&self->middle, self->back | INPUT_CHANNEL_FRESH);
+  self->back = previous & ~INPUT_CHANNEL_FRESH;
+}
+
+const InputState *InputChannel_read(InputChannel *self) {
+  if (SDL_GetAtomicInt(&self->middle) & INPUT_CHANNEL_FRESH) {
+    self->front = SDL_SetAtomicInt(&self->middle, self->front) &
+                  ~INPUT_CHANNEL_FRESH;
+  }
+  return &self->buffers[self->front];
+}
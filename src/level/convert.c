@@ -0,0 +1,462 @@
+/*
+    Text to Binary Level Converter
+    Copyright (C) 2025  Ashton Warner
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "debug/debug.h"
+#include "level/level.h"
+#include "level/merge.h"
+
+#define LEVEL_MAX_TOKENS 4096
+
+static const char *LEVEL_SPAWN_KIND_NAME_TABLE[LEVEL_SPAWN_KIND_COUNT] =
+    LEVEL_SPAWN_KIND_NAMES;
+
+// One growing section of the output
+typedef struct LevelBuffer {
+  Uint8 *data;
+  size_t count;
+  size_t capacity;
+  size_t stride;
+} LevelBuffer;
+
+static LevelBuffer LevelBuffer_create(size_t stride) {
+  const size_t capacity = 64;
+  return (LevelBuffer){
+      .data = allocPtr(&std_allocator, stride, capacity),
+      .count = 0,
+      .capacity = capacity,
+      .stride = stride,
+  };
+}
+
+static void LevelBuffer_destroy(LevelBuffer *self) {
+  freePtr(&std_allocator, self->data);
+  self->data = NULL;
+}
+
+// Zeroed, so reserved fields are always written as 0
+static void *LevelBuffer_push(LevelBuffer *self) {
+  if (self->count == self->capacity) {
+    self->data = remapBlock(&std_allocator, self->capacity * self->stride,
+                            (char *)self->data, self->stride,
+                            self->capacity * 2);
+    self->capacity *= 2;
+  }
+  void *record = &self->data[self->count++ * self->stride];
+  SDL_memset(record, 0, self->stride);
+  return record;
+}
+
+static void *LevelBuffer_last(LevelBuffer *self) {
+  return self->count > 0 ? &self->data[(self->count - 1) * self->stride]
+                         : NULL;
+}
+
+typedef struct LevelBuilder {
+  LevelBuffer sections[LEVEL_SECTION_COUNT];
+  const char *path;
+  size_t line;
+} LevelBuilder;
+
+static bool LevelBuilder_parseFloats(LevelBuilder *self, char **tokens,
+                                     size_t count, float *out) {
+  for (size_t i = 0; i < count; i++) {
+    char *end;
+    out[i] = strtof(tokens[i], &end);
+    if (end == tokens[i] || *end != '\0' || SDL_isinf(out[i]) ||
+        SDL_isnan(out[i])) {
+      SDL_Log("%s:%zu: '%s' isn't a number", self->path, self->line,
+              tokens[i]);
+      return false;
+    }
+  }
+  return true;
+}
+
+// Parses `count` numbers into `out`, allowing `optional` of them to be left
+// out
+static bool LevelBuilder_expect(LevelBuilder *self, char **args,
+                                size_t arg_count, size_t count,
+                                size_t optional, float *out) {
+  if (arg_count > count || arg_count + optional < count) {
+    SDL_Log("%s:%zu: %s takes %zu numbers", self->path, self->line, args[-1],
+            count);
+    return false;
+  }
+  return LevelBuilder_parseFloats(self, args, arg_count, out);
+}
+
+static LevelBody *LevelBuilder_body(LevelBuilder *self, const char *what) {
+  LevelBody *body = LevelBuffer_last(&self->sections[LEVEL_SECTION_BODIES]);
+  if (body == NULL) {
+    SDL_Log("%s:%zu: %s comes before any body", self->path, self->line, what);
+  }
+  return body;
+}
+
+static bool LevelBuilder_parseLine(LevelBuilder *self, char **tokens,
+                                   size_t count) {
+  const char *kind = tokens[0];
+  char **args = &tokens[1];
+  const size_t arg_count = count - 1;
+  LevelBuffer *sections = self->sections;
+  float v[6] = {0};
+
+  if (SDL_strcmp(kind, "body") == 0) {
+    if (!LevelBuilder_expect(self, args, arg_count, 2, 0, v))
+      return false;
+    LevelBody *body = LevelBuffer_push(&sections[LEVEL_SECTION_BODIES]);
+    body->position = (LevelPoint){v[0], v[1]};
+    body->segments.first = sections[LEVEL_SECTION_SEGMENTS].count;
+    body->boxes.first = sections[LEVEL_SECTION_BOXES].count;
+    body->chains.first = sections[LEVEL_SECTION_CHAINS].count;
+    return true;
+  }
+
+  if (SDL_strcmp(kind, "segment") == 0) {
+    LevelBody *body = LevelBuilder_body(self, kind);
+    if (body == NULL || !LevelBuilder_expect(self, args, arg_count, 4, 0, v))
+      return false;
+    LevelSegment *segment = LevelBuffer_push(&sections[LEVEL_SECTION_SEGMENTS]);
+    *segment = (LevelSegment){{v[0], v[1]}, {v[2], v[3]}};
+    body->segments.count++;
+    return true;
+  }
+
+  if (SDL_strcmp(kind, "box") == 0) {
+    LevelBody *body = LevelBuilder_body(self, kind);
+    if (body == NULL || !LevelBuilder_expect(self, args, arg_count, 5, 1, v))
+      return false;
+    if (v[2] <= 0.0f || v[3] <= 0.0f) {
+      SDL_Log("%s:%zu: box has no size", self->path, self->line);
+      return false;
+    }
+    LevelBox *box = LevelBuffer_push(&sections[LEVEL_SECTION_BOXES]);
+    box->center = (LevelPoint){v[0], v[1]};
+    box->half_extents = (LevelPoint){v[2], v[3]};
+    box->angle = v[4];
+    body->boxes.count++;
+    return true;
+  }
+
+  if (SDL_strcmp(kind, "chain") == 0) {
+    LevelBody *body = LevelBuilder_body(self, kind);
+    if (body == NULL)
+      return false;
+    const bool loop = arg_count > 0 && SDL_strcmp(args[0], "loop") == 0;
+    if (arg_count == 0 || (!loop && SDL_strcmp(args[0], "open") != 0)) {
+      SDL_Log("%s:%zu: chain has to be loop or open", self->path, self->line);
+      return false;
+    }
+    const size_t numbers = arg_count - 1;
+    if (numbers % 2 != 0 || numbers < 8) {
+      SDL_Log("%s:%zu: chain needs at least four X Y pairs", self->path,
+              self->line);
+      return false;
+    }
+
+    LevelChain *chain = LevelBuffer_push(&sections[LEVEL_SECTION_CHAINS]);
+    chain->points.first = sections[LEVEL_SECTION_POINTS].count;
+    chain->points.count = numbers / 2;
+    chain->flags = loop ? LEVEL_CHAIN_LOOP : 0;
+    body->chains.count++;
+    for (size_t i = 0; i < numbers; i += 2) {
+      if (!LevelBuilder_parseFloats(self, &args[1 + i], 2, v))
+        return false;
+      LevelPoint *point = LevelBuffer_push(&sections[LEVEL_SECTION_POINTS]);
+      *point = (LevelPoint){v[0], v[1]};
+    }
+    return true;
+  }
+
+  if (SDL_strcmp(kind, "spawn") == 0) {
+    if (arg_count != 3) {
+      SDL_Log("%s:%zu: spawn takes a kind and 2 numbers", self->path,
+              self->line);
+      return false;
+    }
+    size_t spawn_kind = 0;
+    while (spawn_kind < LEVEL_SPAWN_KIND_COUNT &&
+           SDL_strcmp(args[0], LEVEL_SPAWN_KIND_NAME_TABLE[spawn_kind]) != 0)
+      spawn_kind++;
+    if (spawn_kind == LEVEL_SPAWN_KIND_COUNT) {
+      SDL_Log("%s:%zu: unknown spawn kind '%s'", self->path, self->line,
+              args[0]);
+      return false;
+    }
+    if (!LevelBuilder_parseFloats(self, &args[1], 2, v))
+      return false;
+    LevelSpawn *spawn = LevelBuffer_push(&sections[LEVEL_SECTION_SPAWNS]);
+    spawn->position = (LevelPoint){v[0], v[1]};
+    spawn->kind = (Uint32)spawn_kind;
+    return true;
+  }
+
+  if (SDL_strcmp(kind, "ship") == 0) {
+    if (!LevelBuilder_expect(self, args, arg_count, 2, 0, v))
+      return false;
+    LevelShip *ship = LevelBuffer_push(&sections[LEVEL_SECTION_SHIPS]);
+    ship->position = (LevelPoint){v[0], v[1]};
+    ship->parts.first = sections[LEVEL_SECTION_SHIP_PARTS].count;
+    return true;
+  }
+
+  if (SDL_strcmp(kind, "part") == 0) {
+    LevelShip *ship = LevelBuffer_last(&sections[LEVEL_SECTION_SHIPS]);
+    if (ship == NULL) {
+      SDL_Log("%s:%zu: part comes before any ship", self->path, self->line);
+      return false;
+    }
+    if (!LevelBuilder_expect(self, args, arg_count, 5, 0, v))
+      return false;
+    if (v[2] <= 0.0f || v[3] <= 0.0f || v[4] < 0.0f) {
+      SDL_Log("%s:%zu: part has no size or a negative density", self->path,
+              self->line);
+      return false;
+    }
+    LevelShipPart *part = LevelBuffer_push(&sections[LEVEL_SECTION_SHIP_PARTS]);
+    part->offset = (LevelPoint){v[0], v[1]};
+    part->half_extents = (LevelPoint){v[2], v[3]};
+    part->density = v[4];
+    ship->parts.count++;
+    return true;
+  }
+
+  SDL_Log("%s:%zu: unknown record '%s'", self->path, self->line, kind);
+  return false;
+}
+
+static bool LevelBuilder_parse(LevelBuilder *self, FILE *file) {
+  char *line = NULL;
+  size_t line_capacity = 0;
+  bool ok = true;
+
+  while (ok && getline(&line, &line_capacity, file) >= 0) {
+    self->line++;
+    char *comment = SDL_strchr(line, '#');
+    if (comment != NULL)
+      *comment = '\0';
+
+    char *tokens[LEVEL_MAX_TOKENS];
+    size_t count = 0;
+    char *save;
+    for (char *token = strtok_r(line, " \t\r\n", &save); token != NULL;
+         token = strtok_r(NULL, " \t\r\n", &save)) {
+      if (count == LEVEL_MAX_TOKENS) {
+        SDL_Log("%s:%zu: line is too long", self->path, self->line);
+        ok = false;
+        break;
+      }
+      tokens[count++] = token;
+    }
+    if (ok && count > 0)
+      ok = LevelBuilder_parseLine(self, tokens, count);
+  }
+  free(line);
+  if (ok && ferror(file)) {
+    SDL_Log("Couldn't read %s: %s", self->path, strerror(errno));
+    ok = false;
+  }
+  return ok;
+}
+
+static void LevelBuffer_append(LevelBuffer *self, const void *records,
+                               size_t count) {
+  for (size_t i = 0; i < count; i++) {
+    SDL_memcpy(LevelBuffer_push(self),
+               (const Uint8 *)records + i * self->stride, self->stride);
+  }
+}
+
+// Rebuilds every static body out of its merged shapes. Authored chains are
+// kept and come before the ones the boxes turned into
+static void LevelBuilder_merge(LevelBuilder *self) {
+  LevelBuffer *sections = self->sections;
+  const LevelSegment *old_segments =
+      (const LevelSegment *)sections[LEVEL_SECTION_SEGMENTS].data;
+  const LevelBox *old_boxes =
+      (const LevelBox *)sections[LEVEL_SECTION_BOXES].data;
+  const LevelChain *old_chains =
+      (const LevelChain *)sections[LEVEL_SECTION_CHAINS].data;
+  const LevelPoint *old_points =
+      (const LevelPoint *)sections[LEVEL_SECTION_POINTS].data;
+
+  LevelBuffer segments = LevelBuffer_create(sizeof(LevelSegment));
+  LevelBuffer boxes = LevelBuffer_create(sizeof(LevelBox));
+  LevelBuffer chains = LevelBuffer_create(sizeof(LevelChain));
+  LevelBuffer points = LevelBuffer_create(sizeof(LevelPoint));
+  LevelMerger merger = LevelMerger_create(&std_allocator);
+
+  LevelBody *bodies = (LevelBody *)sections[LEVEL_SECTION_BODIES].data;
+  for (size_t i = 0; i < sections[LEVEL_SECTION_BODIES].count; i++) {
+    LevelBody *body = &bodies[i];
+    LevelMerger_mergeBody(&merger, &old_segments[body->segments.first],
+                          body->segments.count, &old_boxes[body->boxes.first],
+                          body->boxes.count);
+
+    body->segments = (LevelRange){segments.count, merger.segments.len};
+    LevelBuffer_append(&segments, merger.segments.data.ptr,
+                       merger.segments.len);
+    body->boxes = (LevelRange){boxes.count, merger.boxes.len};
+    LevelBuffer_append(&boxes, merger.boxes.data.ptr, merger.boxes.len);
+
+    const LevelRange authored = body->chains;
+    body->chains = (LevelRange){chains.count, 0};
+    for (Uint32 c = 0; c < authored.count; c++) {
+      LevelChain *chain = LevelBuffer_push(&chains);
+      *chain = old_chains[authored.first + c];
+      LevelBuffer_append(&points, &old_points[chain->points.first],
+                         chain->points.count);
+      chain->points.first = points.count - chain->points.count;
+    }
+    for (size_t loop = 0; loop < merger.loops.len; loop++) {
+      const LevelRange range = merger.loops.data.ptr[loop];
+      LevelChain *chain = LevelBuffer_push(&chains);
+      chain->points = (LevelRange){points.count, range.count};
+      chain->flags = LEVEL_CHAIN_LOOP;
+      LevelBuffer_append(&points, &merger.points.data.ptr[range.first],
+                         range.count);
+    }
+    body->chains.count = chains.count - body->chains.first;
+  }
+
+  const LevelMergeStats stats = merger.stats;
+  if (stats.boxes + stats.segments > 0) {
+    SDL_Log("Merged %zu of %zu boxes into %zu boxes and %zu loops with %zu "
+            "edges, %zu segments into %zu",
+            stats.boxes_merged, stats.boxes, stats.boxes_out, stats.loops,
+            stats.loop_edges, stats.segments, stats.segments_out);
+  }
+  LevelMerger_destroy(&merger);
+
+  const enum LevelSectionId ids[] = {
+      LEVEL_SECTION_SEGMENTS,
+      LEVEL_SECTION_BOXES,
+      LEVEL_SECTION_CHAINS,
+      LEVEL_SECTION_POINTS,
+  };
+  const LevelBuffer merged[] = {segments, boxes, chains, points};
+  for (size_t i = 0; i < sizeof(ids) / sizeof(*ids); i++) {
+    LevelBuffer_destroy(&sections[ids[i]]);
+    sections[ids[i]] = merged[i];
+  }
+}
+
+static size_t Level_align(size_t offset) {
+  return (offset + LEVEL_ALIGNMENT - 1) & ~(size_t)(LEVEL_ALIGNMENT - 1);
+}
+
+static bool LevelBuilder_write(LevelBuilder *self, const char *path) {
+  LevelHeader header = {
+      .magic = LEVEL_MAGIC,
+      .version = LEVEL_VERSION,
+      .section_count = LEVEL_SECTION_COUNT,
+  };
+  size_t offset = Level_align(sizeof(header));
+  for (size_t id = 0; id < LEVEL_SECTION_COUNT; id++) {
+    const LevelBuffer *buffer = &self->sections[id];
+    header.sections[id] = (LevelSection){
+        .offset = (Uint32)offset,
+        .count = (Uint32)buffer->count,
+        .stride = (Uint32)buffer->stride,
+    };
+    offset = Level_align(offset + buffer->count * buffer->stride);
+  }
+  if (offset > SDL_MAX_UINT32) {
+    SDL_Log("%s would be too big", path);
+    return false;
+  }
+  header.file_size = (Uint32)offset;
+
+  FILE *file = fopen(path, "wb");
+  if (file == NULL) {
+    SDL_Log("Couldn't open %s for writing: %s", path, strerror(errno));
+    return false;
+  }
+
+  static const Uint8 padding[LEVEL_ALIGNMENT] = {0};
+  bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+  size_t written = sizeof(header);
+  for (size_t id = 0; ok && id < LEVEL_SECTION_COUNT; id++) {
+    const LevelBuffer *buffer = &self->sections[id];
+    const size_t gap = header.sections[id].offset - written;
+    const size_t size = buffer->count * buffer->stride;
+    ok = (gap == 0 || fwrite(padding, gap, 1, file) == 1) &&
+         (size == 0 || fwrite(buffer->data, size, 1, file) == 1);
+    written += gap + size;
+  }
+  if (ok && written < offset)
+    ok = fwrite(padding, offset - written, 1, file) == 1;
+  if (fclose(file) != 0)
+    ok = false;
+
+  if (!ok) {
+    SDL_Log("Couldn't write %s: %s", path, strerror(errno));
+    return false;
+  }
+  SDL_Log("Wrote %s: %zu bodies, %zu ships, %zu spawns in %zu bytes", path,
+          self->sections[LEVEL_SECTION_BODIES].count,
+          self->sections[LEVEL_SECTION_SHIPS].count,
+          self->sections[LEVEL_SECTION_SPAWNS].count, offset);
+  return true;
+}
+
+bool Level_convert(const char *source_path, const char *output_path) {
+  debugAssert(source_path != NULL, "source_path == NULL");
+  debugAssert(output_path != NULL, "output_path == NULL");
+
+  FILE *source = fopen(source_path, "r");
+  if (source == NULL) {
+    SDL_Log("Couldn't open %s: %s", source_path, strerror(errno));
+    return false;
+  }
+
+  LevelBuilder builder = {
+      .sections =
+          {
+              [LEVEL_SECTION_POINTS] = LevelBuffer_create(sizeof(LevelPoint)),
+              [LEVEL_SECTION_SEGMENTS] =
+                  LevelBuffer_create(sizeof(LevelSegment)),
+              [LEVEL_SECTION_BOXES] = LevelBuffer_create(sizeof(LevelBox)),
+              [LEVEL_SECTION_CHAINS] = LevelBuffer_create(sizeof(LevelChain)),
+              [LEVEL_SECTION_BODIES] = LevelBuffer_create(sizeof(LevelBody)),
+              [LEVEL_SECTION_SPAWNS] = LevelBuffer_create(sizeof(LevelSpawn)),
+              [LEVEL_SECTION_SHIPS] = LevelBuffer_create(sizeof(LevelShip)),
+              [LEVEL_SECTION_SHIP_PARTS] =
+                  LevelBuffer_create(sizeof(LevelShipPart)),
+          },
+      .path = source_path,
+      .line = 0,
+  };
+
+  bool ok = LevelBuilder_parse(&builder, source);
+  fclose(source);
+  if (ok) {
+    LevelBuilder_merge(&builder);
+    ok = LevelBuilder_write(&builder, output_path);
+  }
+
+  for (size_t id = 0; id < LEVEL_SECTION_COUNT; id++) {
+    LevelBuffer_destroy(&builder.sections[id]);
+  }
+  return ok;
+}
@@ -0,0 +1,380 @@
+/*
+    Binary Level Loader
+    Copyright (C) 2025  Ashton Warner
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "debug/debug.h"
+#include "level/level.h"
+#include "util/options.h"
+
+static const size_t LEVEL_STRIDES[LEVEL_SECTION_COUNT] = {
+    [LEVEL_SECTION_POINTS] = sizeof(LevelPoint),
+    [LEVEL_SECTION_SEGMENTS] = sizeof(LevelSegment),
+    [LEVEL_SECTION_BOXES] = sizeof(LevelBox),
+    [LEVEL_SECTION_CHAINS] = sizeof(LevelChain),
+    [LEVEL_SECTION_BODIES] = sizeof(LevelBody),
+    [LEVEL_SECTION_SPAWNS] = sizeof(LevelSpawn),
+    [LEVEL_SECTION_SHIPS] = sizeof(LevelShip),
+    [LEVEL_SECTION_SHIP_PARTS] = sizeof(LevelShipPart),
+};
+
+static bool Level_inRange(LevelRange range, size_t len) {
+  return range.first <= len && range.count <= len - range.first;
+}
+
+// Checks the header and points each slice at its section
+static bool Level_mapSections(Level *self, const char *path) {
+  const LevelHeader *header = self->data;
+  if (self->size < sizeof(LevelHeader) ||
+      SDL_memcmp(header->magic, LEVEL_MAGIC, sizeof(header->magic)) != 0 ||
+      header->version != LEVEL_VERSION) {
+    SDL_Log("%s isn't a version %d level", path, LEVEL_VERSION);
+    return false;
+  }
+  if (header->file_size != self->size ||
+      header->section_count != LEVEL_SECTION_COUNT) {
+    SDL_Log("%s is truncated or malformed", path);
+    return false;
+  }
+
+  const void *sections[LEVEL_SECTION_COUNT];
+  for (size_t id = 0; id < LEVEL_SECTION_COUNT; id++) {
+    const LevelSection *section = &header->sections[id];
+    const Uint64 end =
+        section->offset + (Uint64)section->count * section->stride;
+    if (section->stride != LEVEL_STRIDES[id] ||
+        section->offset % LEVEL_ALIGNMENT != 0 ||
+        section->offset < sizeof(LevelHeader) || end > self->size) {
+      SDL_Log("%s has a bad section %zu", path, id);
+      return false;
+    }
+    sections[id] = (const Uint8 *)self->data + section->offset;
+  }
+
+#define LEVEL_MAP(FIELD, ID)                                                   \
+  self->FIELD.ptr = sections[ID];                                              \
+  self->FIELD.len = header->sections[ID].count
+
+  LEVEL_MAP(points, LEVEL_SECTION_POINTS);
+  LEVEL_MAP(segments, LEVEL_SECTION_SEGMENTS);
+  LEVEL_MAP(boxes, LEVEL_SECTION_BOXES);
+  LEVEL_MAP(chains, LEVEL_SECTION_CHAINS);
+  LEVEL_MAP(bodies, LEVEL_SECTION_BODIES);
+  LEVEL_MAP(spawns, LEVEL_SECTION_SPAWNS);
+  LEVEL_MAP(ships, LEVEL_SECTION_SHIPS);
+  LEVEL_MAP(ship_parts, LEVEL_SECTION_SHIP_PARTS);
+#undef LEVEL_MAP
+  return true;
+}
+
+// Every index has to land inside its section and every shape has to be one
+// Box2D accepts, so building never has to check anything
+static bool Level_validate(const Level *self, const char *path) {
+  forIterArray(self->chains, i) {
+    const LevelChain *chain = &self->chains.ptr[i];
+    if (!Level_inRange(chain->points, self->points.len) ||
+        chain->points.count < 4) {
+      SDL_Log("%s: chain %zu is out of range or too short", path, i);
+      return false;
+    }
+  }
+  forIterArray(self->boxes, i) {
+    const LevelBox *box = &self->boxes.ptr[i];
+    if (!(box->half_extents.x > 0.0f && box->half_extents.y > 0.0f)) {
+      SDL_Log("%s: box %zu has no size", path, i);
+      return false;
+    }
+  }
+  forIterArray(self->bodies, i) {
+    const LevelBody *body = &self->bodies.ptr[i];
+    if (!Level_inRange(body->segments, self->segments.len) ||
+        !Level_inRange(body->boxes, self->boxes.len) ||
+        !Level_inRange(body->chains, self->chains.len)) {
+      SDL_Log("%s: body %zu is out of range", path, i);
+      return false;
+    }
+  }
+  forIterArray(self->spawns, i) {
+    const LevelSpawn *spawn = &self->spawns.ptr[i];
+    if (spawn->kind >= LEVEL_SPAWN_KIND_COUNT) {
+      SDL_Log("%s: spawn %zu has unknown kind %u", path, i,
+              spawn->kind);
+      return false;
+    }
+  }
+  forIterArray(self->ship_parts, i) {
+    const LevelShipPart *part = &self->ship_parts.ptr[i];
+    if (!(part->half_extents.x > 0.0f && part->half_extents.y > 0.0f) ||
+        !(part->density >= 0.0f)) {
+      SDL_Log("%s: ship part %zu has no size or a negative density", path,
+              i);
+      return false;
+    }
+  }
+  forIterArray(self->ships, i) {
+    const LevelShip *ship = &self->ships.ptr[i];
+    if (!Level_inRange(ship->parts, self->ship_parts.len) ||
+        ship->parts.count == 0) {
+      SDL_Log("%s: ship %zu is out of range or empty", path, i);
+      return false;
+    }
+  }
+  return true;
+}
+
+Level *Level_open(Allocator *allocator, const char *path) {
+  debugAssert(path != NULL, "path == NULL");
+
+  const int fd = open(path, O_RDONLY);
+  if (fd < 0) {
+    SDL_Log("Couldn't open level %s: %s", path, strerror(errno));
+    return NULL;
+  }
+  struct stat info;
+  if (fstat(fd, &info) != 0 || info.st_size == 0) {
+    SDL_Log("Couldn't read level %s: %s", path, strerror(errno));
+    close(fd);
+    return NULL;
+  }
+  // Pages only come in as they're touched, and clean ones can be dropped and
+  // reread from the file
+  void *data = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED) {
+    SDL_Log("Couldn't map level %s: %s", path, strerror(errno));
+    return NULL;
+  }
+
+  Level *self = allocPtr(allocator, sizeof(Level), 1);
+  *self = (Level){
+      .allocator = allocator,
+      .data = data,
+      .size = (size_t)info.st_size,
+  };
+  if (!Level_mapSections(self, path) || !Level_validate(self, path)) {
+    Level_close(self);
+    return NULL;
+  }
+  trace("Level %s: %zu bodies, %zu ships, %zu spawns", path, self->bodies.len,
+        self->ships.len, self->spawns.len);
+  return self;
+}
+
+void Level_close(Level *self) {
+  if (self == NULL)
+    return;
+
+  munmap(self->data, self->size);
+  freePtr(self->allocator, self);
+}
+
+b2Vec2 Level_getSpawn(const Level *self, enum LevelSpawnKind kind,
+                      size_t index, b2Vec2 fallback) {
+  debugAssert(self != NULL, "self == NULL");
+  forIterArray(self->spawns, i) {
+    const LevelSpawn *spawn = &self->spawns.ptr[i];
+    if (spawn->kind != kind)
+      continue;
+    if (index-- == 0)
+      return (b2Vec2){spawn->position.x, spawn->position.y};
+  }
+  return fallback;
+}
+
+/*
+ * BUILDING
+ */
+
+static b2Vec2 LevelPoint_toVec(LevelPoint point) {
+  return (b2Vec2){point.x, point.y};
+}
+
+static size_t LevelObject_buildBody(const Level *level, const LevelBody *body,
+                                    b2BodyId id) {
+  b2ShapeDef shape_def = b2DefaultShapeDef();
+
+  for (Uint32 i = 0; i < body->segments.count; i++) {
+    const LevelSegment *segment =
+        &level->segments.ptr[body->segments.first + i];
+    const b2Segment shape = {
+        .point1 = LevelPoint_toVec(segment->point1),
+        .point2 = LevelPoint_toVec(segment->point2),
+    };
+    b2CreateSegmentShape(id, &shape_def, &shape);
+  }
+  for (Uint32 i = 0; i < body->boxes.count; i++) {
+    const LevelBox *box = &level->boxes.ptr[body->boxes.first + i];
+    const b2Polygon shape =
+        b2MakeOffsetBox(box->half_extents.x, box->half_extents.y,
+                        LevelPoint_toVec(box->center), b2MakeRot(box->angle));
+    b2CreatePolygonShape(id, &shape_def, &shape);
+  }
+  size_t shapes = body->segments.count + body->boxes.count;
+
+  for (Uint32 i = 0; i < body->chains.count; i++) {
+    const LevelChain *chain = &level->chains.ptr[body->chains.first + i];
+    b2ChainDef chain_def = b2DefaultChainDef();
+    // Box2D copies the points, so they can come straight from the mapping
+    chain_def.points = (const b2Vec2 *)&level->points.ptr[chain->points.first];
+    chain_def.count = (int)chain->points.count;
+    chain_def.isLoop = (chain->flags & LEVEL_CHAIN_LOOP) != 0;
+    b2CreateChain(id, &chain_def);
+    shapes += chain_def.isLoop ? chain->points.count : chain->points.count - 3;
+  }
+  return shapes;
+}
+
+LevelObject *LevelObject_create(Allocator *allocator, const Level *level,
+                                b2WorldId world) {
+  debugAssert(level != NULL, "level == NULL");
+  _Static_assert(sizeof(LevelPoint) == sizeof(b2Vec2),
+                 "Level points have to match b2Vec2");
+
+  Object2D super = Object2D_create(0.0f, 0.0f, 0.0f, 0.0f);
+  super.render = (void (*)(Object2D *, RenderContext *))LevelObject_render;
+  super.destroy = (void (*)(Object2D *))LevelObject_destroy;
+  super.layer = RENDER_LAYER_BACKGROUND;
+
+  const size_t body_count = level->bodies.len + level->ships.len;
+  LevelObject *self = allocPtr(allocator, sizeof(LevelObject), 1);
+  *self = (LevelObject){
+      .super = super,
+      .allocator = allocator,
+      .level = level,
+      .bodies = body_count > 0
+                    ? allocPtr(allocator, sizeof(b2BodyId), body_count)
+                    : NULL,
+      .body_count = body_count,
+      .shape_count = 0,
+  };
+
+  size_t next = 0;
+  forIterArray(level->bodies, i) {
+    const LevelBody *body = &level->bodies.ptr[i];
+    b2BodyDef body_def = b2DefaultBodyDef();
+    body_def.position = LevelPoint_toVec(body->position);
+    const b2BodyId id = b2CreateBody(world, &body_def);
+    self->shape_count += LevelObject_buildBody(level, body, id);
+    self->bodies[next++] = id;
+  }
+
+  forIterArray(level->ships, i) {
+    const LevelShip *ship = &level->ships.ptr[i];
+    b2BodyDef body_def = b2DefaultBodyDef();
+    body_def.type = b2_dynamicBody;
+    body_def.position = LevelPoint_toVec(ship->position);
+    const b2BodyId id = b2CreateBody(world, &body_def);
+
+    b2ShapeDef shape_def = b2DefaultShapeDef();
+    for (Uint32 i = 0; i < ship->parts.count; i++) {
+      const LevelShipPart *part = &level->ship_parts.ptr[ship->parts.first + i];
+      const b2Polygon shape =
+          b2MakeOffsetBox(part->half_extents.x, part->half_extents.y,
+                          LevelPoint_toVec(part->offset), b2Rot_identity);
+      shape_def.density = part->density;
+      b2CreatePolygonShape(id, &shape_def, &shape);
+    }
+    self->shape_count += ship->parts.count;
+    self->bodies[next++] = id;
+  }
+
+  SDL_Log("Level: %zu bodies, %zu shapes", self->body_count,
+          self->shape_count);
+  return self;
+}
+
+void LevelObject_destroy(LevelObject *self) {
+  for (size_t i = 0; i < self->body_count; i++) {
+    b2DestroyBody(self->bodies[i]);
+  }
+  if (self->bodies != NULL) {
+    freePtr(self->allocator, self->bodies);
+  }
+  self->bodies = NULL;
+  self->body_count = 0;
+
+  Object2D_destroy(&self->super);
+}
+
+// Like the ground, edges are drawn as their bounding box and boxes ignore
+// their angle. Ships are left to the debug draw
+static void LevelObject_drawEdge(LevelObject *self, RenderContext *ctx,
+                                 SDL_FPoint origin, LevelPoint p1,
+                                 LevelPoint p2) {
+  const float thickness = 2.0f;
+
+  SDL_FRect rect = {
+      .x = origin.x + SDL_min(p1.x, p2.x) * PPM_F,
+      .y = origin.y + SDL_min(p1.y, p2.y) * PPM_F - thickness,
+      .w = SDL_fabsf(p2.x - p1.x) * PPM_F + thickness,
+      .h = SDL_fabsf(p2.y - p1.y) * PPM_F + thickness,
+  };
+  RenderContext_fillRect(ctx, self->super.layer, &rect,
+                         (SDL_Color){0x80, 0x80, 0x80, 0xFF});
+}
+
+void LevelObject_render(LevelObject *self, RenderContext *ctx) {
+  const Level *level = self->level;
+  const SDL_FPoint transform = RenderContext_getTransform(ctx);
+
+  forIterArray(level->bodies, i) {
+    const LevelBody *body = &level->bodies.ptr[i];
+    const SDL_FPoint origin = {
+        transform.x + body->position.x * PPM_F,
+        transform.y + body->position.y * PPM_F,
+    };
+
+    for (Uint32 i = 0; i < body->segments.count; i++) {
+      const LevelSegment *segment =
+          &level->segments.ptr[body->segments.first + i];
+      LevelObject_drawEdge(self, ctx, origin, segment->point1,
+                           segment->point2);
+    }
+    for (Uint32 i = 0; i < body->boxes.count; i++) {
+      const LevelBox *box = &level->boxes.ptr[body->boxes.first + i];
+      SDL_FRect rect = {
+          .x = origin.x + (box->center.x - box->half_extents.x) * PPM_F,
+          .y = origin.y + (box->center.y - box->half_extents.y) * PPM_F,
+          .w = box->half_extents.x * 2.0f * PPM_F,
+          .h = box->half_extents.y * 2.0f * PPM_F,
+      };
+      RenderContext_fillRect(ctx, self->super.layer, &rect,
+                             (SDL_Color){0x80, 0x80, 0x80, 0xFF});
+    }
+    for (Uint32 i = 0; i < body->chains.count; i++) {
+      const LevelChain *chain = &level->chains.ptr[body->chains.first + i];
+      const LevelPoint *points = &level->points.ptr[chain->points.first];
+      const Uint32 count = chain->points.count;
+      const bool loop = (chain->flags & LEVEL_CHAIN_LOOP) != 0;
+
+      // Open chains skip the edges out to their ghost points
+      const Uint32 first = loop ? 0 : 1;
+      const Uint32 last = loop ? count : count - 2;
+      for (Uint32 edge = first; edge < last; edge++) {
+        LevelObject_drawEdge(self, ctx, origin, points[edge],
+                             points[(edge + 1) % count]);
+      }
+    }
+  }
+  Object2D_render(&self->super, ctx);
+}
@@ -0,0 +1,514 @@
+/*
+    Static Level Geometry Merging
+    Copyright (C) 2025  Ashton Warner
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <SDL3/SDL.h>
+
+#include "debug/debug.h"
+#include "level/merge.h"
+
+// Everything below works on snapped integer coordinates so edges either meet
+// exactly or not at all
+typedef struct MergeRect {
+  Sint64 x0, y0, x1, y1;
+} MergeRect;
+
+typedef struct MergePoint {
+  Sint64 x, y;
+} MergePoint;
+
+// Directed, with the solid side on its left
+typedef struct MergeEdge {
+  MergePoint start;
+  MergePoint end;
+  bool used;
+} MergeEdge;
+
+// A segment as an interval [t0, t1] along the line (ux, uy) * t + offset
+typedef struct MergeSegment {
+  Sint64 ux, uy, offset;
+  Sint64 t0, t1;
+  LevelPoint p0, p1;
+} MergeSegment;
+
+typedef Stack(MergeEdge) MergeEdgeStack;
+
+static Sint64 Merge_snap(float value) {
+  return SDL_lround(value * LEVEL_MERGE_SCALE);
+}
+
+static float Merge_unsnap(Sint64 value) {
+  return (float)(value / LEVEL_MERGE_SCALE);
+}
+
+static int Merge_sign(Sint64 value) { return (value > 0) - (value < 0); }
+
+static Sint64 Merge_gcd(Sint64 a, Sint64 b) {
+  a = a < 0 ? -a : a;
+  b = b < 0 ? -b : b;
+  while (b != 0) {
+    const Sint64 r = a % b;
+    a = b;
+    b = r;
+  }
+  return a;
+}
+
+static int Merge_compareInt(const void *a, const void *b) {
+  const Sint64 x = *(const Sint64 *)a;
+  const Sint64 y = *(const Sint64 *)b;
+  return (x > y) - (x < y);
+}
+
+static int MergePoint_compare(MergePoint a, MergePoint b) {
+  if (a.x != b.x)
+    return (a.x > b.x) - (a.x < b.x);
+  return (a.y > b.y) - (a.y < b.y);
+}
+
+static int MergeEdge_compare(const void *a, const void *b) {
+  return MergePoint_compare(((const MergeEdge *)a)->start,
+                            ((const MergeEdge *)b)->start);
+}
+
+static int MergeSegment_compare(const void *a, const void *b) {
+  const MergeSegment *x = a;
+  const MergeSegment *y = b;
+  const Sint64 keys[][2] = {
+      {x->ux, y->ux},
+      {x->uy, y->uy},
+      {x->offset, y->offset},
+      {x->t0, y->t0},
+  };
+  for (size_t i = 0; i < sizeof(keys) / sizeof(*keys); i++) {
+    if (keys[i][0] != keys[i][1])
+      return (keys[i][0] > keys[i][1]) - (keys[i][0] < keys[i][1]);
+  }
+  return 0;
+}
+
+// Sorts and drops repeats, returning how many are left
+static size_t Merge_unique(Sint64 *values, size_t count) {
+  if (count == 0)
+    return 0;
+  SDL_qsort(values, count, sizeof(Sint64), Merge_compareInt);
+  size_t unique = 1;
+  for (size_t i = 1; i < count; i++) {
+    if (values[i] != values[unique - 1])
+      values[unique++] = values[i];
+  }
+  return unique;
+}
+
+LevelMerger LevelMerger_create(Allocator *allocator) {
+  return (LevelMerger){
+      .allocator = allocator,
+      .segments = Stack_create(LevelSegment, allocator),
+      .boxes = Stack_create(LevelBox, allocator),
+      .points = Stack_create(LevelPoint, allocator),
+      .loops = Stack_create(LevelRange, allocator),
+      .stats = {0},
+  };
+}
+
+void LevelMerger_destroy(LevelMerger *self) {
+  Stack_destroy(self->segments);
+  Stack_destroy(self->boxes);
+  Stack_destroy(self->points);
+  Stack_destroy(self->loops);
+}
+
+/*
+ * BOXES
+ */
+
+// Axis aligned boxes become rects, anything else is kept as it is
+static bool LevelMerger_toRect(const LevelBox *box, MergeRect *out) {
+  const float quarter = SDL_PI_F / 2.0f;
+  const long turns = SDL_lroundf(box->angle / quarter);
+  if (SDL_fabsf(box->angle - turns * quarter) > LEVEL_MERGE_ANGLE_EPSILON)
+    return false;
+
+  LevelPoint half = box->half_extents;
+  if (turns % 2 != 0) {
+    half = (LevelPoint){half.y, half.x};
+  }
+  *out = (MergeRect){
+      .x0 = Merge_snap(box->center.x - half.x),
+      .y0 = Merge_snap(box->center.y - half.y),
+      .x1 = Merge_snap(box->center.x + half.x),
+      .y1 = Merge_snap(box->center.y + half.y),
+  };
+  // Smaller than the snapping, so it would vanish
+  return out->x0 < out->x1 && out->y0 < out->y1;
+}
+
+// Adds the run [lo, hi] along the line at `y`, pointing +x when `dir` is 1.
+// Transposed rects had x and y swapped, which mirrors them, so their edges
+// are swapped back and reversed
+static void MergeEdges_push(MergeEdgeStack *edges, int dir, Sint64 lo,
+                            Sint64 hi, Sint64 y, bool transposed) {
+  if (dir == 0)
+    return;
+  const Sint64 from = dir > 0 ? lo : hi;
+  const Sint64 to = dir > 0 ? hi : lo;
+  const MergeEdge edge = transposed ? (MergeEdge){
+                                          .start = {y, to},
+                                          .end = {y, from},
+                                          .used = false,
+                                      }
+                                    : (MergeEdge){
+                                          .start = {from, y},
+                                          .end = {to, y},
+                                          .used = false,
+                                      };
+  Stack_push(*edges, edge);
+}
+
+/** \brief Finds the horizontal edges of the union of `rects`
+ *
+ * Every y that a rect starts or ends on is a candidate line. Along it, the
+ * x's of the rects touching the line cut it into spans that are each either
+ * wholly covered by a rect or not, just above and just below the line. A span
+ * is on the outline when exactly one side is solid. Edges between touching
+ * rects have both sides solid, so they're never made.
+ */
+static void LevelMerger_traceLines(LevelMerger *self, const MergeRect *rects,
+                                   size_t count, bool transposed,
+                                   MergeEdgeStack *edges) {
+  Sint64 *lines = allocPtr(self->allocator, sizeof(Sint64), count * 2);
+  Sint64 *cuts = allocPtr(self->allocator, sizeof(Sint64), count * 2);
+  size_t *touching = allocPtr(self->allocator, sizeof(size_t), count);
+
+  for (size_t i = 0; i < count; i++) {
+    lines[i * 2] = rects[i].y0;
+    lines[i * 2 + 1] = rects[i].y1;
+  }
+  const size_t line_count = Merge_unique(lines, count * 2);
+
+  for (size_t line = 0; line < line_count; line++) {
+    const Sint64 y = lines[line];
+    size_t touch_count = 0;
+    size_t cut_count = 0;
+    for (size_t i = 0; i < count; i++) {
+      if (rects[i].y0 <= y && y <= rects[i].y1) {
+        touching[touch_count++] = i;
+        cuts[cut_count++] = rects[i].x0;
+        cuts[cut_count++] = rects[i].x1;
+      }
+    }
+    cut_count = Merge_unique(cuts, cut_count);
+
+    // Neighbouring spans going the same way are one edge
+    int run_dir = 0;
+    Sint64 run_lo = 0;
+    Sint64 run_hi = 0;
+    for (size_t cut = 0; cut + 1 < cut_count; cut++) {
+      const Sint64 lo = cuts[cut];
+      const Sint64 hi = cuts[cut + 1];
+      bool above = false;
+      bool below = false;
+      for (size_t t = 0; t < touch_count; t++) {
+        const MergeRect *rect = &rects[touching[t]];
+        if (rect->x0 <= lo && hi <= rect->x1) {
+          above |= rect->y0 <= y && y < rect->y1;
+          below |= rect->y0 < y && y <= rect->y1;
+        }
+      }
+
+      // Solid above means the outside is below, which is on the right of an
+      // edge pointing +x
+      const int dir = above == below ? 0 : above ? 1 : -1;
+      if (dir != 0 && dir == run_dir && lo == run_hi) {
+        run_hi = hi;
+        continue;
+      }
+      MergeEdges_push(edges, run_dir, run_lo, run_hi, y, transposed);
+      run_dir = dir;
+      run_lo = lo;
+      run_hi = hi;
+    }
+    MergeEdges_push(edges, run_dir, run_lo, run_hi, y, transposed);
+  }
+
+  freePtr(self->allocator, touching);
+  freePtr(self->allocator, cuts);
+  freePtr(self->allocator, lines);
+}
+
+// First edge starting at `point`
+static size_t MergeEdges_find(const MergeEdge *edges, size_t count,
+                              MergePoint point) {
+  size_t lo = 0;
+  size_t hi = count;
+  while (lo < hi) {
+    const size_t mid = lo + (hi - lo) / 2;
+    if (MergePoint_compare(edges[mid].start, point) < 0)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return lo;
+}
+
+// Where a point turns the corner, positive for a left turn
+static int MergeEdge_turn(const MergeEdge *in, const MergeEdge *out) {
+  const int in_x = Merge_sign(in->end.x - in->start.x);
+  const int in_y = Merge_sign(in->end.y - in->start.y);
+  const int out_x = Merge_sign(out->end.x - out->start.x);
+  const int out_y = Merge_sign(out->end.y - out->start.y);
+  return in_x * out_y - in_y * out_x;
+}
+
+// Twice the signed area, positive when wound counter clockwise
+static float LevelMerger_loopArea(const LevelMerger *self, LevelRange loop) {
+  const LevelPoint *points = &self->points.data.ptr[loop.first];
+  float area = 0.0f;
+  for (Uint32 i = 0; i < loop.count; i++) {
+    const LevelPoint p = points[i];
+    const LevelPoint q = points[(i + 1) % loop.count];
+    area += p.x * q.y - q.x * p.y;
+  }
+  return area;
+}
+
+/** \brief Turns loops that are lone rectangles back into boxes
+ *
+ * One polygon is cheaper than four chain edges. Holes go the other way round
+ * and stay loops, and so does any rectangle with a hole in it.
+ */
+static void LevelMerger_takeRects(LevelMerger *self, size_t first_loop) {
+  LevelRange *loops = self->loops.data.ptr;
+  LevelPoint *points = self->points.data.ptr;
+  size_t kept = first_loop;
+  Uint32 next_point = first_loop < self->loops.len ? loops[first_loop].first
+                                                   : (Uint32)self->points.len;
+
+  for (size_t i = first_loop; i < self->loops.len; i++) {
+    const LevelRange loop = loops[i];
+    bool rect = loop.count == 4 && LevelMerger_loopArea(self, loop) > 0.0f;
+
+    LevelPoint min = points[loop.first];
+    LevelPoint max = points[loop.first];
+    for (Uint32 k = 0; rect && k < loop.count; k++) {
+      const LevelPoint p = points[loop.first + k];
+      min = (LevelPoint){SDL_min(min.x, p.x), SDL_min(min.y, p.y)};
+      max = (LevelPoint){SDL_max(max.x, p.x), SDL_max(max.y, p.y)};
+    }
+    for (size_t j = first_loop; rect && j < self->loops.len; j++) {
+      const LevelPoint p = points[loops[j].first];
+      rect = LevelMerger_loopArea(self, loops[j]) > 0.0f ||
+             !(min.x < p.x && p.x < max.x && min.y < p.y && p.y < max.y);
+    }
+
+    if (rect) {
+      const LevelBox box = {
+          .center = {(min.x + max.x) / 2.0f, (min.y + max.y) / 2.0f},
+          .half_extents = {(max.x - min.x) / 2.0f, (max.y - min.y) / 2.0f},
+          .angle = 0.0f,
+          .reserved = 0,
+      };
+      Stack_push(self->boxes, box);
+      continue;
+    }
+    // Kept loops only ever move down, over ones already read
+    for (Uint32 k = 0; k < loop.count; k++) {
+      points[next_point + k] = points[loop.first + k];
+    }
+    loops[kept++] = (LevelRange){next_point, loop.count};
+    next_point += loop.count;
+    self->stats.loops++;
+    self->stats.loop_edges += loop.count;
+  }
+  self->loops.len = kept;
+  self->points.len = next_point;
+}
+
+/** \brief Links the outline edges into loops
+ *
+ * Every corner has as many edges in as out. Where two boxes only touch at a
+ * corner there are two ways on, and the left turn keeps the boxes' loops
+ * apart.
+ */
+static void LevelMerger_linkLoops(LevelMerger *self, MergeEdgeStack *edges) {
+  MergeEdge *all = edges->data.ptr;
+  const size_t count = edges->len;
+  if (count == 0)
+    return;
+  SDL_qsort(all, count, sizeof(MergeEdge), MergeEdge_compare);
+
+  for (size_t first = 0; first < count; first++) {
+    if (all[first].used)
+      continue;
+
+    const LevelRange loop = {.first = (Uint32)self->points.len, .count = 0};
+    Stack_push(self->loops, loop);
+    LevelRange *range = Stack_peek(self->loops);
+
+    MergeEdge *edge = &all[first];
+    edge->used = true;
+    while (true) {
+      const LevelPoint point = {Merge_unsnap(edge->start.x),
+                                Merge_unsnap(edge->start.y)};
+      Stack_push(self->points, point);
+      range->count++;
+      if (MergePoint_compare(edge->end, all[first].start) == 0)
+        break;
+
+      MergeEdge *next = NULL;
+      int best = -2;
+      for (size_t i = MergeEdges_find(all, count, edge->end);
+           i < count && MergePoint_compare(all[i].start, edge->end) == 0;
+           i++) {
+        const int turn = MergeEdge_turn(edge, &all[i]);
+        if (!all[i].used && turn > best) {
+          best = turn;
+          next = &all[i];
+        }
+      }
+      debugAssert(next != NULL, "Outline isn't closed at %ld, %ld",
+                  (long)edge->end.x, (long)edge->end.y);
+      if (next == NULL)
+        break;
+      next->used = true;
+      edge = next;
+    }
+    debugAssert(range->count >= 4, "Loop with %u corners", range->count);
+  }
+}
+
+static void LevelMerger_mergeBoxes(LevelMerger *self, const LevelBox *boxes,
+                                   size_t count) {
+  if (count == 0)
+    return;
+
+  MergeRect *rects = allocPtr(self->allocator, sizeof(MergeRect), count);
+  MergeRect *transposed = allocPtr(self->allocator, sizeof(MergeRect), count);
+  size_t rect_count = 0;
+  for (size_t i = 0; i < count; i++) {
+    MergeRect rect;
+    if (LevelMerger_toRect(&boxes[i], &rect)) {
+      rects[rect_count] = rect;
+      transposed[rect_count] = (MergeRect){rect.y0, rect.x0, rect.y1, rect.x1};
+      rect_count++;
+    } else {
+      Stack_push(self->boxes, boxes[i]);
+    }
+  }
+  self->stats.boxes += count;
+  self->stats.boxes_merged += rect_count;
+
+  if (rect_count > 0) {
+    MergeEdgeStack edges = Stack_create(MergeEdge, self->allocator);
+    LevelMerger_traceLines(self, rects, rect_count, false, &edges);
+    LevelMerger_traceLines(self, transposed, rect_count, true, &edges);
+    const size_t first_loop = self->loops.len;
+    LevelMerger_linkLoops(self, &edges);
+    LevelMerger_takeRects(self, first_loop);
+    Stack_destroy(edges);
+  }
+  self->stats.boxes_out += self->boxes.len;
+
+  freePtr(self->allocator, transposed);
+  freePtr(self->allocator, rects);
+}
+
+/*
+ * SEGMENTS
+ */
+
+static void LevelMerger_mergeSegments(LevelMerger *self,
+                                      const LevelSegment *segments,
+                                      size_t count) {
+  if (count == 0)
+    return;
+  self->stats.segments += count;
+
+  MergeSegment *lines = allocPtr(self->allocator, sizeof(MergeSegment), count);
+  size_t line_count = 0;
+  for (size_t i = 0; i < count; i++) {
+    LevelPoint p0 = segments[i].point1;
+    LevelPoint p1 = segments[i].point2;
+    const Sint64 x0 = Merge_snap(p0.x);
+    const Sint64 y0 = Merge_snap(p0.y);
+    const Sint64 x1 = Merge_snap(p1.x);
+    const Sint64 y1 = Merge_snap(p1.y);
+    const Sint64 gcd = Merge_gcd(x1 - x0, y1 - y0);
+    // Shorter than the snapping
+    if (gcd == 0)
+      continue;
+
+    // The smallest whole step along the line, pointing +x, or +y if upright
+    Sint64 ux = (x1 - x0) / gcd;
+    Sint64 uy = (y1 - y0) / gcd;
+    if (ux < 0 || (ux == 0 && uy < 0)) {
+      ux = -ux;
+      uy = -uy;
+    }
+    Sint64 t0 = ux * x0 + uy * y0;
+    Sint64 t1 = ux * x1 + uy * y1;
+    if (t0 > t1) {
+      const Sint64 t = t0;
+      t0 = t1;
+      t1 = t;
+      const LevelPoint p = p0;
+      p0 = p1;
+      p1 = p;
+    }
+    lines[line_count++] = (MergeSegment){
+        .ux = ux,
+        .uy = uy,
+        .offset = ux * y0 - uy * x0,
+        .t0 = t0,
+        .t1 = t1,
+        .p0 = p0,
+        .p1 = p1,
+    };
+  }
+  SDL_qsort(lines, line_count, sizeof(MergeSegment), MergeSegment_compare);
+
+  for (size_t i = 0; i < line_count;) {
+    MergeSegment merged = lines[i++];
+    while (i < line_count && lines[i].ux == merged.ux &&
+           lines[i].uy == merged.uy && lines[i].offset == merged.offset &&
+           lines[i].t0 <= merged.t1) {
+      if (lines[i].t1 > merged.t1) {
+        merged.t1 = lines[i].t1;
+        merged.p1 = lines[i].p1;
+      }
+      i++;
+    }
+    const LevelSegment segment = {merged.p0, merged.p1};
+    Stack_push(self->segments, segment);
+  }
+  self->stats.segments_out += self->segments.len;
+
+  freePtr(self->allocator, lines);
+}
+
+void LevelMerger_mergeBody(LevelMerger *self, const LevelSegment *segments,
+                           size_t segment_count, const LevelBox *boxes,
+                           size_t box_count) {
+  debugAssert(self != NULL, "self == NULL");
+  Stack_clear(self->segments);
+  Stack_clear(self->boxes);
+  Stack_clear(self->points);
+  Stack_clear(self->loops);
+
+  LevelMerger_mergeSegments(self, segments, segment_count);
+  LevelMerger_mergeBoxes(self, boxes, box_count);
+}
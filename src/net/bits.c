@@ -0,0 +1,147 @@
+/*
+    Bit Packing
+    Copyright (C) 2025  Ashton Warner
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "debug/debug.h"
+#include "net/bits.h"
+
+#define BITS_VARINT_GROUP 4
+#define BITS_VARINT_MORE (1u << BITS_VARINT_GROUP)
+
+/*
+ * WRITING
+ */
+
+BitWriter BitWriter_create(Uint8 *data, size_t capacity) {
+  debugAssert(data != NULL, "data == NULL");
+  return (BitWriter){
+      .data = data,
+      .capacity = capacity,
+      .bits = 0,
+      .overflow = false,
+  };
+}
+
+void BitWriter_write(BitWriter *self, Uint32 value, int count) {
+  debugAssert(count >= 0 && count <= 32, "can't write %d bits", count);
+  if (self->overflow || self->bits + count > self->capacity * 8) {
+    self->overflow = true;
+    return;
+  }
+
+  for (int written = 0; written < count;) {
+    const size_t byte = self->bits / 8;
+    const int offset = self->bits % 8;
+    const int take = SDL_min(8 - offset, count - written);
+    // Bytes are started fresh, so the buffer doesn't have to be cleared
+    if (offset == 0) {
+      self->data[byte] = 0;
+    }
+    self->data[byte] |=
+        (Uint8)(((value >> written) & ((1u << take) - 1)) << offset);
+    written += take;
+    self->bits += take;
+  }
+}
+
+void BitWriter_writeVarint(BitWriter *self, Uint32 value) {
+  while (value >= BITS_VARINT_MORE) {
+    BitWriter_write(self, (value & (BITS_VARINT_MORE - 1)) | BITS_VARINT_MORE,
+                    BITS_VARINT_GROUP + 1);
+    value >>= BITS_VARINT_GROUP;
+  }
+  BitWriter_write(self, value, BITS_VARINT_GROUP + 1);
+}
+
+void BitWriter_writeSigned(BitWriter *self, Sint32 value) {
+  BitWriter_writeVarint(self, ((Uint32)value << 1) ^ (Uint32)(value >> 31));
+}
+
+void BitWriter_writeBytes(BitWriter *self, const Uint8 *bytes, size_t length) {
+  const size_t start = BitWriter_getSize(self);
+  if (self->overflow || start + length > self->capacity) {
+    self->overflow = true;
+    return;
+  }
+  SDL_memcpy(&self->data[start], bytes, length);
+  self->bits = (start + length) * 8;
+}
+
+size_t BitWriter_getSize(const BitWriter *self) {
+  return (self->bits + 7) / 8;
+}
+
+/*
+ * READING
+ */
+
+BitReader BitReader_create(const Uint8 *data, size_t size) {
+  return (BitReader){
+      .data = data,
+      .size = size,
+      .bits = 0,
+      .overflow = false,
+  };
+}
+
+Uint32 BitReader_read(BitReader *self, int count) {
+  debugAssert(count >= 0 && count <= 32, "can't read %d bits", count);
+  if (self->overflow || self->bits + count > self->size * 8) {
+    self->overflow = true;
+    return 0;
+  }
+
+  Uint32 value = 0;
+  for (int read = 0; read < count;) {
+    const int offset = self->bits % 8;
+    const int take = SDL_min(8 - offset, count - read);
+    const Uint32 bits =
+        ((Uint32)self->data[self->bits / 8] >> offset) & ((1u << take) - 1);
+    value |= bits << read;
+    read += take;
+    self->bits += take;
+  }
+  return value;
+}
+
+Uint32 BitReader_readVarint(BitReader *self) {
+  Uint32 value = 0;
+  for (int shift = 0; shift < 32; shift += BITS_VARINT_GROUP) {
+    const Uint32 group = BitReader_read(self, BITS_VARINT_GROUP + 1);
+    value |= (group & (BITS_VARINT_MORE - 1)) << shift;
+    if ((group & BITS_VARINT_MORE) == 0)
+      return value;
+  }
+  // Nothing we write runs this long
+  self->overflow = true;
+  return 0;
+}
+
+Sint32 BitReader_readSigned(BitReader *self) {
+  const Uint32 value = BitReader_readVarint(self);
+  return (Sint32)(value >> 1) ^ -(Sint32)(value & 1);
+}
+
+const Uint8 *BitReader_readBytes(BitReader *self, size_t length) {
+  const size_t start = (self->bits + 7) / 8;
+  if (self->overflow || start + length > self->size) {
+    self->overflow = true;
+    return NULL;
+  }
+  self->bits = (start + length) * 8;
+  return &self->data[start];
+}
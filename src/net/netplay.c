@@ -0,0 +1,789 @@
+/*
+    Rollback Netplay
+    Copyright (C) 2025  Ashton Warner
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "debug/debug.h"
+#include "net/bits.h"
+#include "net/netplay.h"
+
+#define NETPLAY_BUTTON_MASK ((Uint32)((1ull << INPUT_BUTTON_COUNT) - 1))
+#define NETPLAY_SNAPSHOT_STRIDE(SIZE) (((SIZE) + 7) & ~(size_t)7)
+#define NETPLAY_PIECES(SIZE)                                                   \
+  (((SIZE) + NETPLAY_PIECE_SIZE - 1) / NETPLAY_PIECE_SIZE)
+
+NetplayDef NetplayDef_default() {
+  return (NetplayDef){
+      .players = 0,
+      .local = 0,
+      .addresses = {{0}},
+      .input_delay = 2,
+      .conditions = {0},
+      .seed = 0,
+      .clock = NULL,
+  };
+}
+
+static Uint64 NetplaySession_now(const NetplaySession *self) {
+  return self->clock != NULL ? *self->clock : SDL_GetTicksNS();
+}
+
+/*
+ * INPUTS
+ */
+
+// Field by field, the padding in between is never written
+static bool NetplayInput_equals(const ReplayFrame *a, const ReplayFrame *b) {
+  if (a->buttons != b->buttons || a->hat_x != b->hat_x ||
+      a->hat_y != b->hat_y)
+    return false;
+  for (size_t axis = 0; axis < INPUT_AXIS_COUNT; axis++) {
+    if (a->axes[axis] != b->axes[axis])
+      return false;
+  }
+  return true;
+}
+
+static void NetplayInput_write(BitWriter *writer, const ReplayFrame *previous,
+                               const ReplayFrame *input) {
+  Uint32 mask = 0;
+  if (input->buttons != previous->buttons)
+    mask |= REPLAY_FIELD_BUTTONS;
+  if (input->hat_x != previous->hat_x || input->hat_y != previous->hat_y)
+    mask |= REPLAY_FIELD_HAT;
+  for (size_t axis = 0; axis < INPUT_AXIS_COUNT; axis++) {
+    if (input->axes[axis] != previous->axes[axis])
+      mask |= REPLAY_FIELD_AXIS(axis);
+  }
+
+  BitWriter_write(writer, mask != 0, 1);
+  if (mask == 0)
+    return;
+  BitWriter_write(writer, mask, NETPLAY_MASK_BITS);
+  if (mask & REPLAY_FIELD_BUTTONS) {
+    BitWriter_write(writer, input->buttons ^ previous->buttons,
+                    INPUT_BUTTON_COUNT);
+  }
+  if (mask & REPLAY_FIELD_HAT) {
+    BitWriter_write(writer, (input->hat_x + 1) | ((input->hat_y + 1) << 2), 4);
+  }
+  for (size_t axis = 0; axis < INPUT_AXIS_COUNT; axis++) {
+    if ((mask & REPLAY_FIELD_AXIS(axis)) == 0)
+      continue;
+    const Sint16 value = input->axes[axis];
+    const Uint32 tag = value == 0        ? NETPLAY_AXIS_ZERO
+                       : value == 32767  ? NETPLAY_AXIS_MAX
+                       : value == -32767 ? NETPLAY_AXIS_MIN
+                                         : NETPLAY_AXIS_RAW;
+    BitWriter_write(writer, tag, 2);
+    if (tag == NETPLAY_AXIS_RAW)
+      BitWriter_write(writer, (Uint16)value, 16);
+  }
+}
+
+static ReplayFrame NetplayInput_read(BitReader *reader,
+                                     const ReplayFrame *previous) {
+  ReplayFrame input = *previous;
+  if (BitReader_read(reader, 1) == 0)
+    return input;
+  const Uint32 mask = BitReader_read(reader, NETPLAY_MASK_BITS);
+  if (mask & REPLAY_FIELD_BUTTONS) {
+    input.buttons ^= BitReader_read(reader, INPUT_BUTTON_COUNT);
+  }
+  if (mask & REPLAY_FIELD_HAT) {
+    const Uint32 hat = BitReader_read(reader, 4);
+    input.hat_x = (Sint8)(hat & 3) - 1;
+    input.hat_y = (Sint8)((hat >> 2) & 3) - 1;
+  }
+  for (size_t axis = 0; axis < INPUT_AXIS_COUNT; axis++) {
+    if ((mask & REPLAY_FIELD_AXIS(axis)) == 0)
+      continue;
+    switch (BitReader_read(reader, 2)) {
+    case NETPLAY_AXIS_ZERO:
+      input.axes[axis] = 0;
+      break;
+    case NETPLAY_AXIS_MAX:
+      input.axes[axis] = 32767;
+      break;
+    case NETPLAY_AXIS_MIN:
+      input.axes[axis] = -32767;
+      break;
+    default:
+      input.axes[axis] = (Sint16)BitReader_read(reader, 16);
+      break;
+    }
+  }
+  return input;
+}
+
+/*
+ * SESSION
+ */
+
+NetplaySession *NetplaySession_create(Allocator *allocator, NetSocket *socket,
+                                      const NetplayDef *def,
+                                      size_t snapshot_size) {
+  debugAssert(socket != NULL, "socket == NULL");
+  debugAssert(def->players >= 2 && def->players <= NETPLAY_MAX_PLAYERS,
+              "%zu players", def->players);
+  debugAssert(def->local < def->players, "slot %zu of %zu", def->local,
+              def->players);
+  debugAssert(def->input_delay <= NETPLAY_MAX_DELAY, "%u frames of delay",
+              def->input_delay);
+
+  // Far too big for the stack, so it's filled in where it lives
+  NetplaySession *self = allocPtr(allocator, sizeof(NetplaySession), 1);
+  SDL_memset(self, 0, sizeof(NetplaySession));
+  self->allocator = allocator;
+  self->socket = socket;
+  self->clock = def->clock;
+  self->players = def->players;
+  self->local = def->local;
+  self->input_delay = def->input_delay;
+  self->rollback = NETPLAY_NO_FRAME;
+  self->snapshot_size = snapshot_size;
+  self->snapshots = allocPtr(allocator, NETPLAY_SNAPSHOT_STRIDE(snapshot_size),
+                             NETPLAY_SNAPSHOTS);
+  for (size_t i = 0; i < NETPLAY_CHECKSUMS; i++) {
+    self->checksums[i].frame = NETPLAY_NO_FRAME;
+  }
+  self->latest.frame = NETPLAY_NO_FRAME;
+  self->resync_frame = NETPLAY_NO_FRAME;
+  NetSocket_setConditions(socket, def->conditions, def->seed);
+
+  const Uint64 now = NetplaySession_now(self);
+  for (size_t slot = 0; slot < self->players; slot++) {
+    if (slot == self->local)
+      continue;
+    self->peers[slot] = (NetplayPeer){
+        .address = def->addresses[slot],
+        .acked = 0,
+        .frame = 0,
+        .advantage = 0,
+        .frame_at = now,
+        .drift = 0.0f,
+        .last_heard = now,
+        .rtt_ns = 0,
+        .checksum = {.frame = NETPLAY_NO_FRAME, .hash = 0},
+        .checksum_through = 0,
+        .resync_sending = false,
+        .resync_frame = NETPLAY_NO_FRAME,
+        .resync_piece = 0,
+        .resync_data = NULL,
+        .resync_through = 0,
+    };
+  }
+  // The delayed frames at the start are nothing held, which is already there
+  self->confirmed[self->local] = self->input_delay;
+  return self;
+}
+
+void NetplaySession_destroy(NetplaySession *self) {
+  if (self == NULL)
+    return;
+  NetSocket_close(self->socket);
+  for (size_t slot = 0; slot < self->players; slot++) {
+    if (self->peers[slot].resync_data != NULL)
+      freePtr(self->allocator, self->peers[slot].resync_data);
+  }
+  if (self->resync_data != NULL) {
+    freePtr(self->allocator, self->resync_data);
+    freePtr(self->allocator, self->resync_pieces);
+  }
+  freePtr(self->allocator, self->snapshots);
+  freePtr(self->allocator, self);
+}
+
+Uint32 NetplaySession_getConfirmed(const NetplaySession *self) {
+  Uint32 confirmed = NETPLAY_NO_FRAME;
+  for (size_t slot = 0; slot < self->players; slot++) {
+    confirmed = SDL_min(confirmed, self->confirmed[slot]);
+  }
+  return confirmed;
+}
+
+Uint8 *NetplaySession_getSnapshot(NetplaySession *self, Uint32 frame) {
+  debugAssert(frame <= self->frame + 1 &&
+                  frame + NETPLAY_SNAPSHOTS > self->frame + 1,
+              "frame %u isn't kept at frame %u", frame, self->frame);
+  return &self->snapshots[(frame % NETPLAY_SNAPSHOTS) *
+                          NETPLAY_SNAPSHOT_STRIDE(self->snapshot_size)];
+}
+
+// How many frames ahead of them we are. They've moved on since telling us,
+// by however long it took to get here and however long ago that was
+static Sint32 NetplaySession_getAdvantage(const NetplaySession *self,
+                                          const NetplayPeer *peer, Uint64 now) {
+  const Uint64 since = peer->rtt_ns / 2 + (now - peer->frame_at);
+  return (Sint32)(self->frame - peer->frame) -
+         (Sint32)(since / NETPLAY_TICK_NS);
+}
+
+// A resync that has fully arrived but isn't applied yet
+static bool NetplaySession_hasResync(const NetplaySession *self) {
+  return self->resync_frame != NETPLAY_NO_FRAME && self->resync_missing == 0 &&
+         self->resync_frame >= self->resync_through;
+}
+
+/*
+ * CHECKSUMS
+ */
+
+// FNV-1a, nothing here is adversarial
+static Uint32 NetplaySession_hash(const Uint8 *data, size_t size) {
+  Uint32 hash = 2166136261u;
+  for (size_t i = 0; i < size; i++) {
+    hash = (hash ^ data[i]) * 16777619u;
+  }
+  return hash;
+}
+
+// Picked when the first piece goes out, by then any rollback this tick found
+// is replayed
+static void NetplaySession_startResync(NetplaySession *self, size_t slot) {
+  NetplayPeer *peer = &self->peers[slot];
+  peer->resync_sending = true;
+  peer->resync_frame = NETPLAY_NO_FRAME;
+  peer->resync_piece = 0;
+  self->stats.resyncs++;
+}
+
+// Compares a player's newest checksum with ours for the same frame once both
+// exist. Only slot 0's count, unless we're slot 0
+static void NetplaySession_compareChecksum(NetplaySession *self, size_t slot) {
+  NetplayPeer *peer = &self->peers[slot];
+  const Uint32 frame = peer->checksum.frame;
+  if (frame == NETPLAY_NO_FRAME)
+    return;
+  const NetplayChecksum *ours =
+      &self->checksums[(frame / NETPLAY_CHECKSUM_INTERVAL) % NETPLAY_CHECKSUMS];
+  // Ours from there on are about to be replaced
+  if (ours->frame != frame ||
+      (NetplaySession_hasResync(self) && frame >= self->resync_frame))
+    return;
+  const bool matched = ours->hash == peer->checksum.hash;
+  peer->checksum.frame = NETPLAY_NO_FRAME;
+  peer->checksum_through = frame + 1;
+
+  if (self->local != 0 && slot != 0)
+    return;
+  // Until they've caught up with the last resync they're expected to differ
+  if (self->local == 0 &&
+      (peer->resync_sending || frame < peer->resync_through))
+    return;
+  if (self->local != 0 && frame < self->resync_through)
+    return;
+  self->stats.checksums++;
+  if (matched)
+    return;
+
+  self->stats.desyncs++;
+  if (self->stats.desyncs == 1)
+    SDL_Log("Player %zu's world disagrees with ours at frame %u", slot, frame);
+  if (self->local == 0)
+    NetplaySession_startResync(self, slot);
+}
+
+// Every checksummed frame every input has arrived for
+static void NetplaySession_takeChecksums(NetplaySession *self) {
+  const Uint32 final = SDL_min(NetplaySession_getConfirmed(self), self->frame);
+  for (; self->next_checksum <= final;
+       self->next_checksum += NETPLAY_CHECKSUM_INTERVAL) {
+    const Uint32 frame = self->next_checksum;
+    // Replaying a resync can come from further back than is kept
+    if (frame + NETPLAY_SNAPSHOTS <= self->frame + 1)
+      continue;
+    NetplayChecksum *checksum =
+        &self->checksums[(frame / NETPLAY_CHECKSUM_INTERVAL) %
+                         NETPLAY_CHECKSUMS];
+    *checksum = (NetplayChecksum){
+        .frame = frame,
+        .hash = NetplaySession_hash(NetplaySession_getSnapshot(self, frame),
+                                    self->snapshot_size),
+    };
+    self->latest = *checksum;
+    for (size_t slot = 0; slot < self->players; slot++) {
+      if (slot != self->local && self->peers[slot].checksum.frame == frame)
+        NetplaySession_compareChecksum(self, slot);
+    }
+  }
+}
+
+/*
+ * RECEIVING
+ */
+
+static bool NetplaySession_readInputs(NetplaySession *self, size_t slot,
+                                      Uint32 frame, BitReader *reader,
+                                      Uint64 now) {
+  NetplayPeer *peer = &self->peers[slot];
+  const Sint32 advantage = BitReader_readSigned(reader);
+  const Uint32 received = frame + BitReader_readSigned(reader);
+  const Uint32 first = frame + BitReader_readSigned(reader);
+  const Uint32 count = BitReader_readVarint(reader);
+  if (reader->overflow || count > NETPLAY_MAX_REDUNDANT)
+    return false;
+
+  // Everything is read before anything changes, so a bad packet changes
+  // nothing. The layout doesn't depend on what it's against, so inputs we
+  // can't use are still read past
+  const Uint32 confirmed = self->confirmed[slot];
+  const bool usable =
+      first <= confirmed && confirmed - first < NETPLAY_HISTORY / 2;
+  ReplayFrame inputs[NETPLAY_MAX_REDUNDANT];
+  ReplayFrame previous = usable && first > 0
+                             ? self->inputs[slot][(first - 1) % NETPLAY_HISTORY]
+                             : (ReplayFrame){0};
+  for (Uint32 i = 0; i < count; i++) {
+    inputs[i] = NetplayInput_read(reader, &previous);
+    previous = inputs[i];
+  }
+
+  NetplayChecksum checksum = {.frame = NETPLAY_NO_FRAME, .hash = 0};
+  if (BitReader_read(reader, 1)) {
+    checksum.frame = frame - BitReader_readVarint(reader);
+    checksum.hash = BitReader_read(reader, 32);
+  }
+  const bool has_through = BitReader_read(reader, 1);
+  const Uint32 resync_through = has_through ? BitReader_read(reader, 32) : 0;
+  // They can't have inputs we never sent
+  if (reader->overflow || received > self->sent)
+    return false;
+
+  // Packets can arrive out of order, their frame only moves forward
+  if (frame >= peer->frame) {
+    peer->frame = frame;
+    peer->advantage = advantage;
+    peer->frame_at = now;
+  }
+  if (received > peer->acked) {
+    // From when the newest input they have first went out
+    const Uint64 sample = now - self->sent_at[(received - 1) % NETPLAY_HISTORY];
+    peer->rtt_ns = peer->rtt_ns == 0 ? sample : (peer->rtt_ns * 7 + sample) / 8;
+    peer->acked = received;
+  }
+
+  if (usable) {
+    for (Uint32 i = confirmed - first; i < count; i++) {
+      const Uint32 at = first + i;
+      // Any further would land on inputs that are still needed
+      if (at >= self->frame + NETPLAY_HISTORY / 2)
+        break;
+      ReplayFrame *held = &self->inputs[slot][at % NETPLAY_HISTORY];
+      if (at < self->frame && !NetplayInput_equals(held, &inputs[i])) {
+        self->stats.mispredictions++;
+        self->rollback = SDL_min(self->rollback, at);
+      }
+      *held = inputs[i];
+      self->confirmed[slot] = at + 1;
+    }
+  }
+
+  if (has_through && resync_through > peer->resync_through) {
+    peer->resync_through = resync_through;
+    if (peer->resync_sending && resync_through > peer->resync_frame)
+      peer->resync_sending = false;
+  }
+  if (checksum.frame != NETPLAY_NO_FRAME &&
+      checksum.frame >= peer->checksum_through) {
+    peer->checksum = checksum;
+    NetplaySession_compareChecksum(self, slot);
+  }
+  return true;
+}
+
+static bool NetplaySession_readResync(NetplaySession *self, size_t slot,
+                                      Uint32 frame, BitReader *reader) {
+  const Uint32 size = BitReader_readVarint(reader);
+  const Uint32 piece = BitReader_readVarint(reader);
+  const size_t pieces = NETPLAY_PIECES(self->snapshot_size);
+  // A different size is a different world, which a snapshot can't fix
+  if (reader->overflow || slot != 0 || self->local == 0 ||
+      size != self->snapshot_size || piece >= pieces)
+    return false;
+  const size_t offset = (size_t)piece * NETPLAY_PIECE_SIZE;
+  const size_t length = SDL_min(NETPLAY_PIECE_SIZE, size - offset);
+  const Uint8 *bytes = BitReader_readBytes(reader, length);
+  if (bytes == NULL)
+    return false;
+
+  // Already taken, this is a copy still on its way
+  if (frame < self->resync_through)
+    return true;
+  if (frame != self->resync_frame) {
+    if (self->resync_data == NULL) {
+      self->resync_data = allocPtr(self->allocator, 1, self->snapshot_size);
+      self->resync_pieces = allocPtr(self->allocator, 1, pieces);
+    }
+    SDL_memset(self->resync_pieces, 0, pieces);
+    self->resync_frame = frame;
+    self->resync_missing = pieces;
+  }
+  if (!self->resync_pieces[piece]) {
+    SDL_memcpy(&self->resync_data[offset], bytes, length);
+    self->resync_pieces[piece] = true;
+    self->resync_missing--;
+    self->stats.resync_bytes += length;
+  }
+  return true;
+}
+
+static bool NetplaySession_read(NetplaySession *self, NetAddress from,
+                                const Uint8 *packet, size_t length,
+                                Uint64 now) {
+  BitReader reader = BitReader_create(packet, length);
+  const Uint32 magic = BitReader_read(&reader, 8);
+  const Uint32 version = BitReader_read(&reader, 4);
+  const Uint32 kind = BitReader_read(&reader, 4);
+  const size_t slot = BitReader_read(&reader, 4);
+  const Uint32 frame = BitReader_read(&reader, 32);
+  if (reader.overflow || magic != NETPLAY_MAGIC ||
+      version != NETPLAY_VERSION || slot >= self->players ||
+      slot == self->local ||
+      !NetAddress_equals(from, self->peers[slot].address))
+    return false;
+
+  bool read;
+  switch (kind) {
+  case NETPLAY_PACKET_INPUT:
+    read = NetplaySession_readInputs(self, slot, frame, &reader, now);
+    break;
+  case NETPLAY_PACKET_RESYNC:
+    read = NetplaySession_readResync(self, slot, frame, &reader);
+    break;
+  default:
+    return false;
+  }
+  if (read)
+    self->peers[slot].last_heard = now;
+  return read;
+}
+
+bool NetplaySession_poll(NetplaySession *self) {
+  debugAssert(self != NULL, "self == NULL");
+  const Uint64 now = NetplaySession_now(self);
+  NetSocket_flush(self->socket, now);
+
+  Uint8 packet[NET_PACKET_MAX];
+  NetAddress from;
+  size_t length;
+  while ((length = NetSocket_receive(self->socket, &from, packet,
+                                     sizeof(packet))) > 0) {
+    if (!NetplaySession_read(self, from, packet, length, now)) {
+      self->stats.packets_rejected++;
+      continue;
+    }
+    self->stats.packets_received++;
+    self->stats.bytes_received += length;
+  }
+
+  for (size_t slot = 0; slot < self->players; slot++) {
+    if (slot == self->local ||
+        now - self->peers[slot].last_heard < NETPLAY_TIMEOUT_NS)
+      continue;
+    if (!self->disconnected)
+      SDL_Log("Player %zu stopped answering", slot);
+    self->disconnected = true;
+  }
+  return !self->disconnected;
+}
+
+/*
+ * SIMULATING
+ */
+
+bool NetplaySession_takeRollback(NetplaySession *self, Uint32 *frame,
+                                 const Uint8 **snapshot) {
+  debugAssert(self != NULL, "self == NULL");
+  // Slot 0's world replaces ours once we have every input before it, and
+  // settles any wrong guesses along the way
+  if (NetplaySession_hasResync(self) &&
+      self->resync_frame <=
+          SDL_min(NetplaySession_getConfirmed(self), self->frame)) {
+    const Uint32 resync = self->resync_frame;
+    self->resync_through = resync + 1;
+    if (self->frame - resync >= NETPLAY_HISTORY / 2) {
+      SDL_Log("Player 0's world from frame %u came too late to use", resync);
+    } else {
+      if (resync + NETPLAY_SNAPSHOTS > self->frame + 1)
+        SDL_memcpy(NetplaySession_getSnapshot(self, resync), self->resync_data,
+                   self->snapshot_size);
+      // Checksums from there on are taken again as it's replayed
+      for (size_t i = 0; i < NETPLAY_CHECKSUMS; i++) {
+        if (self->checksums[i].frame != NETPLAY_NO_FRAME &&
+            self->checksums[i].frame >= resync)
+          self->checksums[i].frame = NETPLAY_NO_FRAME;
+      }
+      self->next_checksum = SDL_min(
+          self->next_checksum,
+          (resync + NETPLAY_CHECKSUM_INTERVAL - 1) / NETPLAY_CHECKSUM_INTERVAL *
+              NETPLAY_CHECKSUM_INTERVAL);
+      self->rollback = NETPLAY_NO_FRAME;
+      self->stats.resyncs++;
+      self->stats.rollbacks++;
+      self->stats.max_rollback =
+          SDL_max(self->stats.max_rollback, self->frame - resync);
+      SDL_Log("Took player 0's world from frame %u", resync);
+      *frame = resync;
+      *snapshot = self->resync_data;
+      return true;
+    }
+  }
+
+  if (self->rollback == NETPLAY_NO_FRAME)
+    return false;
+  *frame = self->rollback;
+  *snapshot = NetplaySession_getSnapshot(self, self->rollback);
+  self->stats.rollbacks++;
+  self->stats.max_rollback =
+      SDL_max(self->stats.max_rollback, self->frame - self->rollback);
+  self->rollback = NETPLAY_NO_FRAME;
+  return true;
+}
+
+void NetplaySession_addResimulation(NetplaySession *self, Uint32 frames,
+                                    Uint64 ns) {
+  self->stats.resimulated_frames += frames;
+  self->stats.resimulate_ns += ns;
+  self->stats.max_resimulate_ns = SDL_max(self->stats.max_resimulate_ns, ns);
+}
+
+bool NetplaySession_canAdvance(NetplaySession *self) {
+  debugAssert(self != NULL, "self == NULL");
+  // Input delay puts our own confirmed frames ahead of the current one
+  if (self->frame + 1 >
+      NetplaySession_getConfirmed(self) + NETPLAY_MAX_ROLLBACK) {
+    self->stats.stalls++;
+    return false;
+  }
+
+  // Both sides guess, so the difference is split between them
+  const Uint64 now = NetplaySession_now(self);
+  float drift = 0.0f;
+  for (size_t slot = 0; slot < self->players; slot++) {
+    if (slot == self->local)
+      continue;
+    NetplayPeer *peer = &self->peers[slot];
+    const float ahead =
+        (NetplaySession_getAdvantage(self, peer, now) - peer->advantage) /
+        2.0f;
+    peer->drift += (ahead - peer->drift) / NETPLAY_DRIFT_TICKS;
+    drift = SDL_max(drift, peer->drift);
+  }
+  if (drift <= NETPLAY_MAX_DRIFT)
+    return true;
+
+  // Waiting brings us a tick closer to everyone straight away, the average
+  // would take a while to notice
+  for (size_t slot = 0; slot < self->players; slot++) {
+    self->peers[slot].drift -= 1.0f;
+  }
+  self->stats.waits++;
+  return false;
+}
+
+void NetplaySession_addLocalInput(NetplaySession *self,
+                                  const InputState *input) {
+  debugAssert(self != NULL, "self == NULL");
+  const Uint32 frame = self->frame + self->input_delay;
+  debugAssert(frame == self->confirmed[self->local],
+              "input for frame %u when %u is next", frame,
+              self->confirmed[self->local]);
+  ReplayFrame quantized = ReplayFrame_fromState(input);
+  quantized.buttons &= NETPLAY_BUTTON_MASK;
+  self->inputs[self->local][frame % NETPLAY_HISTORY] = quantized;
+  self->confirmed[self->local] = frame + 1;
+}
+
+void NetplaySession_getInputs(NetplaySession *self, Uint32 frame,
+                              InputState *inputs) {
+  debugAssert(self != NULL, "self == NULL");
+  for (size_t slot = 0; slot < self->players; slot++) {
+    ReplayFrame *held = &self->inputs[slot][frame % NETPLAY_HISTORY];
+    const Uint32 confirmed = self->confirmed[slot];
+    if (frame >= confirmed) {
+      // Whatever they last held, kept to check against the real one
+      *held = confirmed > 0
+                  ? self->inputs[slot][(confirmed - 1) % NETPLAY_HISTORY]
+                  : (ReplayFrame){0};
+    }
+    inputs[slot] = ReplayFrame_toState(held);
+  }
+}
+
+/*
+ * SENDING
+ */
+
+static void NetplaySession_writeHeader(const NetplaySession *self,
+                                       BitWriter *writer, Uint32 kind,
+                                       Uint32 frame) {
+  BitWriter_write(writer, NETPLAY_MAGIC, 8);
+  BitWriter_write(writer, NETPLAY_VERSION, 4);
+  BitWriter_write(writer, kind, 4);
+  BitWriter_write(writer, (Uint32)self->local, 4);
+  BitWriter_write(writer, frame, 32);
+}
+
+static void NetplaySession_sendInputs(NetplaySession *self, size_t slot,
+                                      Uint64 now) {
+  NetplayPeer *peer = &self->peers[slot];
+  Uint8 packet[NET_PACKET_MAX];
+  BitWriter writer = BitWriter_create(packet, sizeof(packet));
+  NetplaySession_writeHeader(self, &writer, NETPLAY_PACKET_INPUT, self->frame);
+  BitWriter_writeSigned(&writer, NetplaySession_getAdvantage(self, peer, now));
+  BitWriter_writeSigned(&writer, (Sint32)(self->confirmed[slot] - self->frame));
+
+  // Everything they haven't acknowledged, against the input they have
+  const ReplayFrame *inputs = self->inputs[self->local];
+  const Uint32 first = peer->acked;
+  const Uint32 count = SDL_min(self->confirmed[self->local] - first,
+                               (Uint32)NETPLAY_MAX_REDUNDANT);
+  BitWriter_writeSigned(&writer, (Sint32)(first - self->frame));
+  BitWriter_writeVarint(&writer, count);
+  ReplayFrame previous =
+      first > 0 ? inputs[(first - 1) % NETPLAY_HISTORY] : (ReplayFrame){0};
+  for (Uint32 i = 0; i < count; i++) {
+    const ReplayFrame *input = &inputs[(first + i) % NETPLAY_HISTORY];
+    NetplayInput_write(&writer, &previous, input);
+    previous = *input;
+  }
+
+  BitWriter_write(&writer, self->latest.frame != NETPLAY_NO_FRAME, 1);
+  if (self->latest.frame != NETPLAY_NO_FRAME) {
+    BitWriter_writeVarint(&writer, self->frame - self->latest.frame);
+    BitWriter_write(&writer, self->latest.hash, 32);
+  }
+  BitWriter_write(&writer, self->resync_through > 0, 1);
+  if (self->resync_through > 0)
+    BitWriter_write(&writer, self->resync_through, 32);
+  // Every input changing every field still leaves room
+  debugAssert(!writer.overflow, "input packet overflowed");
+
+  const size_t size = BitWriter_getSize(&writer);
+  NetSocket_send(self->socket, peer->address, packet, size, now);
+  self->stats.packets_sent++;
+  self->stats.bytes_sent += size;
+  self->stats.inputs_sent += count;
+}
+
+// The pieces go round until they say they have the lot
+static void NetplaySession_sendResync(NetplaySession *self, size_t slot,
+                                      Uint64 now) {
+  NetplayPeer *peer = &self->peers[slot];
+  if (peer->resync_frame == NETPLAY_NO_FRAME) {
+    // We have every input before it, so it's final here. They wait until
+    // they have them too before taking it. Copied since the ring moves on
+    // while the pieces go out
+    const Uint32 frame =
+        SDL_min(NetplaySession_getConfirmed(self), self->frame);
+    if (peer->resync_data == NULL)
+      peer->resync_data = allocPtr(self->allocator, 1, self->snapshot_size);
+    SDL_memcpy(peer->resync_data, NetplaySession_getSnapshot(self, frame),
+               self->snapshot_size);
+    peer->resync_frame = frame;
+    SDL_Log("Sending player %zu our world from frame %u", slot, frame);
+  }
+
+  const size_t pieces = NETPLAY_PIECES(self->snapshot_size);
+  for (size_t sent = 0; sent < NETPLAY_PIECES_PER_TICK && sent < pieces;
+       sent++) {
+    const Uint32 piece = peer->resync_piece;
+    peer->resync_piece = (piece + 1) % pieces;
+    const size_t offset = (size_t)piece * NETPLAY_PIECE_SIZE;
+    const size_t length =
+        SDL_min(NETPLAY_PIECE_SIZE, self->snapshot_size - offset);
+
+    Uint8 packet[NET_PACKET_MAX];
+    BitWriter writer = BitWriter_create(packet, sizeof(packet));
+    NetplaySession_writeHeader(self, &writer, NETPLAY_PACKET_RESYNC,
+                               peer->resync_frame);
+    BitWriter_writeVarint(&writer, (Uint32)self->snapshot_size);
+    BitWriter_writeVarint(&writer, piece);
+    BitWriter_writeBytes(&writer, &peer->resync_data[offset], length);
+    debugAssert(!writer.overflow, "resync packet overflowed");
+
+    const size_t size = BitWriter_getSize(&writer);
+    NetSocket_send(self->socket, peer->address, packet, size, now);
+    self->stats.packets_sent++;
+    self->stats.bytes_sent += size;
+    self->stats.resync_bytes += length;
+  }
+}
+
+void NetplaySession_send(NetplaySession *self) {
+  debugAssert(self != NULL, "self == NULL");
+  const Uint64 now = NetplaySession_now(self);
+  for (size_t slot = 0; slot < self->players; slot++) {
+    if (slot == self->local)
+      continue;
+    NetplaySession_sendInputs(self, slot, now);
+    if (self->peers[slot].resync_sending)
+      NetplaySession_sendResync(self, slot, now);
+  }
+  for (; self->sent < self->confirmed[self->local]; self->sent++) {
+    self->sent_at[self->sent % NETPLAY_HISTORY] = now;
+  }
+  NetSocket_flush(self->socket, now);
+}
+
+void NetplaySession_advance(NetplaySession *self) {
+  debugAssert(self != NULL, "self == NULL");
+  self->frame++;
+  NetplaySession_takeChecksums(self);
+  NetplaySession_send(self);
+}
+
+void NetplaySession_logStats(const NetplaySession *self, double seconds) {
+  const NetplayStats *stats = &self->stats;
+  const double per_second = seconds > 0.0 ? 1.0 / seconds : 0.0;
+  const double packets = stats->packets_sent > 0 ? stats->packets_sent : 1;
+  const double frames =
+      stats->resimulated_frames > 0 ? stats->resimulated_frames : 1;
+  Uint64 rtt_ns = 0;
+  for (size_t slot = 0; slot < self->players; slot++) {
+    rtt_ns = SDL_max(rtt_ns, self->peers[slot].rtt_ns);
+  }
+
+  SDL_Log("Netplay as player %zu of %zu, %u frames with %u of input delay",
+          self->local, self->players, self->frame, self->input_delay);
+  SDL_Log("  sent %lu packets, %.2f kbit/s (%.2f with UDP/IP headers), "
+          "%.1f bytes and %.1f inputs a packet",
+          (unsigned long)stats->packets_sent,
+          stats->bytes_sent * 8 / 1000.0 * per_second,
+          (stats->bytes_sent + stats->packets_sent * NET_HEADER_SIZE) * 8 /
+              1000.0 * per_second,
+          stats->bytes_sent / packets, stats->inputs_sent / packets);
+  SDL_Log("  received %lu packets (%lu rejected), %.2f kbit/s, %lu lost on "
+          "the way out, worst round trip %.1fms",
+          (unsigned long)stats->packets_received,
+          (unsigned long)stats->packets_rejected,
+          stats->bytes_received * 8 / 1000.0 * per_second,
+          (unsigned long)self->socket->stats.packets_dropped,
+          rtt_ns / (double)SDL_NS_PER_MS);
+  SDL_Log("  %lu mispredictions, %lu rollbacks replaying %lu frames, "
+          "deepest %u",
+          (unsigned long)stats->mispredictions, (unsigned long)stats->rollbacks,
+          (unsigned long)stats->resimulated_frames, stats->max_rollback);
+  SDL_Log("  replaying took %.2fus a frame, %.2fus for the worst rollback",
+          stats->resimulate_ns / (double)SDL_NS_PER_US / frames,
+          stats->max_resimulate_ns / (double)SDL_NS_PER_US);
+  SDL_Log("  %lu ticks stalled for input, %lu given up to stay in step",
+          (unsigned long)stats->stalls, (unsigned long)stats->waits);
+  SDL_Log("  %lu checksums compared, %lu disagreed, %lu resyncs of %lu bytes",
+          (unsigned long)stats->checksums, (unsigned long)stats->desyncs,
+          (unsigned long)stats->resyncs, (unsigned long)stats->resync_bytes);
+}
@@ -0,0 +1,203 @@
+/*
+    UDP Socket
+    Copyright (C) 2025  Ashton Warner
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "debug/debug.h"
+#include "net/socket.h"
+
+bool NetAddress_parse(const char *text, NetAddress *out) {
+  debugAssert(text != NULL, "text == NULL");
+  const char *colon = SDL_strrchr(text, ':');
+  char host[256];
+  if (colon == NULL || colon == text ||
+      (size_t)(colon - text) >= sizeof(host)) {
+    SDL_Log("%s isn't HOST:PORT", text);
+    return false;
+  }
+  SDL_memcpy(host, text, colon - text);
+  host[colon - text] = '\0';
+
+  char *end;
+  const unsigned long port = SDL_strtoul(colon + 1, &end, 10);
+  if (*end != '\0' || end == colon + 1 || port > 0xFFFF) {
+    SDL_Log("%s isn't a port", colon + 1);
+    return false;
+  }
+
+  const struct addrinfo hints = {
+      .ai_family = AF_INET,
+      .ai_socktype = SOCK_DGRAM,
+  };
+  struct addrinfo *found = NULL;
+  const int failed = getaddrinfo(host, NULL, &hints, &found);
+  if (failed != 0) {
+    SDL_Log("Couldn't find %s: %s", host, gai_strerror(failed));
+    return false;
+  }
+  const struct sockaddr_in *address = (struct sockaddr_in *)found->ai_addr;
+  *out = (NetAddress){
+      .host = ntohl(address->sin_addr.s_addr),
+      .port = (Uint16)port,
+  };
+  freeaddrinfo(found);
+  return true;
+}
+
+static struct sockaddr_in NetAddress_toSockaddr(NetAddress address) {
+  return (struct sockaddr_in){
+      .sin_family = AF_INET,
+      .sin_port = htons(address.port),
+      .sin_addr = {.s_addr = htonl(address.host)},
+  };
+}
+
+NetSocket *NetSocket_open(Allocator *allocator, Uint16 port) {
+  const int fd = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK, 0);
+  if (fd < 0) {
+    SDL_Log("Couldn't create a UDP socket: %s", strerror(errno));
+    return NULL;
+  }
+
+  struct sockaddr_in bound = NetAddress_toSockaddr((NetAddress){
+      .host = INADDR_ANY,
+      .port = port,
+  });
+  socklen_t bound_size = sizeof(bound);
+  if (bind(fd, (struct sockaddr *)&bound, sizeof(bound)) != 0 ||
+      getsockname(fd, (struct sockaddr *)&bound, &bound_size) != 0) {
+    SDL_Log("Couldn't bind UDP port %u: %s", port, strerror(errno));
+    close(fd);
+    return NULL;
+  }
+
+  NetSocket *self = allocPtr(allocator, sizeof(NetSocket), 1);
+  *self = (NetSocket){
+      .allocator = allocator,
+      .fd = fd,
+      .address =
+          {
+              .host = ntohl(bound.sin_addr.s_addr),
+              .port = ntohs(bound.sin_port),
+          },
+      .conditions = {0},
+      .random = 0,
+      .held = Stack_create(NetHeldPacket, allocator),
+      .stats = {0},
+  };
+  return self;
+}
+
+void NetSocket_close(NetSocket *self) {
+  if (self == NULL)
+    return;
+  close(self->fd);
+  Stack_destroy(self->held);
+  freePtr(self->allocator, self);
+}
+
+void NetSocket_setConditions(NetSocket *self, NetConditions conditions,
+                             Uint64 seed) {
+  debugAssert(self != NULL, "self == NULL");
+  self->conditions = conditions;
+  self->random = seed;
+}
+
+// Straight to the kernel, which may still refuse it
+static void NetSocket_sendNow(NetSocket *self, NetAddress to,
+                              const Uint8 *data, size_t length) {
+  const struct sockaddr_in address = NetAddress_toSockaddr(to);
+  if (sendto(self->fd, data, length, 0, (const struct sockaddr *)&address,
+             sizeof(address)) < 0) {
+    // A full send buffer is just more loss
+    self->stats.send_errors += errno != EAGAIN && errno != EWOULDBLOCK;
+    self->stats.packets_dropped++;
+    return;
+  }
+  self->stats.packets_sent++;
+  self->stats.bytes_sent += length;
+}
+
+void NetSocket_send(NetSocket *self, NetAddress to, const Uint8 *data,
+                    size_t length, Uint64 now) {
+  debugAssert(self != NULL, "self == NULL");
+  debugAssert(length <= NET_PACKET_MAX, "%zu byte packet", length);
+
+  const NetConditions *conditions = &self->conditions;
+  if (conditions->loss > 0.0f &&
+      SDL_randf_r(&self->random) < conditions->loss) {
+    self->stats.packets_dropped++;
+    return;
+  }
+  if (conditions->latency_ns == 0 && conditions->jitter_ns == 0) {
+    NetSocket_sendNow(self, to, data, length);
+    return;
+  }
+
+  Uint64 due = now + conditions->latency_ns;
+  if (conditions->jitter_ns > 0) {
+    due += (Uint64)(SDL_randf_r(&self->random) * conditions->jitter_ns);
+  }
+  NetHeldPacket packet = {
+      .due = due,
+      .to = to,
+      .length = length,
+  };
+  SDL_memcpy(packet.data, data, length);
+  Stack_push(self->held, packet);
+}
+
+void NetSocket_flush(NetSocket *self, Uint64 now) {
+  debugAssert(self != NULL, "self == NULL");
+  for (size_t i = 0; i < self->held.len;) {
+    NetHeldPacket *packet = &self->held.data.ptr[i];
+    if (packet->due > now) {
+      i++;
+      continue;
+    }
+    NetSocket_sendNow(self, packet->to, packet->data, packet->length);
+    // Order doesn't matter, the last one fills the gap
+    *packet = self->held.data.ptr[--self->held.len];
+  }
+}
+
+size_t NetSocket_receive(NetSocket *self, NetAddress *from, Uint8 *buffer,
+                         size_t capacity) {
+  debugAssert(self != NULL, "self == NULL");
+  struct sockaddr_in address;
+  socklen_t address_size = sizeof(address);
+  // Datagrams too big for the buffer are cut short, and then fail to parse
+  const ssize_t length = recvfrom(self->fd, buffer, capacity, 0,
+                                  (struct sockaddr *)&address, &address_size);
+  if (length <= 0)
+    return 0;
+
+  *from = (NetAddress){
+      .host = ntohl(address.sin_addr.s_addr),
+      .port = ntohs(address.sin_port),
+  };
+  self->stats.packets_received++;
+  self->stats.bytes_received += (Uint64)length;
+  return (size_t)length;
+}
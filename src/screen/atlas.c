@@ -0,0 +1,224 @@
+/*
+    Texture Atlas Builder
+    Copyright (C) 2025  Ashton Warner
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "screen/atlas.h"
+#include "debug/debug.h"
+#include <stdlib.h>
+
+TextureAtlas TextureAtlas_create(Allocator *allocator, int page_size) {
+  return (TextureAtlas){
+      .allocator = allocator,
+      .page_size = page_size,
+      // Keeps linear filtering from bleeding neighbours into each other
+      .padding = 1,
+      .built = false,
+      .images = Stack_create(SDL_Surface *, allocator),
+      .regions = Stack_create(AtlasRegion, allocator),
+      .pages = Stack_create(AtlasPage, allocator),
+  };
+}
+
+void TextureAtlas_destroy(TextureAtlas *self) {
+  debugAssert(self != NULL, "self == NULL");
+
+  for (size_t i = 0; i < self->images.len; i++) {
+    if (self->images.data.ptr[i] != NULL)
+      SDL_DestroySurface(self->images.data.ptr[i]);
+  }
+  for (size_t i = 0; i < self->pages.len; i++) {
+    AtlasPage *page = &self->pages.data.ptr[i];
+    if (page->surface != NULL)
+      SDL_DestroySurface(page->surface);
+    if (page->texture != NULL)
+      SDL_DestroyTexture(page->texture);
+  }
+
+  Stack_destroy(self->images);
+  Stack_destroy(self->regions);
+  Stack_destroy(self->pages);
+}
+
+AtlasRegionId TextureAtlas_addImage(TextureAtlas *self, const char *path) {
+  SDL_Surface *surface = SDL_LoadBMP(path);
+  if (surface == NULL) {
+    SDL_Log("Failed to load image '%s': %s", path, SDL_GetError());
+    return ATLAS_REGION_INVALID;
+  }
+  return TextureAtlas_addSurface(self, surface);
+}
+
+AtlasRegionId TextureAtlas_addSurface(TextureAtlas *self,
+                                      SDL_Surface *surface) {
+  debugAssert(self != NULL, "self == NULL");
+  debugAssert(!self->built, "images can't be added after building");
+
+  const int padded_size = self->page_size - self->padding * 2;
+  if (surface == NULL || surface->w > padded_size ||
+      surface->h > padded_size) {
+    SDL_Log("Image does not fit in a %dx%d atlas page", self->page_size,
+            self->page_size);
+    if (surface != NULL)
+      SDL_DestroySurface(surface);
+    return ATLAS_REGION_INVALID;
+  }
+
+  AtlasRegion region = {
+      .page = 0,
+      .texture = NULL,
+      .texture_id = RENDER_TEXTURE_NONE,
+      .rect = {0, 0, surface->w, surface->h},
+      .uv = {0, 0, 0, 0},
+  };
+  Stack_push(self->regions, region);
+  Stack_push(self->images, surface);
+  return (AtlasRegionId)(self->regions.len - 1);
+}
+
+// What the packing order is sorted by, so the comparator needs no atlas
+typedef struct AtlasOrder {
+  size_t index;
+  int height;
+} AtlasOrder;
+
+static int AtlasOrder_compareHeight(const void *a, const void *b) {
+  return ((const AtlasOrder *)b)->height - ((const AtlasOrder *)a)->height;
+}
+
+static AtlasPage *TextureAtlas_newPage(TextureAtlas *self) {
+  AtlasPage page = {
+      .surface = SDL_CreateSurface(self->page_size, self->page_size,
+                                   SDL_PIXELFORMAT_RGBA32),
+      .texture = NULL,
+      .texture_id = RENDER_TEXTURE_NONE,
+  };
+  if (page.surface == NULL) {
+    SDL_Log("Failed to create atlas page: %s", SDL_GetError());
+    return NULL;
+  }
+  Stack_push(self->pages, page);
+  return Stack_peek(self->pages);
+}
+
+bool TextureAtlas_build(TextureAtlas *self, SDL_Renderer *renderer,
+                        RenderList *render_list) {
+  debugAssert(self != NULL, "self == NULL");
+  debugAssert(!self->built, "atlas was already built");
+  self->built = true;
+
+  const size_t count = self->images.len;
+  if (count == 0)
+    return true;
+
+  // Shelf packing works best when the tallest images go first
+  AtlasOrder *order = allocPtr(self->allocator, sizeof(AtlasOrder), count);
+  for (size_t i = 0; i < count; i++) {
+    order[i] = (AtlasOrder){
+        .index = i,
+        .height = self->regions.data.ptr[i].rect.h,
+    };
+  }
+  qsort(order, count, sizeof(AtlasOrder), AtlasOrder_compareHeight);
+
+  AtlasPage *page = TextureAtlas_newPage(self);
+  int shelf_x = self->padding;
+  int shelf_y = self->padding;
+  int shelf_height = 0;
+  bool success = page != NULL;
+
+  for (size_t i = 0; i < count && success; i++) {
+    AtlasRegion *region = &self->regions.data.ptr[order[i].index];
+    SDL_Surface *image = self->images.data.ptr[order[i].index];
+    const int w = region->rect.w + self->padding;
+    const int h = region->rect.h + self->padding;
+
+    // Start a new shelf, then a new page when the shelf doesn't fit either
+    if (shelf_x + w > self->page_size) {
+      shelf_x = self->padding;
+      shelf_y += shelf_height;
+      shelf_height = 0;
+    }
+    if (shelf_y + h > self->page_size) {
+      page = TextureAtlas_newPage(self);
+      if (page == NULL) {
+        success = false;
+        break;
+      }
+      shelf_x = self->padding;
+      shelf_y = self->padding;
+      shelf_height = 0;
+    }
+
+    region->page = self->pages.len - 1;
+    region->rect.x = shelf_x;
+    region->rect.y = shelf_y;
+    region->uv = (SDL_FRect){
+        .x = (float)region->rect.x / self->page_size,
+        .y = (float)region->rect.y / self->page_size,
+        .w = (float)region->rect.w / self->page_size,
+        .h = (float)region->rect.h / self->page_size,
+    };
+
+    // Copy the pixels as they are instead of blending onto the page
+    SDL_SetSurfaceBlendMode(image, SDL_BLENDMODE_NONE);
+    SDL_BlitSurface(image, NULL, page->surface, &region->rect);
+
+    shelf_x += w;
+    if (h > shelf_height)
+      shelf_height = h;
+  }
+  freePtr(self->allocator, order);
+
+  // Packed images are no longer needed
+  for (size_t i = 0; i < count; i++) {
+    SDL_DestroySurface(self->images.data.ptr[i]);
+    self->images.data.ptr[i] = NULL;
+  }
+  Stack_clear(self->images);
+
+  for (size_t i = 0; i < self->pages.len && success; i++) {
+    AtlasPage *built = &self->pages.data.ptr[i];
+    built->texture = SDL_CreateTextureFromSurface(renderer, built->surface);
+    if (built->texture == NULL) {
+      SDL_Log("Failed to create atlas texture: %s", SDL_GetError());
+      success = false;
+      break;
+    }
+    SDL_SetTextureBlendMode(built->texture, SDL_BLENDMODE_BLEND);
+    built->texture_id = RenderList_addTexture(render_list, built->texture);
+
+    SDL_DestroySurface(built->surface);
+    built->surface = NULL;
+  }
+
+  for (size_t i = 0; i < self->regions.len; i++) {
+    AtlasRegion *region = &self->regions.data.ptr[i];
+    region->texture = self->pages.data.ptr[region->page].texture;
+    region->texture_id = self->pages.data.ptr[region->page].texture_id;
+  }
+
+  trace("Packed %zu images into %zu atlas pages", count, self->pages.len);
+  return success;
+}
+
+const AtlasRegion *TextureAtlas_getRegion(const TextureAtlas *self,
+                                          AtlasRegionId id) {
+  debugAssert(self != NULL, "self == NULL");
+  if (id < 0 || (size_t)id >= self->regions.len)
+    return NULL;
+  return &self->regions.data.ptr[id];
+}
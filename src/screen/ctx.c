@@ -20,9 +20,11 @@
 #include "debug/debug.h"
 #include <SDL3/SDL_rect.h>
 
-RenderContext RenderContext_create(SDL_Renderer *renderer) {
+RenderContext RenderContext_create(SDL_Renderer *renderer,
+                                   RenderShard *commands) {
   return (RenderContext){
       .renderer = renderer,
+      .commands = commands,
       .transforms = Stack_create(SDL_FPoint, &std_allocator),
   };
 }
@@ -33,6 +35,35 @@ SDL_FPoint RenderContext_getTransform(RenderContext *self) {
   SDL_FPoint *ret = Stack_peek(self->transforms);
   return *ret;
 }
+void RenderContext_fillRect(RenderContext *self, Uint8 layer,
+                            const SDL_FRect *rect, SDL_Color color) {
+  if (self->commands != NULL) {
+    RenderShard_fillRect(self->commands, layer, rect, color);
+    return;
+  }
+  SDL_SetRenderDrawColor(self->renderer, color.r, color.g, color.b, color.a);
+  SDL_RenderFillRect(self->renderer, rect);
+}
+void RenderContext_drawSprite(RenderContext *self, Uint8 layer,
+                              SDL_Texture *texture, RenderTextureId texture_id,
+                              const SDL_FRect *dst, const SDL_FRect *uv,
+                              SDL_FColor tint) {
+  if (self->commands != NULL) {
+    RenderShard_sprite(self->commands, layer, texture_id, dst, uv, tint);
+    return;
+  }
+
+  const SDL_Vertex vertices[4] = {
+      {{dst->x, dst->y}, tint, {uv->x, uv->y}},
+      {{dst->x + dst->w, dst->y}, tint, {uv->x + uv->w, uv->y}},
+      {{dst->x + dst->w, dst->y + dst->h},
+       tint,
+       {uv->x + uv->w, uv->y + uv->h}},
+      {{dst->x, dst->y + dst->h}, tint, {uv->x, uv->y + uv->h}},
+  };
+  const int indices[6] = {0, 1, 2, 0, 2, 3};
+  SDL_RenderGeometry(self->renderer, texture, vertices, 4, indices, 6);
+}
 void RenderContext_destroy(RenderContext *self) {
   debugAssert(self != NULL, "self == NULL");
   Stack_destroy(self->transforms);
@@ -0,0 +1,124 @@
+/*
+    Cached Render Layer Implementation
+    Copyright (C) 2025  Ashton Warner
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "screen/layer.h"
+#include "debug/debug.h"
+
+CachedLayer CachedLayer_create(Allocator *allocator, Object2D *root,
+                               Uint8 layer) {
+  return (CachedLayer){
+      .camera =
+          {
+              .view = {0, 0, 0, 0},
+              .target_texture = NULL,
+          },
+      .commands = RenderList_create(allocator, 1),
+      .texture_id = RENDER_TEXTURE_NONE,
+      .layer = layer,
+      .root = root,
+      .dirty = true,
+      .redraws = 0,
+  };
+}
+
+void CachedLayer_destroy(CachedLayer *self) {
+  debugAssert(self != NULL, "self == NULL");
+  if (self->camera.target_texture != NULL) {
+    SDL_DestroyTexture(self->camera.target_texture);
+    self->camera.target_texture = NULL;
+  }
+  RenderList_destroy(&self->commands);
+}
+
+void CachedLayer_invalidate(CachedLayer *self) { self->dirty = true; }
+
+// (Re)create the target when the viewport changes size
+static bool CachedLayer_resize(CachedLayer *self, SDL_Renderer *renderer,
+                               RenderList *frame_list, SDL_Rect viewport,
+                               float scale_x, float scale_y) {
+  if (self->camera.target_texture != NULL &&
+      self->camera.view.w == viewport.w && self->camera.view.h == viewport.h)
+    return true;
+
+  if (self->camera.target_texture != NULL) {
+    SDL_DestroyTexture(self->camera.target_texture);
+  }
+  self->camera.view = (SDL_FRect){0, 0, viewport.w, viewport.h};
+  self->camera.target_texture = SDL_CreateTexture(
+      renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET,
+      viewport.w * scale_x, viewport.h * scale_y);
+  if (self->camera.target_texture == NULL) {
+    SDL_Log("Failed to create layer texture: %s", SDL_GetError());
+    return false;
+  }
+  SDL_SetTextureBlendMode(self->camera.target_texture, SDL_BLENDMODE_BLEND);
+
+  if (self->texture_id == RENDER_TEXTURE_NONE) {
+    self->texture_id =
+        RenderList_addTexture(frame_list, self->camera.target_texture);
+  } else {
+    RenderList_setTexture(frame_list, self->texture_id,
+                          self->camera.target_texture);
+  }
+  self->dirty = true;
+  return true;
+}
+
+void CachedLayer_update(CachedLayer *self, SDL_Renderer *renderer,
+                        RenderList *frame_list, SDL_FPoint origin) {
+  debugAssert(self != NULL, "self == NULL");
+
+  SDL_Rect viewport;
+  float scale_x, scale_y;
+  SDL_GetRenderViewport(renderer, &viewport);
+  SDL_GetRenderScale(renderer, &scale_x, &scale_y);
+
+  if (!CachedLayer_resize(self, renderer, frame_list, viewport, scale_x,
+                          scale_y))
+    return;
+
+  if (!self->dirty && !Object2D_isDirty(self->root))
+    return;
+  // Cleared before recording, so a tick that lands while drawing isn't lost
+  Object2D_clearDirty(self->root);
+
+  // Record with the frame's texture ids so cached sprites still resolve
+  RenderList_inheritTextures(&self->commands, frame_list);
+  RenderList_clear(&self->commands);
+  RenderList_record(&self->commands, NULL, renderer, &self->root, 1, origin);
+  RenderList_sort(&self->commands);
+
+  // Every render target keeps its own scale, so match the screen's
+  SDL_Texture *previous = SDL_GetRenderTarget(renderer);
+  SDL_SetRenderTarget(renderer, self->camera.target_texture);
+  SDL_SetRenderScale(renderer, scale_x, scale_y);
+  SDL_SetRenderDrawColor(renderer, 0, 0, 0, 0);
+  SDL_RenderClear(renderer);
+  RenderList_submit(&self->commands, renderer);
+  SDL_SetRenderTarget(renderer, previous);
+
+  self->dirty = false;
+  self->redraws++;
+}
+
+void CachedLayer_composite(const CachedLayer *self, RenderShard *shard) {
+  if (self->camera.target_texture == NULL)
+    return;
+  RenderShard_texture(shard, self->layer, self->texture_id, NULL,
+                      &self->camera.view);
+}
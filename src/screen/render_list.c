@@ -0,0 +1,477 @@
+/*
+    Sorted Render Command List Implementation
+    Copyright (C) 2025  Ashton Warner
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "screen/render_list.h"
+#include "debug/debug.h"
+#include "en/obj.h"
+#include "screen/ctx.h"
+#include "util/safe.h"
+#include <memory.h>
+
+static RenderShard RenderShard_create(Allocator *allocator) {
+  return (RenderShard){
+      .commands = Stack_create(RenderCommand, allocator),
+      .rects = Stack_create(SDL_FRect, allocator),
+      .vertices = Stack_create(SDL_Vertex, allocator),
+      .indices = Stack_create(int, allocator),
+      .geometry = Stack_create(RenderGeometry, allocator),
+  };
+}
+
+static void RenderShard_clear(RenderShard *self) {
+  Stack_clear(self->commands);
+  Stack_clear(self->rects);
+  Stack_clear(self->vertices);
+  Stack_clear(self->indices);
+  Stack_clear(self->geometry);
+}
+
+static void RenderShard_destroy(RenderShard *self) {
+  Stack_destroy(self->commands);
+  Stack_destroy(self->rects);
+  Stack_destroy(self->vertices);
+  Stack_destroy(self->indices);
+  Stack_destroy(self->geometry);
+}
+
+RenderList RenderList_create(Allocator *allocator, size_t shard_count) {
+  debugAssert(shard_count > 0, "shard_count == 0");
+
+  RenderList self = {
+      .allocator = allocator,
+      .shards = allocSlice(RenderShard, allocator, shard_count),
+      .sorted = Stack_create(RenderCommand, allocator),
+      .scratch = Stack_create(RenderCommand, allocator),
+      .textures = Stack_create(SDL_Texture *, allocator),
+      .batch_rects = Stack_create(SDL_FRect, allocator),
+      .batch_vertices = Stack_create(SDL_Vertex, allocator),
+      .batch_indices = Stack_create(int, allocator),
+      .stats = {0},
+  };
+  forArray(self.shards, shard) { *shard = RenderShard_create(allocator); }
+
+  // Texture id 0 means "no texture"
+  Stack_push(self.textures, NULL);
+  return self;
+}
+
+void RenderList_destroy(RenderList *self) {
+  debugAssert(self != NULL, "self == NULL");
+  forArray(self->shards, shard) { RenderShard_destroy(shard); }
+  freeSlice(self->allocator, self->shards);
+
+  Stack_destroy(self->sorted);
+  Stack_destroy(self->scratch);
+  Stack_destroy(self->textures);
+  Stack_destroy(self->batch_rects);
+  Stack_destroy(self->batch_vertices);
+  Stack_destroy(self->batch_indices);
+}
+
+RenderTextureId RenderList_addTexture(RenderList *self, SDL_Texture *texture) {
+  debugAssert(self != NULL, "self == NULL");
+  debugAssert(self->textures.len <= RENDER_TEXTURE_MAX,
+              "too many textures registered");
+
+  for (size_t i = 1; i < self->textures.len; i++) {
+    if (self->textures.data.ptr[i] == texture)
+      return (RenderTextureId)i;
+  }
+  Stack_push(self->textures, texture);
+  return (RenderTextureId)(self->textures.len - 1);
+}
+
+void RenderList_setTexture(RenderList *self, RenderTextureId id,
+                           SDL_Texture *texture) {
+  debugAssert(id != RENDER_TEXTURE_NONE && id < self->textures.len,
+              "invalid texture id %d", id);
+  self->textures.data.ptr[id] = texture;
+}
+
+void RenderList_inheritTextures(RenderList *self, const RenderList *parent) {
+  Stack_reserve(self->textures, parent->textures.len);
+  for (size_t i = 0; i < parent->textures.len; i++) {
+    self->textures.data.ptr[i] = parent->textures.data.ptr[i];
+  }
+  self->textures.len = parent->textures.len;
+}
+
+SDL_Texture *RenderList_getTexture(const RenderList *self, RenderTextureId id) {
+  return id < self->textures.len ? self->textures.data.ptr[id] : NULL;
+}
+
+RenderShard *RenderList_getShard(RenderList *self, size_t index) {
+  debugAssert(index < self->shards.len, "index >= shards.len");
+  return &self->shards.ptr[index];
+}
+
+void RenderList_clear(RenderList *self) {
+  forArray(self->shards, shard) { RenderShard_clear(shard); }
+  Stack_clear(self->sorted);
+  self->stats = (RenderStats){0};
+}
+
+/*
+ * RECORDING
+ */
+
+static void RenderShard_push(RenderShard *self, Uint64 key, size_t geometry) {
+  RenderCommand command = {
+      .key = key,
+      .shard = 0,
+      .geometry = (Uint32)geometry,
+  };
+  Stack_push(self->commands, command);
+}
+
+void RenderShard_fillRect(RenderShard *self, Uint8 layer, const SDL_FRect *rect,
+                          SDL_Color color) {
+  const Uint64 key = RenderKey_create(
+      layer, RENDER_FILL_RECT, RENDER_TEXTURE_NONE, RenderColor_pack(color));
+  RenderShard_push(self, key, self->rects.len);
+  Stack_push(self->rects, *rect);
+}
+
+void RenderShard_geometry(RenderShard *self, Uint8 layer,
+                          RenderTextureId texture, const SDL_Vertex *vertices,
+                          int vertex_count, const int *indices,
+                          int index_count) {
+  RenderGeometry geometry = {
+      .first_vertex = self->vertices.len,
+      .vertex_count = vertex_count,
+      .first_index = self->indices.len,
+      .index_count = index_count > 0 ? index_count : vertex_count,
+  };
+
+  Stack_reserve(self->vertices, self->vertices.len + vertex_count);
+  memcpy(&self->vertices.data.ptr[self->vertices.len], vertices,
+         vertex_count * sizeof(SDL_Vertex));
+  self->vertices.len += vertex_count;
+
+  // Batches are always drawn indexed, so a plain triangle list gets indices
+  // of its own
+  Stack_reserve(self->indices, self->indices.len + geometry.index_count);
+  int *out = &self->indices.data.ptr[self->indices.len];
+  if (index_count > 0) {
+    memcpy(out, indices, index_count * sizeof(int));
+  } else {
+    for (int i = 0; i < vertex_count; i++) {
+      out[i] = i;
+    }
+  }
+  self->indices.len += geometry.index_count;
+
+  RenderShard_push(self, RenderKey_create(layer, RENDER_GEOMETRY, texture, 0),
+                   self->geometry.len);
+  Stack_push(self->geometry, geometry);
+}
+
+void RenderShard_sprite(RenderShard *self, Uint8 layer,
+                        RenderTextureId texture, const SDL_FRect *dst,
+                        const SDL_FRect *uv, SDL_FColor tint) {
+  RenderGeometry geometry = {
+      .first_vertex = self->vertices.len,
+      .vertex_count = 4,
+      .first_index = self->indices.len,
+      .index_count = 6,
+  };
+
+  // Written in place to skip building a temporary quad
+  Stack_reserve(self->vertices, self->vertices.len + 4);
+  SDL_Vertex *quad = &self->vertices.data.ptr[self->vertices.len];
+  quad[0] = (SDL_Vertex){{dst->x, dst->y}, tint, {uv->x, uv->y}};
+  quad[1] =
+      (SDL_Vertex){{dst->x + dst->w, dst->y}, tint, {uv->x + uv->w, uv->y}};
+  quad[2] = (SDL_Vertex){
+      {dst->x + dst->w, dst->y + dst->h}, tint, {uv->x + uv->w, uv->y + uv->h}};
+  quad[3] =
+      (SDL_Vertex){{dst->x, dst->y + dst->h}, tint, {uv->x, uv->y + uv->h}};
+  self->vertices.len += 4;
+
+  static const int QUAD_INDICES[6] = {0, 1, 2, 0, 2, 3};
+  Stack_reserve(self->indices, self->indices.len + 6);
+  memcpy(&self->indices.data.ptr[self->indices.len], QUAD_INDICES,
+         sizeof(QUAD_INDICES));
+  self->indices.len += 6;
+
+  RenderShard_push(self, RenderKey_create(layer, RENDER_GEOMETRY, texture, 0),
+                   self->geometry.len);
+  Stack_push(self->geometry, geometry);
+}
+
+void RenderShard_texture(RenderShard *self, Uint8 layer,
+                         RenderTextureId texture, const SDL_FRect *src,
+                         const SDL_FRect *dst) {
+  // A negative source width stands in for a NULL source rect
+  const SDL_FRect full = {0, 0, -1, -1};
+
+  RenderShard_push(self, RenderKey_create(layer, RENDER_TEXTURE, texture, 0),
+                   self->rects.len);
+  Stack_push(self->rects, src != NULL ? *src : full);
+  Stack_push(self->rects, *dst);
+}
+
+typedef struct RenderRecordJob {
+  RenderList *list;
+  SDL_Renderer *renderer;
+  struct Object2D **roots;
+  size_t root_count;
+  size_t job_count;
+  SDL_FPoint origin;
+} RenderRecordJob;
+
+static void RenderList_recordJob(RenderRecordJob *job, size_t index,
+                                 size_t worker) {
+  const size_t start = index * job->root_count / job->job_count;
+  const size_t end = (index + 1) * job->root_count / job->job_count;
+
+  RenderContext ctx =
+      RenderContext_create(job->renderer, &job->list->shards.ptr[index]);
+  Stack_push(ctx.transforms, job->origin);
+
+  for (size_t i = start; i < end; i++) {
+    Object2D *root = job->roots[i];
+    objrefcall(root, preRender, &ctx);
+    objrefcall(root, render, &ctx);
+    objrefcall(root, postRender, &ctx);
+  }
+
+  RenderContext_destroy(&ctx);
+}
+
+void RenderList_record(RenderList *self, JobPool *jobs, SDL_Renderer *renderer,
+                       struct Object2D **roots, size_t root_count,
+                       SDL_FPoint origin) {
+  debugAssert(self != NULL, "self == NULL");
+  if (root_count == 0)
+    return;
+
+  size_t job_count = self->shards.len;
+  if (jobs == NULL)
+    job_count = 1;
+  if (job_count > root_count)
+    job_count = root_count;
+
+  RenderRecordJob job = {
+      .list = self,
+      .renderer = renderer,
+      .roots = roots,
+      .root_count = root_count,
+      .job_count = job_count,
+      .origin = origin,
+  };
+
+  if (jobs == NULL) {
+    RenderList_recordJob(&job, 0, 0);
+    return;
+  }
+  JobPool_run(jobs, (JobFn)RenderList_recordJob, &job, job_count);
+}
+
+/*
+ * SORTING
+ */
+
+void RenderList_sort(RenderList *self) {
+  size_t total = 0;
+  forArray(self->shards, shard) { total += shard->commands.len; }
+  self->stats.commands = total;
+
+  Stack_clear(self->sorted);
+  if (total == 0)
+    return;
+
+  Stack_reserve(self->sorted, total);
+  Stack_reserve(self->scratch, total);
+
+  // Merge the shards in order so that equal keys keep their recording order
+  size_t shard_index = 0;
+  forArray(self->shards, shard) {
+    for (size_t i = 0; i < shard->commands.len; i++) {
+      RenderCommand command = shard->commands.data.ptr[i];
+      command.shard = shard_index;
+      self->sorted.data.ptr[self->sorted.len++] = command;
+    }
+    shard_index++;
+  }
+
+  // Count every byte of every key in one pass
+  size_t histogram[8][256] = {0};
+  for (size_t i = 0; i < total; i++) {
+    const Uint64 key = self->sorted.data.ptr[i].key;
+    for (int byte = 0; byte < 8; byte++) {
+      histogram[byte][(key >> (byte * 8)) & 0xFF]++;
+    }
+  }
+
+  RenderCommand *src = self->sorted.data.ptr;
+  RenderCommand *dst = self->scratch.data.ptr;
+
+  // Stable least significant digit radix sort
+  for (int byte = 0; byte < 8; byte++) {
+    size_t *counts = histogram[byte];
+
+    // Every key shares this byte. The pass would not move anything
+    const Uint64 first_digit = (src[0].key >> (byte * 8)) & 0xFF;
+    if (counts[first_digit] == total)
+      continue;
+
+    size_t offset = 0;
+    for (int digit = 0; digit < 256; digit++) {
+      const size_t count = counts[digit];
+      counts[digit] = offset;
+      offset += count;
+    }
+
+    for (size_t i = 0; i < total; i++) {
+      const Uint64 digit = (src[i].key >> (byte * 8)) & 0xFF;
+      dst[counts[digit]++] = src[i];
+    }
+
+    RenderCommand *tmp = src;
+    src = dst;
+    dst = tmp;
+  }
+
+  // Odd number of passes. Swap buffers instead of copying back
+  if (src != self->sorted.data.ptr) {
+    const size_t capacity = self->sorted.data.len;
+    self->sorted.data.ptr = self->scratch.data.ptr;
+    self->sorted.data.len = self->scratch.data.len;
+    self->scratch.data.ptr = dst;
+    self->scratch.data.len = capacity;
+  }
+}
+
+/*
+ * SUBMISSION
+ */
+
+static void RenderList_submitRects(RenderList *self, SDL_Renderer *renderer,
+                                   const RenderCommand *commands,
+                                   size_t count) {
+  Stack_clear(self->batch_rects);
+  Stack_reserve(self->batch_rects, count);
+  for (size_t i = 0; i < count; i++) {
+    const RenderShard *shard = &self->shards.ptr[commands[i].shard];
+    self->batch_rects.data.ptr[i] = shard->rects.data.ptr[commands[i].geometry];
+  }
+  self->batch_rects.len = count;
+
+  SDL_RenderFillRects(renderer, self->batch_rects.data.ptr, (int)count);
+  self->stats.draw_calls++;
+}
+
+static void RenderList_submitGeometry(RenderList *self, SDL_Renderer *renderer,
+                                      SDL_Texture *texture,
+                                      const RenderCommand *commands,
+                                      size_t count) {
+  Stack_clear(self->batch_vertices);
+  Stack_clear(self->batch_indices);
+
+  for (size_t i = 0; i < count; i++) {
+    const RenderShard *shard = &self->shards.ptr[commands[i].shard];
+    const RenderGeometry *geometry =
+        &shard->geometry.data.ptr[commands[i].geometry];
+
+    const size_t base = self->batch_vertices.len;
+    Stack_reserve(self->batch_vertices, base + geometry->vertex_count);
+    memcpy(&self->batch_vertices.data.ptr[base],
+           &shard->vertices.data.ptr[geometry->first_vertex],
+           geometry->vertex_count * sizeof(SDL_Vertex));
+    self->batch_vertices.len += geometry->vertex_count;
+
+    // Indices are relative to their own geometry. Rebase them onto the batch
+    const size_t index_base = self->batch_indices.len;
+    Stack_reserve(self->batch_indices, index_base + geometry->index_count);
+    for (size_t j = 0; j < geometry->index_count; j++) {
+      self->batch_indices.data.ptr[index_base + j] =
+          shard->indices.data.ptr[geometry->first_index + j] + (int)base;
+    }
+    self->batch_indices.len += geometry->index_count;
+  }
+
+  if (!SDL_RenderGeometry(renderer, texture, self->batch_vertices.data.ptr,
+                          (int)self->batch_vertices.len,
+                          self->batch_indices.data.ptr,
+                          (int)self->batch_indices.len)) {
+    trace("SDL_GetError(): %s", SDL_GetError());
+  }
+  self->stats.draw_calls++;
+}
+
+static void RenderList_submitTextures(RenderList *self, SDL_Renderer *renderer,
+                                      SDL_Texture *texture,
+                                      const RenderCommand *commands,
+                                      size_t count) {
+  for (size_t i = 0; i < count; i++) {
+    const RenderShard *shard = &self->shards.ptr[commands[i].shard];
+    const SDL_FRect *src = &shard->rects.data.ptr[commands[i].geometry];
+    const SDL_FRect *dst = src + 1;
+    SDL_RenderTexture(renderer, texture, src->w < 0 ? NULL : src, dst);
+    self->stats.draw_calls++;
+  }
+}
+
+void RenderList_submit(RenderList *self, SDL_Renderer *renderer) {
+  debugAssert(self != NULL, "self == NULL");
+
+  const RenderCommand *commands = self->sorted.data.ptr;
+  const size_t total = self->sorted.len;
+
+  bool has_color = false;
+  Uint32 current_color = 0;
+
+  size_t start = 0;
+  while (start < total) {
+    // Equal keys share every piece of renderer state and become one batch
+    const Uint64 key = commands[start].key;
+    size_t end = start + 1;
+    while (end < total && commands[end].key == key) {
+      end++;
+    }
+
+    SDL_Texture *texture =
+        RenderList_getTexture(self, RenderKey_getTexture(key));
+
+    switch (RenderKey_getKind(key)) {
+    case RENDER_FILL_RECT: {
+      const Uint32 color = RenderKey_getColor(key);
+      if (!has_color || color != current_color) {
+        SDL_SetRenderDrawColor(renderer, color >> 24, (color >> 16) & 0xFF,
+                               (color >> 8) & 0xFF, color & 0xFF);
+        current_color = color;
+        has_color = true;
+        self->stats.state_changes++;
+      }
+      RenderList_submitRects(self, renderer, &commands[start], end - start);
+      break;
+    }
+    case RENDER_GEOMETRY:
+      RenderList_submitGeometry(self, renderer, texture, &commands[start],
+                                end - start);
+      break;
+    case RENDER_TEXTURE:
+      RenderList_submitTextures(self, renderer, texture, &commands[start],
+                                end - start);
+      break;
+    }
+
+    start = end;
+  }
+}
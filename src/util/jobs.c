@@ -0,0 +1,163 @@
+/*
+    Worker Thread Job Pool Implementation
+    Copyright (C) 2025  Ashton Warner
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "util/jobs.h"
+#include "debug/debug.h"
+
+typedef struct JobWorker {
+  JobPool *pool;
+  size_t id;
+} JobWorker;
+
+// Pulls jobs until the current batch is exhausted.
+// Expects `self->mutex` to be locked and returns with it locked.
+static void JobPool_drain(JobPool *self, size_t worker) {
+  while (self->next_job < self->job_count) {
+    const size_t index = self->next_job++;
+    SDL_UnlockMutex(self->mutex);
+
+    self->fn(self->data, index, worker);
+
+    SDL_LockMutex(self->mutex);
+    self->finished_jobs++;
+  }
+  if (self->finished_jobs == self->job_count) {
+    SDL_BroadcastCondition(self->done);
+  }
+}
+
+static int JobPool_workerMain(JobWorker *worker) {
+  JobPool *self = worker->pool;
+  const size_t id = worker->id;
+  freePtr(&std_allocator, worker);
+
+  size_t seen_generation = 0;
+
+  SDL_LockMutex(self->mutex);
+  while (true) {
+    while (self->running && self->generation == seen_generation) {
+      SDL_WaitCondition(self->wake, self->mutex);
+    }
+    if (!self->running)
+      break;
+
+    seen_generation = self->generation;
+    JobPool_drain(self, id);
+  }
+  SDL_UnlockMutex(self->mutex);
+  return 0;
+}
+
+JobPool *JobPool_create(Allocator *allocator, size_t worker_count) {
+  JobPool *self = allocPtr(allocator, sizeof(JobPool), 1);
+  *self = (JobPool){
+      .allocator = allocator,
+      .worker_count = 0,
+      .workers = NULL,
+      .mutex = SDL_CreateMutex(),
+      .wake = SDL_CreateCondition(),
+      .done = SDL_CreateCondition(),
+      .fn = NULL,
+      .data = NULL,
+      .job_count = 0,
+      .next_job = 0,
+      .finished_jobs = 0,
+      .generation = 0,
+      .running = true,
+  };
+
+  if (worker_count == 0)
+    return self;
+
+  self->workers = allocPtr(allocator, sizeof(SDL_Thread *), worker_count);
+  for (size_t i = 0; i < worker_count; i++) {
+    // Worker ids start at 1. The thread calling `JobPool_run` is worker 0
+    JobWorker *worker = allocPtr(&std_allocator, sizeof(JobWorker), 1);
+    *worker = (JobWorker){.pool = self, .id = i + 1};
+
+    SDL_Thread *thread = SDL_CreateThread(
+        (SDL_ThreadFunction)JobPool_workerMain, "Job Worker", worker);
+    if (thread == NULL) {
+      SDL_Log("Failed to create Job Worker Thread: %s", SDL_GetError());
+      freePtr(&std_allocator, worker);
+      break;
+    }
+    self->workers[self->worker_count++] = thread;
+  }
+  return self;
+}
+
+size_t JobPool_getThreadCount(const JobPool *self) {
+  debugAssert(self != NULL, "self == NULL");
+  return self->worker_count + 1;
+}
+
+void JobPool_run(JobPool *self, JobFn fn, void *data, size_t count) {
+  debugAssert(self != NULL, "self == NULL");
+  debugAssert(fn != NULL, "fn == NULL");
+  if (count == 0)
+    return;
+
+  // Nothing to hand out. Skip the locking entirely
+  if (self->worker_count == 0 || count == 1) {
+    for (size_t i = 0; i < count; i++) {
+      fn(data, i, 0);
+    }
+    return;
+  }
+
+  SDL_LockMutex(self->mutex);
+  self->fn = fn;
+  self->data = data;
+  self->job_count = count;
+  self->next_job = 0;
+  self->finished_jobs = 0;
+  self->generation++;
+  SDL_BroadcastCondition(self->wake);
+
+  JobPool_drain(self, 0);
+  while (self->finished_jobs < self->job_count) {
+    SDL_WaitCondition(self->done, self->mutex);
+  }
+
+  self->fn = NULL;
+  self->data = NULL;
+  SDL_UnlockMutex(self->mutex);
+}
+
+void JobPool_destroy(JobPool *self) {
+  debugAssert(self != NULL, "self == NULL");
+
+  SDL_LockMutex(self->mutex);
+  self->running = false;
+  SDL_BroadcastCondition(self->wake);
+  SDL_UnlockMutex(self->mutex);
+
+  for (size_t i = 0; i < self->worker_count; i++) {
+    SDL_WaitThread(self->workers[i], NULL);
+  }
+  if (self->workers != NULL) {
+    freePtr(self->allocator, self->workers);
+  }
+
+  SDL_DestroyCondition(self->done);
+  SDL_DestroyCondition(self->wake);
+  SDL_DestroyMutex(self->mutex);
+
+  freePtr(self->allocator, self);
+}